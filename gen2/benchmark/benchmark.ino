@@ -0,0 +1,307 @@
+/**
+ * Interactive: building up to Beaker Interactive
+ * File: benchmark.ino
+ * Description: inventory benchmark across Gen2 settings, CSV over Serial
+ *
+ * Author: Isai Sanchez (library written by paulvha)
+ * Board used: Waveshare's ESP32-S3-ETH module
+ * Notes:
+ * - Sweeps every combination of the SWEEP_* tables below (session, target,
+ *   initial Q, RF mode, read power). Each configuration is applied with
+ *   applyProfile() and scanned SCANS_PER_CONFIG times with the same
+ *   continuous read the gen2 sketch uses.
+ * - A scan ends when all expected pucks were seen or after SCAN_WINDOW_MS,
+ *   so time-to-all-tags is only measured on complete scans; the recall
+ *   column shows how often that happened.
+ * - Between scans the reader rests SCAN_REST_MS so S1 flags decay and every
+ *   scan starts from the same tag state. S2 / S3 persist far longer than
+ *   any reasonable rest: read their rows as "repeat scan" numbers.
+ * - `src` is a link to ../src, the same library the gen2 sketch uses.
+ * - Output (one row per configuration, after a '#' commented header):
+ *     session,target,q,rfmode,power,scans,complete,recall_pct,
+ *     t50_ms,t90_ms,tmax_ms,first_ms,reads_per_s,unique_other,err_pct
+ *   target is 0 = A, 1 = B, 2 = AB, 3 = BA and rfmode the TMR_GEN2_RFMODE_
+ *   code (244 = 250 kHz / M4 / 20 us).
+ *   Send 'r' to run the sweep again.
+ *
+ * (c) Thanksgiving Point Exhibits Electronics Team — 2025
+*/
+
+#include "src/SparkFun_UHF_RFID_Reader.h"
+#include "src/EpcTable.h"
+#include "src/EpcRegistry.h"
+#include "src/ScanEngine.h"
+
+// ===== HARDWARE CONFIG =====
+#define RFID_REGION REGION_NORTHAMERICA
+
+constexpr uint32_t RFID_BAUD = 115200;       // Module power-on default, the link starts here
+constexpr long RFID_MAX_BAUD = 921600;       // negotiateBaud() goes as high as this
+constexpr size_t RFID_UART_RX_BUFFER = 2048;  // default 256 B overflows in ~20 ms of streaming
+constexpr uint8_t RXD1 = 18;  // ESP32-S3 RX ← M7E TXO
+constexpr uint8_t TXD1 = 17;  // ESP32-S3 TX → M7E RXI
+
+// ===== BENCHMARK CONFIG =====
+constexpr uint8_t SCANS_PER_CONFIG = 10;
+constexpr uint32_t SCAN_WINDOW_MS = 1000;  // a scan that has not found every puck by now is incomplete
+constexpr uint32_t SCAN_REST_MS = 2000;    // between scans, longer than the S1 flag persistence
+constexpr uint16_t READ_CYCLE_MS = 250;    // Module search cycle
+constexpr uint16_t TAG_TABLE_SLOTS = 32;
+
+// ===== SWEEP =====
+// Every combination is run: rows = product of the table sizes
+static const TMR_GEN2_Session SWEEP_SESSION[] = { TMR_GEN2_SESSION_S0, TMR_GEN2_SESSION_S1 };
+static const TMR_GEN2_Target SWEEP_TARGET[] = { TMR_GEN2_TARGET_A, TMR_GEN2_TARGET_AB };
+static const uint8_t SWEEP_Q_INIT[] = { 2, 4 };  // dynamic Q, initial value
+static const TMR_GEN2_RFMode SWEEP_RFMODE[] = { TMR_GEN2_RFMODE_250_M4_20, TMR_GEN2_RFMODE_160_M8_20, TMR_GEN2_RFMODE_640_M2_7_5 };
+static const int16_t SWEEP_POWER[] = { 1500, 2000, 2500 };  // centi-dBm
+
+#define SWEEP_LEN(a) (sizeof(a) / sizeof(a[0]))
+
+constexpr uint16_t SWEEP_CONFIGS = SWEEP_LEN(SWEEP_SESSION) * SWEEP_LEN(SWEEP_TARGET) * SWEEP_LEN(SWEEP_Q_INIT) * SWEEP_LEN(SWEEP_RFMODE) * SWEEP_LEN(SWEEP_POWER);
+
+// ===== EXPECTED TAGS =====
+// The population every scan should find (the beaker pucks)
+struct ExpectedTag {
+  uint8_t epc[EPC_REGISTRY_EPC_BYTES];
+};
+
+static constexpr ExpectedTag EXPECTED_TAGS[] = {
+  { { 0xE2, 0x80, 0x68, 0x94, 0x00, 0x00, 0x40, 0x33, 0x56, 0x39, 0x29, 0x0A } },
+  { { 0xE2, 0x80, 0x68, 0x94, 0x00, 0x00, 0x40, 0x33, 0x56, 0x38, 0xED, 0x0A } },
+  { { 0xE2, 0x80, 0x68, 0x94, 0x00, 0x00, 0x50, 0x33, 0x56, 0x39, 0x2D, 0x0A } },
+  { { 0xE2, 0x80, 0x68, 0x94, 0x00, 0x00, 0x50, 0x33, 0x56, 0x38, 0xF1, 0x0A } },
+};
+
+constexpr uint8_t NUM_EXPECTED = sizeof(EXPECTED_TAGS) / sizeof(EXPECTED_TAGS[0]);
+
+static constexpr EpcRegistry<ExpectedTag, NUM_EXPECTED> expected(EXPECTED_TAGS);
+static_assert(expected.valid(), "two expected tags share an EPC");
+
+// every expected tag or the deadline, nothing else
+static const ScanCriteria SCAN_CRITERIA = {
+  NUM_EXPECTED,    // expectedTags
+  0,               // quietRounds
+  0,               // quietMs
+  0,               // maxKeepAlives
+  0,               // minScanMs
+  SCAN_WINDOW_MS,  // deadlineMs
+};
+
+const ContinuousReadConfig READ_CONFIG = ContinuousReadConfig()
+                                           .metadata(TMR_TRD_METADATA_FLAG_RSSI | TMR_TRD_METADATA_FLAG_ANTENNAID)
+                                           .onTime(READ_CYCLE_MS)
+                                           .temperatureStats(false);
+
+// ===== RESULTS =====
+struct ScanResult {
+  bool complete;         // every expected tag seen
+  uint8_t expectedSeen;
+  uint8_t otherTags;     // unique EPCs that are not expected
+  uint32_t allFoundMs;   // ms to the last expected tag (complete scans)
+  uint32_t firstReadMs;  // ms from startReading() to the first read
+  uint32_t elapsedMs;
+  uint32_t reads;
+  uint32_t frames;
+  uint32_t errors;       // CRC errors + corrupt records + dropped records
+};
+
+ScanResult results[SCANS_PER_CONFIG];
+EpcTable<TAG_TABLE_SLOTS> tagInventory;
+ScanEngine scanEngine(SCAN_CRITERIA);
+
+RFID rfidModule;
+
+// ─── Module Initialization ──────────────────────────────────────────────────
+bool initializeModule() {
+  rfidModule.begin(Serial1, ThingMagic_M7E_HECTO);
+
+  long baud = rfidModule.negotiateBaud(RFID_MAX_BAUD);
+  if (baud == 0) {
+    return false;
+  }
+  Serial.print(F("# link "));
+  Serial.print(baud);
+  Serial.println(F(" baud"));
+
+  return true;
+}
+
+// ─── One Configuration ──────────────────────────────────────────────────────
+// Decode a sweep index into a profile, last table varies fastest
+ReaderProfile sweepProfile(uint16_t index) {
+  ReaderProfile profile;
+
+  profile.region = RFID_REGION;
+  profile.qType = TMR_SR_GEN2_Q_DYNAMIC;
+
+  profile.readPower = SWEEP_POWER[index % SWEEP_LEN(SWEEP_POWER)];
+  index /= SWEEP_LEN(SWEEP_POWER);
+  profile.rfMode = SWEEP_RFMODE[index % SWEEP_LEN(SWEEP_RFMODE)];
+  index /= SWEEP_LEN(SWEEP_RFMODE);
+  profile.qInit = SWEEP_Q_INIT[index % SWEEP_LEN(SWEEP_Q_INIT)];
+  index /= SWEEP_LEN(SWEEP_Q_INIT);
+  profile.target = SWEEP_TARGET[index % SWEEP_LEN(SWEEP_TARGET)];
+  index /= SWEEP_LEN(SWEEP_TARGET);
+  profile.session = SWEEP_SESSION[index % SWEEP_LEN(SWEEP_SESSION)];
+
+  return profile;
+}
+
+bool runScan(ScanResult &result) {
+  memset(&result, 0, sizeof(result));
+  tagInventory.clear();
+  rfidModule.resetStats();
+
+  if (!rfidModule.startBackgroundReading(READ_CONFIG)) {
+    return false;
+  }
+
+  scanEngine.begin(millis());
+  while (scanEngine.poll(millis()) == SCAN_RUNNING) {
+    StreamedTag rec;
+
+    while (rfidModule.readStreamedTag(rec)) {
+      if (rec.type != RESPONSE_IS_TAGFOUND) continue;
+
+      bool isNew;
+      EpcStats *tag = tagInventory.record(rec.epc, rec.epcLen, rec.rssi, rec.antenna, rec.ms, &isNew);
+      if (tag == NULL || !isNew) continue;
+
+      bool isExpected = expected.match(tag->epc, tag->epcLen) >= 0;
+      if (!isExpected) result.otherTags++;
+      scanEngine.tagRead(true, isExpected, rec.ms);
+    }
+
+    delay(1);
+  }
+
+  result.elapsedMs = scanEngine.elapsed(millis());
+  rfidModule.stopBackgroundReading();
+
+  RFIDStats stats;
+  rfidModule.getStats(stats);
+
+  result.expectedSeen = scanEngine.expectedSeen();
+  result.complete = scanEngine.reason() == SCAN_STOP_ALL_FOUND;
+  result.allFoundMs = result.complete ? result.elapsedMs : 0;
+  result.firstReadMs = stats.firstReadMs;
+  result.reads = stats.tagReads;
+  result.frames = stats.framesReceived;
+  result.errors = stats.crcErrors + stats.corruptRecords + rfidModule.streamedTagsDropped();
+
+  return true;
+}
+
+// p-th percentile (0-100) of the sorted values, nearest rank
+uint32_t percentile(const uint32_t *sorted, uint8_t count, uint8_t p) {
+  if (count == 0) return 0;
+  uint16_t rank = ((uint16_t)p * count + 99) / 100;
+  return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+void printRow(const ReaderProfile &profile, uint8_t scans) {
+  uint32_t times[SCANS_PER_CONFIG];
+  uint8_t complete = 0;
+  uint32_t expectedSeen = 0, other = 0, first = 0, reads = 0, elapsed = 0, frames = 0, errors = 0;
+
+  for (uint8_t i = 0; i < scans; i++) {
+    const ScanResult &r = results[i];
+    if (r.complete) times[complete++] = r.allFoundMs;
+    expectedSeen += r.expectedSeen;
+    other += r.otherTags;
+    first += r.firstReadMs;
+    reads += r.reads;
+    elapsed += r.elapsedMs;
+    frames += r.frames;
+    errors += r.errors;
+  }
+
+  // insertion sort, SCANS_PER_CONFIG values at most
+  for (uint8_t i = 1; i < complete; i++) {
+    uint32_t t = times[i];
+    uint8_t j = i;
+    for (; j > 0 && times[j - 1] > t; j--) times[j] = times[j - 1];
+    times[j] = t;
+  }
+
+  char row[160];
+  snprintf(row, sizeof(row), "S%u,%u,%u,%u,%d,%u,%u,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu.%02lu",
+           (unsigned)profile.session, (unsigned)profile.target, (unsigned)profile.qInit,
+           (unsigned)profile.rfMode, profile.readPower, (unsigned)scans, (unsigned)complete,
+           scans ? (unsigned long)(expectedSeen * 100 / ((uint32_t)scans * NUM_EXPECTED)) : 0UL,
+           (unsigned long)percentile(times, complete, 50),
+           (unsigned long)percentile(times, complete, 90),
+           (unsigned long)percentile(times, complete, 100),
+           scans ? (unsigned long)(first / scans) : 0UL,
+           elapsed ? (unsigned long)((uint64_t)reads * 1000 / elapsed) : 0UL,
+           (unsigned long)other,
+           frames ? (unsigned long)(errors * 100 / frames) : 0UL,
+           frames ? (unsigned long)(errors * 10000 / frames % 100) : 0UL);
+  Serial.println(row);
+}
+
+// ─── Sweep ──────────────────────────────────────────────────────────────────
+void runSweep() {
+  Serial.print(F("# "));
+  Serial.print(SWEEP_CONFIGS);
+  Serial.print(F(" configurations x "));
+  Serial.print(SCANS_PER_CONFIG);
+  Serial.print(F(" scans, window "));
+  Serial.print(SCAN_WINDOW_MS);
+  Serial.print(F(" ms, rest "));
+  Serial.print(SCAN_REST_MS);
+  Serial.println(F(" ms"));
+  Serial.println(F("session,target,q,rfmode,power,scans,complete,recall_pct,t50_ms,t90_ms,tmax_ms,first_ms,reads_per_s,unique_other,err_pct"));
+
+  for (uint16_t c = 0; c < SWEEP_CONFIGS; c++) {
+    ReaderProfile profile = sweepProfile(c);
+
+    if (rfidModule.applyProfile(profile) != 0) {
+      Serial.print(F("# config "));
+      Serial.print(c);
+      Serial.println(F(" rejected by the module, skipped"));
+      continue;
+    }
+
+    uint8_t scans = 0;
+    for (uint8_t s = 0; s < SCANS_PER_CONFIG; s++) {
+      delay(SCAN_REST_MS);
+      if (!runScan(results[scans])) break;
+      scans++;
+    }
+
+    printRow(profile, scans);
+  }
+
+  Serial.println(F("# done, send 'r' to run again"));
+}
+
+/*
+* =======================
+*         MAIN
+* =======================
+*/
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) { delay(10); }
+
+  Serial.println(F("# Gen2 inventory benchmark"));
+
+  Serial1.setRxBufferSize(RFID_UART_RX_BUFFER);
+  Serial1.begin(RFID_BAUD, SERIAL_8N1, RXD1, TXD1);
+
+  if (!initializeModule()) {
+    Serial.println(F("# FATAL: RFID module not responding. Check wiring and power."));
+    while (1) { delay(1000); }
+  }
+
+  runSweep();
+}
+
+void loop() {
+  if (Serial.available() && Serial.read() == 'r') {
+    runSweep();
+  }
+}
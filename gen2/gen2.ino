@@ -13,7 +13,15 @@
  *   -- Dynamic Q=2  → starts with 4 slots, auto-adjusts for population
  * - Approach:
  *   -- On button press → open a collection window → accumulate unique EPCs
- *    via check()/parseResponse() → match against known puck EPCs → light LEDs.
+ *    from the library's reader task (core 0) → match against known puck EPCs
+ *    → light LEDs. The puck combination goes out to the BrightSign as a UDP
+ *    command as soon as it settles, before the scan is over.
+ *   -- PRESENCE_MODE (no button): the reader runs all the time and
+ *    PresenceTracker lights a puck's LED when it arrives in the beaker and
+ *    turns it off when it leaves. ThermalScheduler adds RF off time (then
+ *    lowers power) as the module warms up, so it never gets to throttle.
+ *   -- Every read goes into a binary scan log (RAM/PSRAM ring) that is sent
+ *    to a log host in UDP batches after each scan, see src/ScanLog.h.
  * - Uncompatibility:
  *   -- readTagEPC()/readData() uses an 8-byte command format that may be 
  *    incompatible with the M7E Hecto (SparkFun's M7E update added 3 required 
@@ -28,11 +36,28 @@
 */
 
 #include "src/SparkFun_UHF_RFID_Reader.h"
+#include "src/EpcTable.h"
+#include "src/EpcRegistry.h"
+#include "src/ScanEngine.h"
+#include "src/AntennaScheduler.h"
+#include "src/PowerController.h"
+#include "src/Gen2Tuner.h"
+#include "src/PresenceTracker.h"
+#include "src/ThermalScheduler.h"
+#include "src/ComboTable.h"
+#include "src/ComboDispatcher.h"
+#include "src/ScanLog.h"
+#include "src/ZoneClassifier.h"
+#include <Preferences.h>
+#include <ETH.h>
+#include <NetworkUdp.h>
 
 // ===== HARDWARE CONFIG =====
 #define RFID_REGION REGION_NORTHAMERICA
 
-constexpr uint32_t RFID_BAUD = 115200;
+constexpr uint32_t RFID_BAUD = 115200;       // Module power-on default, the link starts here
+constexpr long RFID_MAX_BAUD = 921600;       // negotiateBaud() goes as high as this
+constexpr size_t RFID_UART_RX_BUFFER = 2048;  // default 256 B overflows in ~20 ms of streaming
 constexpr uint8_t RXD1 = 18;  // ESP32-S3 RX ← M7E TXO
 constexpr uint8_t TXD1 = 17;  // ESP32-S3 TX → M7E RXI
 constexpr uint8_t PIN_LED_YELLOW = 1;
@@ -42,58 +67,292 @@ constexpr uint8_t PIN_LED_RED = 15;
 constexpr uint8_t BUTTON_PIN = 48;
 const uint32_t BUTTON_DEBOUNCE_MS = 250;
 
+// ===== ETHERNET (W5500 on the ESP32-S3-ETH) =====
+// Direct cable to the BrightSign, static addresses on both ends
+constexpr int8_t ETH_MISO = 12;
+constexpr int8_t ETH_MOSI = 11;
+constexpr int8_t ETH_SCLK = 13;
+constexpr int8_t ETH_CS = 14;
+constexpr int8_t ETH_INT = 10;
+constexpr int8_t ETH_RST = 9;
+const IPAddress LOCAL_IP(192, 168, 10, 2);
+const IPAddress BRIGHTSIGN_IP(192, 168, 10, 10);
+const IPAddress SUBNET(255, 255, 255, 0);
+constexpr uint16_t BRIGHTSIGN_UDP_PORT = 5000;  // BrightSign UDP input default
+const IPAddress LOG_HOST_IP(192, 168, 10, 1);   // collects the scan log, see host/scanlog_decode.py
+constexpr uint16_t LOG_HOST_UDP_PORT = 5010;
+
+NetworkUDP udp;
+
 // ----- INTERRUPT VARs -----
 volatile bool pressed = false;
 volatile unsigned long lastPressTime = 0;
 
 // ===== RFID SCAN CONFIG =====
-constexpr uint8_t MAX_TAGS = 10;           // Maximum unique tags to track
-constexpr uint8_t EPC_MAX_BYTES = 12;      // Standard EPC length (96 bits)
-constexpr uint32_t SCAN_WINDOW_MS = 500;   // How long to collect tags after trigger (ms)
-constexpr uint32_t READ_POWER = 1500;      // adjust during testing (ex 1500 = 15.00 dBm)
+constexpr uint16_t TAG_TABLE_SLOTS = 32;   // EpcTable slots (power of 2), tracks up to 3/4 of this
+constexpr uint32_t SCAN_WINDOW_MS = 500;   // Hard limit on collecting tags after trigger (ms)
+constexpr uint16_t SCAN_QUIET_MS = 150;    // Stop early once no new tag appeared for this long
+constexpr uint8_t SCAN_QUIET_ROUNDS = 2;   // ... or after this many empty inventory rounds
+constexpr uint16_t SCAN_MIN_MS = 60;       // Quiet rules don't apply before this
+constexpr uint16_t READ_CYCLE_MS = 250;    // Module search cycle (one keep-alive per empty cycle)
+constexpr uint32_t READ_POWER = 1500;      // starting read power (ex 1500 = 15.00 dBm)
 constexpr uint32_t LED_DISPLAY_MS = 3000;  // How long LEDs stay lit after a scan
+constexpr uint16_t COMBO_SETTLE_MS = 80;   // Combination unchanged this long → send its action
+constexpr bool READ_PUCK_ID = false;       // Read each puck's ID word with the inventory (provisioned pucks)
+constexpr uint8_t PUCK_ID_WORD = 0;        // User memory word holding the puck ID
+constexpr bool PRESENCE_MODE = false;      // No button: read continuously, LEDs follow the pucks
+constexpr bool SCAN_LOG = true;            // Binary record per read to the log host (adds frequency + phase to the records)
+constexpr bool PRINT_NEW_TAGS = false;     // Serial line per new tag during the scan (slow at 115200)
+constexpr bool ZONE_FILTER = false;        // A puck counts once its RSSI and phase place it in the beaker (calibrate first: i / o)
+constexpr uint32_t ZONE_SCAN_WINDOW_MS = 2000;  // ZONE_FILTER: longer scans, enough channels per puck for the phase
+constexpr uint32_t ZONE_HOP_TIME_MS = 50;       // ZONE_FILTER: time per channel (~40 channels in the window)
+
+// ===== MODULE PROFILE =====
+// Session S1  → tag flags persist ~500ms-5s, suppressing re-reads
+//               (S0 with ZONE_FILTER: every puck answers on every channel)
+// Target AB   → inventory A until exhausted, then B, then repeat
+// Dynamic Q=3 → starts with 8 slots, auto-adjusts for population
+//               (Gen2Tuner resizes Q and target after each scan)
+static const ReaderProfile READER_PROFILE = {
+  RFID_REGION,
+  READ_POWER,
+  ZONE_FILTER ? TMR_GEN2_SESSION_S0 : TMR_GEN2_SESSION_S1,
+  TMR_GEN2_TARGET_AB,
+  TMR_SR_GEN2_Q_DYNAMIC,
+  3,                          // initial Q
+  TMR_GEN2_RFMODE_250_M4_20,  // 250 kHz BLF / Miller 4 / 20 us Tari
+};
+
+// ===== KNOWN PUCKS =====
+// Declared once; EpcRegistry works out at compile time which EPC bytes tell
+// the pucks apart (byte 10 for the current set) and builds the lookup on them
+struct PuckDef {
+  uint8_t epc[EPC_REGISTRY_EPC_BYTES];
+  uint8_t ledPin;
+  const char *name;
+  uint8_t comboId;  // bit position in the combo mask
+  uint16_t id;      // in user memory at PUCK_ID_WORD, index + 1
+};
 
-// ===== KNOWN PUCK EPCs =====
-constexpr uint8_t NUM_PUCKS = 4;
-constexpr uint8_t EPC_LENGTH = 12;
-static const uint8_t PUCK_EPC_YELLOW[EPC_LENGTH] = {
-  0xE2, 0x80, 0x68, 0x94, 0x00, 0x00, 0x40, 0x33, 0x56, 0x39, 0x29, 0x0A
+static constexpr PuckDef PUCK_DEFS[] = {
+  { { 0xE2, 0x80, 0x68, 0x94, 0x00, 0x00, 0x40, 0x33, 0x56, 0x39, 0x29, 0x0A }, PIN_LED_YELLOW, "Yellow", 0, 1 },
+  { { 0xE2, 0x80, 0x68, 0x94, 0x00, 0x00, 0x40, 0x33, 0x56, 0x38, 0xED, 0x0A }, PIN_LED_BLUE, "Blue", 1, 2 },
+  { { 0xE2, 0x80, 0x68, 0x94, 0x00, 0x00, 0x50, 0x33, 0x56, 0x39, 0x2D, 0x0A }, PIN_LED_GREEN, "Green", 2, 3 },
+  { { 0xE2, 0x80, 0x68, 0x94, 0x00, 0x00, 0x50, 0x33, 0x56, 0x38, 0xF1, 0x0A }, PIN_LED_RED, "Red", 3, 4 },
 };
-static const uint8_t PUCK_EPC_BLUE[EPC_LENGTH] = {
-  0xE2, 0x80, 0x68, 0x94, 0x00, 0x00, 0x40, 0x33, 0x56, 0x38, 0xED, 0x0A
+
+constexpr uint8_t NUM_PUCKS = sizeof(PUCK_DEFS) / sizeof(PUCK_DEFS[0]);
+
+static constexpr EpcRegistry<PuckDef, NUM_PUCKS> pucks(PUCK_DEFS);
+static_assert(pucks.valid(), "two pucks share an EPC");
+
+// Puck IDs are dense, so the ID read from the tag is the index plus one
+constexpr bool puckIdsDense(uint8_t i = 0) {
+  return (i == NUM_PUCKS || (PUCK_DEFS[i].id == i + 1 && puckIdsDense(i + 1)));
+}
+static_assert(puckIdsDense(), "puck IDs must be 1..NUM_PUCKS in PUCK_DEFS order");
+
+int puckIndexById(uint32_t id) {
+  return (id >= 1 && id <= NUM_PUCKS ? (int)id - 1 : -1);
+}
+
+bool puckDetected[NUM_PUCKS];
+
+// ===== COMBINATIONS =====
+// One bit per puck (comboId) → the command the BrightSign plays for it.
+// ComboTable resolves a mask with one array index
+struct ComboAction {
+  uint32_t mask;
+  const char *command;  // sent as the UDP payload
 };
-static const uint8_t PUCK_EPC_GREEN[EPC_LENGTH] = {
-  0xE2, 0x80, 0x68, 0x94, 0x00, 0x00, 0x50, 0x33, 0x56, 0x39, 0x2D, 0x0A
+
+constexpr uint32_t comboBit(uint8_t puck) {
+  return 1UL << PUCK_DEFS[puck].comboId;
+}
+
+static constexpr ComboAction COMBO_ACTIONS[] = {
+  { 0, "idle" },
+  { comboBit(0) | comboBit(1) | comboBit(2), "combo_yellow_blue_green" },
+  { comboBit(0) | comboBit(1) | comboBit(3), "combo_yellow_blue_red" },
+  { comboBit(0) | comboBit(2) | comboBit(3), "combo_yellow_green_red" },
+  { comboBit(1) | comboBit(2) | comboBit(3), "combo_blue_green_red" },
+  { comboBit(0) | comboBit(1) | comboBit(2) | comboBit(3), "combo_all" },
 };
-static const uint8_t PUCK_EPC_RED[EPC_LENGTH] = {
-  0xE2, 0x80, 0x68, 0x94, 0x00, 0x00, 0x50, 0x33, 0x56, 0x38, 0xF1, 0x0A
+
+constexpr uint8_t NUM_COMBO_ACTIONS = sizeof(COMBO_ACTIONS) / sizeof(COMBO_ACTIONS[0]);
+
+static constexpr ComboTable<ComboAction, NUM_COMBO_ACTIONS, NUM_PUCKS> combos(COMBO_ACTIONS);
+static_assert(combos.valid(), "combo masks must be unique and within the pucks' comboIds");
+
+ComboDispatcher comboDispatcher(COMBO_SETTLE_MS);
+uint32_t presentMask = 0;   // PRESENCE_MODE: pucks in the beaker now
+uint32_t ledsOffMs = 0;     // scan LEDs go off at this millis(), 0 = off
+
+// ===== SCAN LOG =====
+// 16 bytes per read in a ring, sent to the log host in batches after each
+// scan (every SCANLOG_FLUSH_MS while reading). PSRAM holds hours of
+// reads; without it a smaller ring in internal RAM
+constexpr uint32_t SCANLOG_PSRAM_BYTES = 1UL << 20;  // 65536 records
+constexpr uint32_t SCANLOG_RAM_BYTES = 16UL << 10;   // 1024 records
+constexpr uint32_t SCANLOG_FLUSH_MS = 5000;
+
+ScanLog scanLog;
+uint32_t scanNumber = 0;
+uint32_t lastLogFlushMs = 0;
+
+// ===== SCAN STOP RULES =====
+// ZONE_FILTER: a puck in the beaker only counts after reads on several
+// channels, so no quiet time; the scan ends once all pucks are inside
+static const ScanCriteria SCAN_CRITERIA = {
+  NUM_PUCKS,                                       // expectedTags
+  SCAN_QUIET_ROUNDS,                               // quietRounds
+  ZONE_FILTER ? (uint16_t)0 : SCAN_QUIET_MS,       // quietMs
+  0,                                               // maxKeepAlives (not used)
+  SCAN_MIN_MS,                                     // minScanMs
+  ZONE_FILTER ? ZONE_SCAN_WINDOW_MS : SCAN_WINDOW_MS,  // deadlineMs
 };
 
-// ===== PUCK STRUCT =====
-struct PuckConfig {
-  const uint8_t *epc;
-  uint8_t ledPin;
-  const char *name;
-  bool detected;
+ScanEngine scanEngine(SCAN_CRITERIA);
+
+// ===== READ POWER CONTROL =====
+// Between scans: up when a puck is missed or barely heard, down when every
+// puck comes in strong, the module throttles or tags from outside the
+// beaker show up (after a few clean scans, so it doesn't hunt). Missed
+// means gone after the previous scan read it weakly or only once: visitors
+// place any combination, so a puck that is just not there is no miss
+static const PowerPolicy POWER_POLICY = {
+  READ_POWER,  // startPower
+  500,         // minPower   (5.00 dBm)
+  2700,        // maxPower   (27.00 dBm, M7E limit)
+  100,         // step       (1 dB)
+  -70,         // weakRssi   (dBm)
+  -45,         // strongRssi (dBm)
+  3,           // settleScans
 };
 
-static PuckConfig pucks[NUM_PUCKS] = {
-  { PUCK_EPC_YELLOW, PIN_LED_YELLOW, "Yellow", false },
-  { PUCK_EPC_BLUE, PIN_LED_BLUE, "Blue", false },
-  { PUCK_EPC_GREEN, PIN_LED_GREEN, "Green", false },
-  { PUCK_EPC_RED, PIN_LED_RED, "Red", false },
+PowerController powerController(POWER_POLICY);
+constexpr int8_t PUCK_MARGINAL_DB = 6;  // best RSSI below weakRssi + this: barely read
+uint32_t marginalPucks = 0;             // bit per puck, barely read in the last scan
+
+// ===== GEN2 INVENTORY TUNING =====
+// Initial Q, static/dynamic Q and target for the next scan, sized to the
+// population the previous scans found
+static const Gen2TunerPolicy TUNER_POLICY = {
+  1,                  // minTags
+  GEN2_TUNER_Q_MAX,   // maxQ
+  32,                 // singleTargetTags (target A from this many tags)
+  3,                  // stableScans before static Q
 };
 
-// ===== TAG STORAGE =====
-struct DetectedTag {
-  byte epc[EPC_MAX_BYTES];
-  uint8_t epcLen;
-  int8_t rssi;
-  uint32_t lastSeenMs;
+Gen2Tuner gen2Tuner(TUNER_POLICY);
+
+// ===== PRESENCE (PRESENCE_MODE) =====
+// A puck arrives after 2 reads at -65 dBm or better and stays until it has
+// not been read at -72 dBm or better for 1.5 s (6 read cycles); the 7 dB in
+// between keeps a puck at the edge of the beaker from flickering
+static constexpr PresencePolicy PRESENCE_POLICY = {
+  2,      // arriveReads
+  -65,    // arriveRssi (dBm)
+  -72,    // departRssi (dBm)
+  1500,   // departMs
+};
+
+PresenceTracker presence(PRESENCE_POLICY);
+
+// Reading all day: from 60 C up, 50 ms more RF off time per read cycle
+// every 30 s (down to 20% duty), then 1 dB less power; back below 55 C the
+// same steps in reverse. Off time stays under departMs, or a quiet gap
+// would look like every puck leaving
+static constexpr ThermalPolicy THERMAL_POLICY = {
+  READ_CYCLE_MS,  // onTime
+  1000,           // maxOffTime
+  50,             // offStep
+  READ_POWER,     // maxPower
+  1000,           // minPower   (10.00 dBm)
+  100,            // powerStep  (1 dB)
+  60,             // warmTemp (C)
+  55,             // coolTemp (C)
+  30000,          // holdMs
+};
+static_assert(THERMAL_POLICY.maxOffTime < PRESENCE_POLICY.departMs, "off time would depart the pucks");
+
+ThermalScheduler thermal(THERMAL_POLICY);
+uint32_t lastTempPrintMs = 0;
+
+// ===== ZONE FILTER (ZONE_FILTER) =====
+// Pucks lying next to the beaker are read as well at the power that reads
+// every puck inside reliably. A puck counts once it has 4 reads, a mean
+// RSSI above the calibrated threshold and, over 6 channels spanning 3 MHz
+// or more, an apparent range (phase over frequency) in the calibrated
+// window, on everything the scan read of it. During the scan it only
+// stops the scan early, after ZONE_INSIDE_CHECKS reads in a row that place
+// it inside. Calibration over Serial (see README), kept in NVS
+static const ZonePolicy ZONE_POLICY = {
+  4,      // minReads
+  6,      // minChannels
+  3000,   // minSpanKhz
+  3,      // rssiMargin (dB)
+  30,     // rangeMarginCm
 };
+constexpr uint8_t ZONE_CAL_SCANS = 5;   // scans per calibration command
+constexpr uint8_t ZONE_INSIDE_CHECKS = 3;  // INSIDE reads in a row before a puck stops the scan
+#define ZONE_NVS_NAMESPACE "zone"
+
+ZoneClassifier zone(ZONE_POLICY);
+uint8_t zoneInside[NUM_PUCKS];      // INSIDE reads in a row, this scan
+EpcStats *zoneTag[NUM_PUCKS];       // the puck's inventory entry, this scan
+bool calibrating = false;           // calibrateZone(): scans only collect samples
+
+// EPC bytes all pucks start with. The Gen2 Select on them keeps other tags
+// (visitor wristbands, ...) out of the inventory rounds altogether
+static const uint8_t PUCK_EPC_PREFIX[] = { 0xE2, 0x80, 0x68, 0x94, 0x00, 0x00 };
+
+// Only what performScan() uses: RSSI and antenna (~25 byte records instead of ~47),
+// frequency and phase for the scan log and the zone filter, plus the puck ID
+// word with READ_PUCK_ID
+ContinuousReadConfig makeReadConfig() {
+  uint16_t metadata = TMR_TRD_METADATA_FLAG_RSSI | TMR_TRD_METADATA_FLAG_ANTENNAID;
+  if (SCAN_LOG || ZONE_FILTER) metadata |= TMR_TRD_METADATA_FLAG_FREQUENCY | TMR_TRD_METADATA_FLAG_PHASE;
+
+  ContinuousReadConfig cfg;
+  cfg.metadata(metadata)
+    .onTime(READ_CYCLE_MS)
+    .temperatureStats(false)
+    .selectEpcPrefix(PUCK_EPC_PREFIX, sizeof(PUCK_EPC_PREFIX));
+  if (READ_PUCK_ID) cfg.embeddedRead(TMR_GEN2_BANK_USER, PUCK_ID_WORD, 1);
+  return cfg;
+}
+
+const ContinuousReadConfig READ_CONFIG = makeReadConfig();
+
+// PRESENCE_MODE: the same records, with the module temperature and the
+// ThermalScheduler's duty cycle
+ContinuousReadConfig presenceReadConfig() {
+  ContinuousReadConfig cfg = makeReadConfig();
+  cfg.onTime(thermal.onTime()).offTime(thermal.offTime()).temperatureStats(true);
+  return cfg;
+}
+
+// ===== ANTENNAS =====
+// One entry per station: logical port, base dwell (ms), weight. With more
+// than one, the scan runs in slots and AntennaScheduler moves the time to
+// the ports still producing new tags. A single port is read without breaks
+struct AntennaDef {
+  uint8_t port;
+  uint16_t dwellMs;
+  uint8_t weight;
+};
+
+static const AntennaDef ANTENNAS[] = {
+  { 1, SCAN_WINDOW_MS, 1 },
+};
+
+constexpr uint8_t NUM_ANTENNAS = sizeof(ANTENNAS) / sizeof(ANTENNAS[0]);
 
-DetectedTag tagInventory[MAX_TAGS];
-int tagCount = 0;
+AntennaScheduler antennas;
+
+// ===== TAG STORAGE =====
+EpcTable<TAG_TABLE_SLOTS> tagInventory;
 bool readerRunning = false;
 
 RFID rfidModule;
@@ -110,32 +369,21 @@ void IRAM_ATTR buttonISR() {
 // ─── Module Initialization ──────────────────────────────────────────────────
 bool initializeModule() {
   rfidModule.begin(Serial1, ThingMagic_M7E_HECTO);
-  delay(200);
-
-  // Drain any startup noise from the module
-  while (Serial1.available()) { Serial1.read(); }
 
-  // Attempt communication
-  rfidModule.getVersion();
-
-  if (rfidModule.msg[0] == ERROR_WRONG_OPCODE_RESPONSE) {
-    // Module was in continuous read mode from a previous session
-    Serial.println(F("  Module was mid-read, sending stop command..."));
-    rfidModule.stopReading();
-    delay(1500);  // Wait for module to fully stop
-    rfidModule.getVersion();
+  // Find the module (last session's rate is tried first) and move the link
+  // to the fastest rate that verifies
+  long baud = rfidModule.negotiateBaud(RFID_MAX_BAUD);
+  if (baud == 0) {
+    return false;
   }
+  Serial.print(F("  Link: "));
+  Serial.print(baud);
+  Serial.println(F(" baud"));
 
+  // A module left mid-read was already stopped by negotiateBaud()
+  rfidModule.getVersion();
   if (rfidModule.msg[0] != ALL_GOOD) {
-    // Module might be at a different baud rate. Try the most common default.
-    Serial.println(F("  No response at 115200, trying module reset..."));
-    Serial1.begin(115200, SERIAL_8N1, RXD1, TXD1);
-    delay(100);
-    rfidModule.getVersion();
-
-    if (rfidModule.msg[0] != ALL_GOOD) {
-      return false;
-    }
+    return false;
   }
 
   // Print firmware version for diagnostics
@@ -147,38 +395,42 @@ bool initializeModule() {
   }
   Serial.println();
 
-  // Core module configuration (order matters)
+  // Module + Gen2 configuration. Skipped when the module still has the
+  // profile saved by the last boot, otherwise queued and sent back to back
   Serial.println(F("  Configuring module..."));
-  rfidModule.setTagProtocol();        // GEN2 (0x05)
-  rfidModule.setAntennaPort();        // TX=1, RX=1
-  rfidModule.setAntennaSearchList();  // Configure antenna search list
-  rfidModule.setRegion(RFID_REGION);
-  rfidModule.setReadPower(READ_POWER);
-
-  Serial.print(F("  Read power set to "));
+  uint32_t configStart = millis();
+  bool warm;
+  uint8_t failed = rfidModule.warmStart(READER_PROFILE, warm, onConfigResult);
+
+  Serial.print(F("  "));
+  Serial.print(failed == 0 ? (warm ? F("OK (warm)") : F("OK")) : F("FAILED"));
+  Serial.print(F(" in "));
+  Serial.print(millis() - configStart);
+  Serial.print(F(" ms, read power "));
   Serial.print(READ_POWER / 100);
   Serial.print('.');
   Serial.print(READ_POWER % 100);
   Serial.println(F(" dBm"));
 
+  // Not part of the saved profile, so sent on every boot
+  if (ZONE_FILTER) rfidModule.setHopTime(ZONE_HOP_TIME_MS);
+
   return true;
 }
 
-// ─── Gen2 Parameter Configuration ───────────────────────────────────────────
-void configureGen2Parameters() {
-  Serial.println(F("\nConfiguring Gen2 parameters:"));
-
-  Serial.print(F("  Session S1 ......... "));
-  printResult(rfidModule.setGen2Session(TMR_GEN2_SESSION_S1));
-
-  Serial.print(F("  Target AB .......... "));
-  printResult(rfidModule.setGen2Target(TMR_GEN2_TARGET_AB));
+// Called per configuration command, only reports the ones that failed
+void onConfigResult(uint8_t opcode, uint8_t result, uint16_t status, void *ctx) {
+  if (result == ALL_GOOD && status == 0) return;
 
-  Serial.print(F("  Q Dynamic (init=4) . "));
-  printResult(rfidModule.setGen2Q(TMR_SR_GEN2_Q_DYNAMIC, 3, true));
-
-  Serial.print(F("  RFMode 250/M4/20 ... "));
-  printResult(rfidModule.setGen2RFmode(TMR_GEN2_RFMODE_250_M4_20));
+  Serial.print(F("  Command 0x"));
+  Serial.print(opcode, HEX);
+  Serial.print(F(" failed: "));
+  if (result == ALL_GOOD) {
+    Serial.print(F("module status 0x"));
+    Serial.println(status, HEX);
+  } else {
+    Serial.println(result == ERROR_COMMAND_RESPONSE_TIMEOUT ? F("timeout") : F("wrong response"));
+  }
 }
 
 // ─── Multi-Tag Scan (Continuous Read Approach) ──────────────────────────────
@@ -186,135 +438,213 @@ void performScan() {
   Serial.println(F("\n>>> SCANNING <<<\n"));
 
   // Reset tag inventory and puck detection flags
-  tagCount = 0;
-  memset(tagInventory, 0, sizeof(tagInventory));
-  for (int i = 0; i < NUM_PUCKS; i++) {
-    pucks[i].detected = false;
+  tagInventory.clear();
+  ledsOffMs = 0;
+  for (uint8_t i = 0; i < NUM_PUCKS; i++) {
+    puckDetected[i] = false;
     digitalWrite(pucks[i].ledPin, LOW);
   }
 
-  // Start continuous reading — module will stream tag records over UART
-  rfidModule.startReading();
+  // Link counters cover this scan only
+  rfidModule.resetStats();
+  powerController.beginScan();
+  if (ZONE_FILTER) {
+    zone.setReadPower(powerController.power());
+    zone.begin();
+    for (uint8_t i = 0; i < NUM_PUCKS; i++) {
+      zoneInside[i] = 0;
+      zoneTag[i] = NULL;
+    }
+  }
+
+  // First antenna slot (the only one with a single port)
+  antennas.reset();
+  uint16_t dwell;
+  uint8_t port = antennas.next(dwell);
+  if (NUM_ANTENNAS > 1) rfidModule.setAntennaSearchList(&port, 1);
+
+  // Start continuous reading — the reader task on core 0 owns the UART and
+  // queues tag records, so the printing below can't starve the stream
+  if (!rfidModule.startBackgroundReading(READ_CONFIG)) {
+    Serial.println(F("  ERROR: could not start reader task"));
+    return;
+  }
   readerRunning = true;
+  uint32_t slotEnd = millis() + dwell;
 
-  uint32_t scanStart = millis();
-  uint16_t totalReads = 0;
+  scanEngine.begin(millis());
+  scanNumber++;
+  logEvent(SCANLOG_SCAN_BEGIN, scanNumber, millis(), powerController.power() / 100, port << 4 | port, 0, 0, 0);
   uint16_t parseErrors = 0;
+  uint32_t tagReads = 0;
   uint8_t pucksFound = 0;
+  uint32_t comboMask = 0;
+  comboDispatcher.reset();
+
+  // ── Collection window: drain queued records until a stop rule fires ──
+  while (scanEngine.poll(millis()) == SCAN_RUNNING) {
+    StreamedTag rec;
+
+    // Slot over: stop first, so the records below include the last ones
+    bool slotOver = NUM_ANTENNAS > 1 && (int32_t)(millis() - slotEnd) >= 0;
+    if (slotOver) {
+      rfidModule.stopBackgroundReading();
+      readerRunning = false;
+    }
 
-  // ── Collection window: poll for tags until time expires (with early exit if all found) ──
-  while (millis() - scanStart < SCAN_WINDOW_MS) {
-
-    if (rfidModule.check()) {
-
-      uint8_t responseType = rfidModule.parseResponse();
-
-      if (responseType == RESPONSE_IS_TAGFOUND) {
-        totalReads++;
-
-        uint8_t tagDataBytes = rfidModule.getTagDataBytes();
-        uint8_t epcBytes = rfidModule.getTagEPCBytes();
-        int8_t rssi = rfidModule.getTagRSSI();
+    while (rfidModule.readStreamedTag(rec)) {
 
-        if (epcBytes == 0 || epcBytes > EPC_MAX_BYTES) {
+      if (rec.type == RESPONSE_IS_TAGFOUND) {
+        if (rec.epcLen == 0 || rec.epcLen > EPC_TABLE_EPC_BYTES) {
           parseErrors++;
           continue;
         }
+        tagReads++;
+
+        // Provisioned pucks bring their ID, the rest are matched by EPC
+        int puckIdx = rec.dataLen == 2 ? puckIndexById(rec.data) : -1;
+        if (puckIdx < 0) puckIdx = pucks.match(rec.epc, rec.epcLen);
+        if (SCAN_LOG) logTagRead(rec, puckIdx);
+        if (ZONE_FILTER) zone.tagRead(rec.epc, rec.epcLen, rec.rssi, rec.freq, rec.phase);
+
+        // Deduplicate and update the per-tag statistics
+        bool isNew;
+        EpcStats *tag = tagInventory.record(rec.epc, rec.epcLen, rec.rssi, rec.antenna, rec.ms, &isNew);
+        antennas.tagRead(rec.antenna, isNew);
+
+        // A puck counts from its first read. With ZONE_FILTER it counts
+        // after the scan, here it only tells the scan engine it is inside
+        bool counts = puckIdx >= 0 && !puckDetected[puckIdx];
+        bool expected = counts;
+        if (counts && ZONE_FILTER) {
+          if (tag != NULL) zoneTag[puckIdx] = tag;
+          expected = zoneHint(puckIdx, zone.classify(rec.epc, rec.epcLen));
+          counts = false;
+        }
+        if (!isNew && !expected) continue;  // seen before, or table full
 
-        uint8_t epcStartIdx = 31 + tagDataBytes;
-
-        // Deduplicate
-        if (findTagByEPC(&rfidModule.msg[epcStartIdx], epcBytes) >= 0) continue;
-        if (tagCount >= MAX_TAGS) continue;
-
-        // Store new tag
-        DetectedTag *tag = &tagInventory[tagCount];
-        memcpy(tag->epc, &rfidModule.msg[epcStartIdx], epcBytes);
-        tag->epcLen = epcBytes;
-        tag->rssi = rssi;
-        tag->lastSeenMs = millis();
-        tagCount++;
-
-        Serial.print(F("  [NEW] Tag #"));
-        Serial.print(tagCount);
-        Serial.print(F(" | RSSI: "));
-        Serial.print(rssi);
-        Serial.print(F(" dBm | EPC: "));
-        printEPC(tag->epc, tag->epcLen);
-
-        // Check if this is a known puck
-        int puckIdx = matchPuck(tag->epc, tag->epcLen);
-        if (puckIdx >= 0 && !pucks[puckIdx].detected) {
-          pucks[puckIdx].detected = true;
+        scanEngine.tagRead(isNew, expected, rec.ms);
+        if (isNew && puckIdx < 0 && !calibrating) powerController.foreignTag();
+
+        // Known puck? The combination is updated before any printing
+        if (counts) {
+          puckDetected[puckIdx] = true;
+          comboMask |= 1UL << pucks[puckIdx].comboId;
           pucksFound++;
+          comboDispatcher.update(comboMask, rec.ms);
+          if (pucksFound == NUM_PUCKS && comboDispatcher.flush(millis())) sendCombo(comboDispatcher.mask());
+        }
 
-          // All pucks found — no reason to keep scanning
-          if (pucksFound >= NUM_PUCKS) break;
+        // The scan log has every read; this is for watching at the bench
+        if (PRINT_NEW_TAGS && isNew) {
+          Serial.print(F("  [NEW] Tag #"));
+          Serial.print(tagInventory.count());
+          Serial.print(F(" | RSSI: "));
+          Serial.print(rec.rssi);
+          Serial.print(F(" dBm"));
+          if (NUM_ANTENNAS > 1) {
+            Serial.print(F(" | Ant: "));
+            Serial.print(rec.antenna >> 4);
+          }
+          Serial.print(F(" | EPC: "));
+          printEPC(tag->epc, tag->epcLen);
         }
-      } else if (responseType == RESPONSE_IS_TEMPTHROTTLE) {
+      } else if (rec.type == RESPONSE_IS_KEEPALIVE) {
+        scanEngine.keepAlive(rec.ms);
+      } else if (rec.type == RESPONSE_IS_TEMPTHROTTLE) {
         Serial.println(F("  WARNING: Thermal throttling!"));
-      } else if (responseType == ERROR_CORRUPT_RESPONSE) {
-        parseErrors++;
+        logEvent(SCANLOG_THROTTLE, 0, rec.ms, 0, 0, 0, 0, 0);
+        if (!calibrating) powerController.throttled();
       }
     }
 
-    yield();
+    // Every puck there did not move for COMBO_SETTLE_MS: don't wait for the scan to end
+    if (comboDispatcher.poll(millis())) sendCombo(comboDispatcher.mask());
+
+    // Next slot, on whichever port the scheduler picks
+    if (slotOver) {
+      port = antennas.next(dwell);
+      rfidModule.setAntennaSearchList(&port, 1);
+      readerRunning = rfidModule.startBackgroundReading(READ_CONFIG);
+      slotEnd = millis() + dwell;
+    }
+
+    delay(1);
   }
 
-  uint32_t scanElapsed = millis() - scanStart;
+  uint32_t scanElapsed = scanEngine.elapsed(millis());
 
-  // ── Stop continuous reading — fast drain ──
-  rfidModule.stopReading();
-  readerRunning = false;
+  // ZONE_FILTER: the pucks inside on all of the scan's reads count
+  if (ZONE_FILTER) {
+    for (uint8_t i = 0; i < NUM_PUCKS; i++) {
+      if (zoneTag[i] == NULL || zone.classify(zoneTag[i]->epc, zoneTag[i]->epcLen) != ZONE_INSIDE) continue;
+      puckDetected[i] = true;
+      comboMask |= 1UL << pucks[i].comboId;
+      pucksFound++;
+    }
+    if (!calibrating) comboDispatcher.update(comboMask, millis());
+  }
 
-  // Brief settle instead of the old delay(500)
-  delay(50);
-  while (Serial1.available()) { Serial1.read(); }
+  // Still settling when the scan stopped (or nothing found): send it now
+  if (!calibrating && comboDispatcher.flush(millis())) sendCombo(comboDispatcher.mask());
+
+  // ── Stop continuous reading — returns on the module's stop acknowledgement ──
+  if (readerRunning && !rfidModule.stopBackgroundReading()) {
+    Serial.println(F("  WARNING: no stop acknowledgement from module"));
+  }
+  readerRunning = false;
+  logEvent(SCANLOG_SCAN_END, comboMask, millis(), 0, 0, scanElapsed, tagInventory.count(), pucksFound);
 
   // ── Results ──
   Serial.println(F("\n────────────────────────────────────────"));
   Serial.print(F("SCAN COMPLETE: "));
-  Serial.print(tagCount);
+  Serial.print(tagInventory.count());
   Serial.print(F(" unique tag(s), "));
   Serial.print(pucksFound);
   Serial.print(F("/"));
   Serial.print(NUM_PUCKS);
   Serial.print(F(" pucks in "));
   Serial.print(scanElapsed);
+  Serial.print(F(" ms  (combo 0x"));
+  Serial.print(comboMask, HEX);
+  Serial.println(F(")"));
+  Serial.print(F("  Stopped: "));
+  Serial.print(ScanEngine::reasonString(scanEngine.reason()));
+  Serial.print(F(", last new tag at "));
+  Serial.print(scanEngine.lastNewTagMs());
   Serial.println(F(" ms"));
-  Serial.print(F("  Total reads: "));
-  Serial.print(totalReads);
-  if (parseErrors > 0) {
-    Serial.print(F("  Errors: "));
-    Serial.print(parseErrors);
+  printLinkStats(parseErrors);
+  if (ZONE_FILTER) printZone();
+  if (!calibrating) {
+    adjustReadPower(pucksFound);
+    adjustGen2(scanEngine.reason() != SCAN_STOP_DEADLINE, tagReads);
   }
-  Serial.println();
   Serial.println(F("────────────────────────────────────────"));
 
-  if (tagCount > 0) {
-    Serial.println(F("\nAll Detected Tags:"));
-    for (int i = 0; i < tagCount; i++) {
+  if (tagInventory.count() > 0) {
+    Serial.println(F("\nAll Detected Tags:   (reads, RSSI min/mean/max dBm)"));
+    for (uint16_t i = 0; i < tagInventory.count(); i++) {
+      EpcStats &tag = tagInventory.entry(i);
+      char statBuf[40];
+      snprintf(statBuf, sizeof(statBuf), " | %4lu x | %4d/%4d/%4d | EPC: ",
+               (unsigned long)tag.readCount, tag.rssiMin, tag.rssiMean(), tag.rssiMax);
       Serial.print(F("  #"));
       Serial.print(i + 1);
-      Serial.print(F(" | RSSI: "));
-      char rssiBuf[8];
-      snprintf(rssiBuf, sizeof(rssiBuf), "%4d", tagInventory[i].rssi);
-      Serial.print(rssiBuf);
-      Serial.print(F(" dBm | EPC: "));
-      printEPC(tagInventory[i].epc, tagInventory[i].epcLen);
+      Serial.print(statBuf);
+      printEPC(tag.epc, tag.epcLen);
     }
   } else {
     Serial.println(F("\nNo tags detected."));
-    Serial.print(F("  → Try increasing READ_POWER (currently "));
-    Serial.print(READ_POWER);
-    Serial.println(F(")."));
+    if (powerController.power() >= POWER_POLICY.maxPower) {
+      Serial.println(F("  → Already at maximum read power, check the antenna."));
+    }
   }
 
   // ── Light LEDs ──
-  if (pucksFound > 0) {
+  if (pucksFound > 0 && !calibrating) {
     Serial.print(F("\nLEDs ON: "));
-    for (int i = 0; i < NUM_PUCKS; i++) {
-      if (pucks[i].detected) {
+    for (uint8_t i = 0; i < NUM_PUCKS; i++) {
+      if (puckDetected[i]) {
         digitalWrite(pucks[i].ledPin, HIGH);
         Serial.print(pucks[i].name);
         Serial.print(' ');
@@ -322,25 +652,201 @@ void performScan() {
     }
     Serial.println();
 
-    delay(LED_DISPLAY_MS);
-
-    for (int i = 0; i < NUM_PUCKS; i++) {
-      digitalWrite(pucks[i].ledPin, LOW);
-    }
-    Serial.println(F("LEDs OFF."));
+    // off from loop(), a press in the meantime starts the next scan at once
+    ledsOffMs = millis() + LED_DISPLAY_MS;
+    if (ledsOffMs == 0) ledsOffMs = 1;
   }
 
+  // The log host gets the scan once it is on screen
+  flushScanLog();
+
   Serial.println(F("\nPress button to scan again...\n"));
 }
 
-// ─── Tag Lookup ─────────────────────────────────────────────────────────────
-int findTagByEPC(byte *epc, uint8_t epcLen) {
-  for (int i = 0; i < tagCount; i++) {
-    if (tagInventory[i].epcLen == epcLen && memcmp(tagInventory[i].epc, epc, epcLen) == 0) {
-      return i;
+// ─── Presence (Button-less) ─────────────────────────────────────────────────
+// Reading never stops: one startBackgroundReading() in setup(), then every
+// loop() hands the records to the tracker
+bool startPresence() {
+  if (NUM_ANTENNAS > 1) {
+    uint8_t ports[NUM_ANTENNAS];
+    for (uint8_t i = 0; i < NUM_ANTENNAS; i++) ports[i] = ANTENNAS[i].port;
+    rfidModule.setAntennaSearchList(ports, NUM_ANTENNAS);
+  }
+
+  presence.clear();
+  presence.setCallbacks(onPuckArrive, onPuckDepart, NULL);
+  thermal.reset();
+  readerRunning = rfidModule.startBackgroundReading(presenceReadConfig());
+  return readerRunning;
+}
+
+// New duty cycle / power: the one break in reading, a few ms. The tracker
+// keeps its tags, departMs covers the gap. temp is read before, the restart
+// forgets the last statistics record
+void applyThermal(int8_t temp) {
+  rfidModule.stopBackgroundReading();
+  rfidModule.setReadPower(thermal.power());  // skipped by the config cache if unchanged
+  readerRunning = rfidModule.startBackgroundReading(presenceReadConfig());
+
+  Serial.print(F("  Thermal: "));
+  Serial.print(ThermalScheduler::changeString(thermal.lastChange()));
+  Serial.print(F(" at "));
+  Serial.print(temp);
+  Serial.print(F(" C → duty "));
+  Serial.print(thermal.duty());
+  Serial.print(F("%, "));
+  printPower(thermal.power());
+  Serial.println();
+  if (!readerRunning) Serial.println(F("  ERROR: could not restart reader task"));
+}
+
+void trackPresence() {
+  StreamedTag rec;
+
+  while (rfidModule.readStreamedTag(rec)) {
+    if (rec.type == RESPONSE_IS_TAGFOUND) {
+      presence.tagRead(rec.epc, rec.epcLen, rec.rssi, rec.ms);
+      if (SCAN_LOG) logTagRead(rec, pucks.match(rec.epc, rec.epcLen));
+    } else if (rec.type == RESPONSE_IS_TEMPTHROTTLE) {
+      Serial.println(F("  WARNING: Thermal throttling!"));
+      logEvent(SCANLOG_THROTTLE, 0, rec.ms, 0, 0, 0, 0, 0);
+      thermal.throttled();
     }
   }
-  return -1;
+  presence.poll(millis());
+  if (comboDispatcher.poll(millis())) sendCombo(comboDispatcher.mask());
+
+  // getTemp() while reading is the last statistics record, no command
+  int8_t temp = rfidModule.getTemp();
+  if (thermal.update(millis(), temp)) applyThermal(temp);
+
+  if (millis() - lastTempPrintMs >= 60000UL) {
+    lastTempPrintMs = millis();
+    Serial.print(F("  Module "));
+    Serial.print(temp);
+    Serial.print(F(" C, duty "));
+    Serial.print(thermal.duty());
+    Serial.print(F("%, "));
+    printPower(thermal.power());
+    Serial.println();
+  }
+}
+
+void onPuckArrive(const PresenceTag &tag, void *ctx) {
+  int puckIdx = pucks.match(tag.epc, tag.epcLen);
+  if (puckIdx < 0) return;  // not one of ours: tracked, but nothing to show
+
+  puckDetected[puckIdx] = true;
+  presentMask |= 1UL << pucks[puckIdx].comboId;
+  comboDispatcher.update(presentMask, millis());
+  digitalWrite(pucks[puckIdx].ledPin, HIGH);
+  Serial.print(F("  [IN]  "));
+  Serial.print(pucks[puckIdx].name);
+  Serial.print(F(" | RSSI: "));
+  Serial.print(tag.rssi);
+  Serial.println(F(" dBm"));
+}
+
+void onPuckDepart(const PresenceTag &tag, void *ctx) {
+  int puckIdx = pucks.match(tag.epc, tag.epcLen);
+  if (puckIdx < 0) return;
+
+  puckDetected[puckIdx] = false;
+  presentMask &= ~(1UL << pucks[puckIdx].comboId);
+  comboDispatcher.update(presentMask, millis());
+  digitalWrite(pucks[puckIdx].ledPin, LOW);
+  Serial.print(F("  [OUT] "));
+  Serial.print(pucks[puckIdx].name);
+  Serial.print(F(" after "));
+  Serial.print(tag.lastSeenMs - tag.arrivedMs);
+  Serial.println(F(" ms"));
+}
+
+// ─── Combination → BrightSign ───────────────────────────────────────────────
+bool initializeEthernet() {
+  if (!ETH.begin(ETH_PHY_W5500, 1, ETH_CS, ETH_INT, ETH_RST, SPI3_HOST, ETH_SCLK, ETH_MISO, ETH_MOSI)) {
+    return false;
+  }
+  ETH.config(LOCAL_IP, IPAddress(0, 0, 0, 0), SUBNET);
+  return udp.begin(BRIGHTSIGN_UDP_PORT);
+}
+
+// Sends first, logs after: the packet is out within a ms of the decision
+void sendCombo(uint32_t mask) {
+  const ComboAction *action = combos.match(mask);
+  bool linkUp = ETH.linkUp();
+  bool sent = false;
+  if (action != NULL && linkUp) {
+    sent = udp.beginPacket(BRIGHTSIGN_IP, BRIGHTSIGN_UDP_PORT) && udp.print(action->command) > 0 && udp.endPacket();
+  }
+
+  Serial.print(F("  Combo 0x"));
+  Serial.print(mask, HEX);
+  Serial.print(F(" settled "));
+  Serial.print(comboDispatcher.settledMs());
+  Serial.print(F(" ms → "));
+  if (action == NULL) {
+    Serial.println(F("no action"));
+    return;
+  }
+  Serial.print(action->command);
+  if (sent) {
+    Serial.println(F(" (sent)"));
+  } else {
+    Serial.println(linkUp ? F(" (NOT sent, UDP send failed)") : F(" (NOT sent, no Ethernet link)"));
+  }
+}
+
+// ─── Scan Log → Log Host ────────────────────────────────────────────────────
+void initializeScanLog() {
+  uint32_t bytes = SCANLOG_PSRAM_BYTES;
+  uint8_t *storage = psramFound() ? (uint8_t *)ps_malloc(bytes) : NULL;
+  if (storage == NULL) {
+    bytes = SCANLOG_RAM_BYTES;
+    storage = (uint8_t *)malloc(bytes);
+  }
+  if (storage == NULL) bytes = 0;
+
+  // the low half of the MAC tells the readers apart on the log host
+  scanLog.begin(storage, bytes, (uint32_t)ESP.getEfuseMac());
+  Serial.print(F("  Scan log: "));
+  Serial.print(scanLog.capacity());
+  Serial.println(bytes == SCANLOG_PSRAM_BYTES ? F(" records (PSRAM)") : F(" records"));
+}
+
+void logTagRead(const StreamedTag &rec, int puckIdx) {
+  scanLog.tagRead(rec.ms, rec.epc, rec.epcLen, puckIdx >= 0 ? puckIdx : SCANLOG_NO_INDEX,
+                  rec.rssi, rec.antenna, rec.freq, rec.phase);
+}
+
+void logEvent(ScanLogType type, uint32_t value, uint32_t ms, int8_t rssi, uint8_t antenna,
+              uint16_t freq, int16_t phase, uint8_t index) {
+  if (!SCAN_LOG) return;
+  ScanLogRecord rec = { ms, value, freq, phase, rssi, antenna, (uint8_t)type, index };
+  scanLog.add(rec);
+}
+
+// Batches of SCANLOG_PACKET_RECORDS, oldest first. Without a link the
+// records wait in the ring for the next try
+void flushScanLog() {
+  lastLogFlushMs = millis();
+  if (!SCAN_LOG || !ETH.linkUp()) return;
+
+  static uint8_t packet[SCANLOG_PACKET_BYTES];
+  uint16_t len;
+  while ((len = scanLog.packet(packet, sizeof(packet))) > 0) {
+    if (!udp.beginPacket(LOG_HOST_IP, LOG_HOST_UDP_PORT) || udp.write(packet, len) != len || !udp.endPacket()) return;
+    scanLog.sent();
+  }
+}
+
+void updateLeds() {
+  if (ledsOffMs == 0 || (int32_t)(millis() - ledsOffMs) < 0) return;
+  ledsOffMs = 0;
+  for (uint8_t i = 0; i < NUM_PUCKS; i++) {
+    digitalWrite(pucks[i].ledPin, LOW);
+  }
+  Serial.println(F("LEDs OFF."));
 }
 
 // ─── Utility ────────────────────────────────────────────────────────────────
@@ -353,17 +859,208 @@ void printEPC(byte *epc, uint8_t len) {
   Serial.println();
 }
 
-void printResult(bool success) {
-  Serial.println(success ? F("OK") : F("FAILED"));
+// One line of library counters for the scan just finished
+void printLinkStats(uint16_t parseErrors) {
+  RFIDStats stats;
+  rfidModule.getStats(stats);
+
+  char buf[112];
+  snprintf(buf, sizeof(buf), "  Reads: %lu (%lu/s)  first after %lu ms  frames %lu  crc %lu  resync %lu  ovf %lu",
+           (unsigned long)stats.tagReads, (unsigned long)stats.readsPerSec,
+           (unsigned long)stats.firstReadMs, (unsigned long)stats.framesReceived,
+           (unsigned long)stats.crcErrors, (unsigned long)stats.resyncs,
+           (unsigned long)stats.uartOverflows);
+  Serial.println(buf);
+
+  if (parseErrors > 0 || stats.corruptRecords > 0 || rfidModule.streamedTagsDropped() > 0) {
+    Serial.print(F("  Errors: "));
+    Serial.print(parseErrors + stats.corruptRecords);
+    Serial.print(F("  Dropped: "));
+    Serial.println(rfidModule.streamedTagsDropped());
+  }
 }
 
-// Checks if an EPC matches any known puck
-int matchPuck(byte *epc, uint8_t epcLen) {
-  if (epcLen != EPC_LENGTH) return -1;
-  for (int i = 0; i < NUM_PUCKS; i++) {
-    if (memcmp(epc, pucks[i].epc, EPC_LENGTH) == 0) return i;
+// Feeds the pucks' best RSSI to the power controller and applies the power
+// it picks for the next scan (the module is only told when it changes)
+void adjustReadPower(uint8_t pucksFound) {
+  uint8_t missed = 0;
+  uint32_t marginal = 0;
+
+  for (uint8_t i = 0; i < NUM_PUCKS; i++) {
+    if (!puckDetected[i]) {
+      if (marginalPucks & (1UL << i)) missed++;
+      continue;
+    }
+    EpcStats *tag = tagInventory.find(pucks[i].epc, EPC_REGISTRY_EPC_BYTES);
+    if (tag == NULL) continue;
+    powerController.expectedTag(tag->rssiMax);
+    if (tag->rssiMax < POWER_POLICY.weakRssi + PUCK_MARGINAL_DB || tag->readCount == 1) marginal |= 1UL << i;
+  }
+  marginalPucks = marginal;
+
+  int16_t previous = powerController.power();
+  int16_t power = powerController.endScan(missed);
+
+  Serial.print(F("  Read power: "));
+  printPower(power);
+  if (powerController.changed()) {
+    rfidModule.setReadPower(power);
+    Serial.print(F(" (was "));
+    printPower(previous);
+    Serial.print(F(", "));
+    Serial.print(PowerController::changeString(powerController.lastChange()));
+    Serial.print(')');
+  }
+  if (pucksFound > 0) {
+    Serial.print(F(", weakest puck "));
+    Serial.print(powerController.weakestRssi());
+    Serial.print(F(" dBm"));
+  }
+  Serial.println();
+}
+
+// Sizes the next scan's inventory rounds to the population just seen
+void adjustGen2(bool complete, uint32_t tagReads) {
+  gen2Tuner.scanResult(tagInventory.count(), complete, tagReads);
+  if (!gen2Tuner.changed()) return;
+
+  const Gen2Choice &gen2 = gen2Tuner.choice();
+  rfidModule.setGen2Q(gen2.qType, gen2.initQ, true);
+  rfidModule.setGen2Target(gen2.target);
+
+  Serial.print(F("  Gen2: Q "));
+  Serial.print(gen2.initQ);
+  Serial.print(gen2.qType == TMR_SR_GEN2_Q_STATIC ? F(" static") : F(" dynamic"));
+  Serial.print(gen2.target == TMR_GEN2_TARGET_A ? F(", target A") : F(", target AB"));
+  Serial.print(F(" for ~"));
+  Serial.print(gen2Tuner.estimate());
+  Serial.println(F(" tags"));
+}
+
+void printPower(int16_t power) {
+  Serial.print(power / 100);
+  Serial.print('.');
+  if (power % 100 < 10) Serial.print('0');
+  Serial.print(power % 100);
+  Serial.print(F(" dBm"));
+}
+
+// ─── Zone Filter (ZONE_FILTER) ──────────────────────────────────────────────
+// ZONE_FILTER early stop: true on the read that makes ZONE_INSIDE_CHECKS
+// INSIDE reads in a row, then never again this scan
+bool zoneHint(uint8_t puckIdx, ZoneClass where) {
+  uint8_t &n = zoneInside[puckIdx];
+  if (n >= ZONE_INSIDE_CHECKS) return (false);
+  n = where == ZONE_INSIDE ? n + 1 : 0;
+  return (n == ZONE_INSIDE_CHECKS);
+}
+
+// Per tag of the scan: where the filter puts it and on what. Numbered like
+// the tag list below
+void printZone() {
+  printZoneCalibration();
+  for (uint16_t i = 0; i < tagInventory.count(); i++) {
+    EpcStats &tag = tagInventory.entry(i);
+    ZoneFeatures f;
+    if (!zone.features(tag.epc, tag.epcLen, f)) continue;
+
+    char buf[48];
+    snprintf(buf, sizeof(buf), "    #%u %-7s %4d dBm, %2u ch, ", i + 1,
+             ZoneClassifier::classString(zone.classify(f)), f.rssi, f.channels);
+    Serial.print(buf);
+    if (f.rangeCm == ZONE_RANGE_NONE) {
+      Serial.println(F("no range"));
+    } else {
+      Serial.print(f.rangeCm);
+      Serial.println(F(" cm"));
+    }
+  }
+}
+
+void printZoneCalibration() {
+  const ZoneCalibration &cal = zone.calibration();
+  if (!cal.valid) {
+    Serial.println(F("  Zone: not calibrated, no puck counts (send i, then o)"));
+    return;
+  }
+
+  Serial.print(F("  Zone: mean RSSI from "));
+  Serial.print(cal.minRssi);
+  Serial.print(F(" dBm at "));
+  printPower(cal.power);
+  if (cal.useRange) {
+    Serial.print(F(", range "));
+    Serial.print(cal.minRangeCm);
+    Serial.print(F(" to "));
+    Serial.print(cal.maxRangeCm);
+    Serial.print(F(" cm"));
+  }
+  Serial.println();
+}
+
+// ZONE_CAL_SCANS scans; every tag read in them is a sample. Only pucks
+// answer (the Select on their EPC prefix), so with all pucks in the beaker
+// (inside) or all of them around it (outside) each read tag is one
+void calibrateZone(bool inside) {
+  Serial.print(F("\n>>> ZONE CALIBRATION: pucks "));
+  Serial.println(inside ? F("inside the beaker <<<") : F("next to the beaker <<<"));
+
+  // power and Gen2 settings stay put, no combination is sent
+  calibrating = true;
+  for (uint8_t s = 0; s < ZONE_CAL_SCANS; s++) {
+    performScan();
+    for (uint16_t i = 0; i < tagInventory.count(); i++) {
+      EpcStats &tag = tagInventory.entry(i);
+      ZoneFeatures f;
+      if (zone.features(tag.epc, tag.epcLen, f)) zone.sample(f, inside);
+    }
+  }
+  calibrating = false;
+
+  Serial.print(F("  Samples: "));
+  Serial.print(zone.samples(true));
+  Serial.print(F(" inside, "));
+  Serial.print(zone.samples(false));
+  Serial.println(F(" outside"));
+  if (!zone.calibrate()) {
+    Serial.println(F("  No inside samples, send i with the pucks in the beaker first"));
+    return;
+  }
+  saveZoneCalibration();
+  printZoneCalibration();
+}
+
+void saveZoneCalibration() {
+  Preferences prefs;
+  if (!prefs.begin(ZONE_NVS_NAMESPACE, false)) return;
+  if (zone.calibration().valid) {
+    prefs.putBytes("cal", &zone.calibration(), sizeof(ZoneCalibration));
+  } else {
+    prefs.remove("cal");
+  }
+  prefs.end();
+}
+
+void loadZoneCalibration() {
+  Preferences prefs;
+  ZoneCalibration cal;
+  if (!prefs.begin(ZONE_NVS_NAMESPACE, true)) return;
+  if (prefs.getBytes("cal", &cal, sizeof(cal)) == sizeof(cal) && cal.valid) zone.setCalibration(cal);
+  prefs.end();
+}
+
+// i - calibrate with the pucks in the beaker (repeat to add samples)
+// o - then with the pucks around it, where visitors put them down
+// x - forget the calibration and the samples
+void zoneCommand(char c) {
+  if (c == 'i' || c == 'o') {
+    calibrateZone(c == 'i');
+  } else if (c == 'x') {
+    zone.clearSamples();
+    zone.clearCalibration();
+    saveZoneCalibration();
+    printZoneCalibration();
   }
-  return -1;
 }
 
 /*
@@ -389,8 +1086,14 @@ void setup() {
   pinMode(BUTTON_PIN, INPUT);
   attachInterrupt(digitalPinToInterrupt(BUTTON_PIN), buttonISR, FALLING);
 
+  for (uint8_t i = 0; i < NUM_ANTENNAS; i++) {
+    antennas.addPort(ANTENNAS[i].port, ANTENNAS[i].dwellMs, ANTENNAS[i].weight);
+  }
+
 
   // Initialize UART to M7E with explicit ESP32-S3 pin mapping
+  // (RX buffer must be sized before begin())
+  Serial1.setRxBufferSize(RFID_UART_RX_BUFFER);
   Serial1.begin(RFID_BAUD, SERIAL_8N1, RXD1, TXD1);
 
   if (!initializeModule()) {
@@ -398,7 +1101,20 @@ void setup() {
     while (1) { delay(1000); }
   }
 
-  configureGen2Parameters();
+  // The tuner compares its choices with what the profile set, so the first
+  // one that differs from it is sent
+  gen2Tuner.seed({ READER_PROFILE.qType, READER_PROFILE.qInit, READER_PROFILE.target });
+
+  // The link comes up in the background, combos are logged until it does
+  if (!initializeEthernet()) {
+    Serial.println(F("  WARNING: Ethernet (W5500) did not start, combos are not sent"));
+  }
+
+  if (SCAN_LOG) initializeScanLog();
+  if (ZONE_FILTER) {
+    loadZoneCalibration();
+    printZoneCalibration();
+  }
 
   // Brief LED test — all on, then off
   Serial.println(F("\nLED test..."));
@@ -407,11 +1123,31 @@ void setup() {
   for (int i = 0; i < NUM_PUCKS; i++) digitalWrite(pucks[i].ledPin, LOW);
 
   Serial.println(F("\n────────────────────────────────────────"));
-  Serial.println(F("Place pucks in beaker, then press button to scan."));
+  if (PRESENCE_MODE) {
+    if (!startPresence()) {
+      Serial.println(F("FATAL: could not start reader task"));
+      while (1) { delay(1000); }
+    }
+    Serial.println(F("Reading. Place pucks in beaker."));
+  } else {
+    Serial.println(F("Place pucks in beaker, then press button to scan."));
+  }
   Serial.println(F("────────────────────────────────────────\n"));
 }
 
 void loop() {
+  if (millis() - lastLogFlushMs >= SCANLOG_FLUSH_MS) flushScanLog();
+
+  if (PRESENCE_MODE) {
+    trackPresence();
+    delay(1);
+    return;
+  }
+
+  updateLeds();
+
+  if (ZONE_FILTER && Serial.available()) zoneCommand(Serial.read());
+
   if (pressed) {
     Serial.println("\nButton pressed!");
     delay(10);
@@ -0,0 +1,96 @@
+/*
+  Arduino shim for building the RFID library on a Linux host, see Arduino.h
+*/
+
+#include "Arduino.h"
+
+#include <time.h>
+
+HostSerial Serial;
+
+static uint64_t nowUs(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ((uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+}
+
+static const uint64_t startUs = nowUs();
+
+unsigned long millis(void) { return ((unsigned long)((nowUs() - startUs) / 1000)); }
+unsigned long micros(void) { return ((unsigned long)(nowUs() - startUs)); }
+
+void delayMicroseconds(unsigned int us) {
+  struct timespec ts = {(time_t)(us / 1000000), (long)(us % 1000000) * 1000};
+  nanosleep(&ts, NULL);
+}
+
+void delay(unsigned long ms) {
+  while (ms > 0) {
+    unsigned long step = ms > 1000 ? 1000 : ms;
+    delayMicroseconds(step * 1000);
+    ms -= step;
+  }
+}
+
+void yield(void) {}
+
+size_t Print::write(const uint8_t *buffer, size_t size) {
+  size_t n = 0;
+  while (size--)
+    n += write(*buffer++);
+  return (n);
+}
+
+static size_t printNumber(Print &out, unsigned long value, int base, bool negative) {
+  char buf[24];
+  int len;
+
+  if (base == HEX)
+    len = snprintf(buf, sizeof(buf), "%lX", value);
+  else
+    len = snprintf(buf, sizeof(buf), negative ? "-%lu" : "%lu", value);
+
+  return (out.write((const uint8_t *)buf, len));
+}
+
+size_t Print::print(const __FlashStringHelper *str) { return (print((const char *)str)); }
+size_t Print::print(const char *str) { return (write(str)); }
+size_t Print::print(char c) { return (write((uint8_t)c)); }
+size_t Print::print(int value, int base) { return (print((long)value, base)); }
+size_t Print::print(unsigned int value, int base) { return (print((unsigned long)value, base)); }
+size_t Print::print(unsigned char value, int base) { return (print((unsigned long)value, base)); }
+size_t Print::print(unsigned long value, int base) { return (printNumber(*this, value, base, false)); }
+
+size_t Print::print(long value, int base) {
+  if (base == HEX || value >= 0)
+    return (printNumber(*this, (unsigned long)value, base, false));
+  return (printNumber(*this, (unsigned long)-value, base, true));
+}
+
+size_t Print::print(double value, int digits) {
+  char buf[40];
+  int len = snprintf(buf, sizeof(buf), "%.*f", digits, value);
+  return (write((const uint8_t *)buf, len));
+}
+
+size_t Print::println(void) { return (write((uint8_t)'\n')); }
+size_t Print::println(const __FlashStringHelper *str) { return (print(str) + println()); }
+size_t Print::println(const char *str) { return (print(str) + println()); }
+size_t Print::println(char c) { return (print(c) + println()); }
+size_t Print::println(int value, int base) { return (print(value, base) + println()); }
+size_t Print::println(unsigned int value, int base) { return (print(value, base) + println()); }
+size_t Print::println(long value, int base) { return (print(value, base) + println()); }
+size_t Print::println(unsigned long value, int base) { return (print(value, base) + println()); }
+size_t Print::println(unsigned char value, int base) { return (print(value, base) + println()); }
+size_t Print::println(double value, int digits) { return (print(value, digits) + println()); }
+
+size_t Stream::readBytes(uint8_t *buffer, size_t length) {
+  size_t n = 0;
+  while (n < length) {
+    int c = read();
+    if (c < 0)
+      break;
+    buffer[n++] = (uint8_t)c;
+  }
+  return (n);
+}
@@ -0,0 +1,96 @@
+/*
+  Arduino shim for building the RFID library on a Linux host
+
+  Only what SparkFun_UHF_RFID_Reader.cpp needs from the core: Print /
+  Stream, millis() / micros() / delay(), F() and the Arduino typedefs.
+  Build with -DARDUINO=100 so the library includes this file.
+  Printing goes to stdout. ARDUINO_ARCH_ESP32 must NOT be defined: the
+  host build uses the plain Stream code paths (no FreeRTOS, UART events
+  or NVS).
+*/
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HEX 16
+#define DEC 10
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(s))
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield(void);
+
+class Print
+{
+  public:
+    virtual ~Print(void) {}
+
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size);
+    size_t write(const char *str) { return (write((const uint8_t *)str, strlen(str))); }
+    virtual void flush(void) {}
+
+    size_t print(const __FlashStringHelper *str);
+    size_t print(const char *str);
+    size_t print(char c);
+    size_t print(int value, int base = DEC);
+    size_t print(unsigned int value, int base = DEC);
+    size_t print(long value, int base = DEC);
+    size_t print(unsigned long value, int base = DEC);
+    size_t print(unsigned char value, int base = DEC);
+    size_t print(double value, int digits = 2);
+
+    size_t println(const __FlashStringHelper *str);
+    size_t println(const char *str);
+    size_t println(char c);
+    size_t println(int value, int base = DEC);
+    size_t println(unsigned int value, int base = DEC);
+    size_t println(long value, int base = DEC);
+    size_t println(unsigned long value, int base = DEC);
+    size_t println(unsigned char value, int base = DEC);
+    size_t println(double value, int digits = 2);
+    size_t println(void);
+};
+
+class Stream : public Print
+{
+  public:
+    virtual int available(void) = 0;
+    virtual int read(void) = 0;
+    virtual int peek(void) = 0;
+
+    // never waits: returns what is available, up to length
+    virtual size_t readBytes(uint8_t *buffer, size_t length);
+    size_t readBytes(char *buffer, size_t length) { return (readBytes((uint8_t *)buffer, length)); }
+};
+
+// stdout, so the library's debug output has somewhere to go
+class HostSerial : public Stream
+{
+  public:
+    size_t write(uint8_t c) { return (fputc(c, stdout) == EOF ? 0 : 1); }
+    using Print::write;
+    int available(void) { return (0); }
+    int read(void) { return (-1); }
+    int peek(void) { return (-1); }
+};
+
+extern HostSerial Serial;
+
+#endif
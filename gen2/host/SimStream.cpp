@@ -0,0 +1,94 @@
+/*
+  Simulated M7E serial link for the host harness, see SimStream.h
+*/
+
+#include "SimStream.h"
+
+// xorshift32, reproducible for a given seed
+uint32_t SimStream::random(uint32_t range) {
+  _rng ^= _rng << 13;
+  _rng ^= _rng >> 17;
+  _rng ^= _rng << 5;
+  return (range ? _rng % range : _rng);
+}
+
+void SimStream::setFaults(uint16_t corruptPerMille, uint16_t dropPerMille) {
+  _corruptPerMille = corruptPerMille;
+  _dropPerMille = dropPerMille;
+}
+
+void SimStream::send(const uint8_t *frame, size_t len) {
+  size_t start = _wire.size();
+  _wire.insert(_wire.end(), frame, frame + len);
+
+  if (len == 0)
+    return;
+
+  if (_corruptPerMille && random(1000) < _corruptPerMille) {
+    _wire[start + random(len)] ^= 1 << random(8);
+    _corrupted++;
+  }
+
+  if (_dropPerMille && random(1000) < _dropPerMille) {
+    _wire.erase(_wire.begin() + start + random(len));
+    _dropped++;
+  }
+}
+
+size_t SimStream::release(size_t n) {
+  size_t left = _wire.size() - _ready;
+  if (n > left)
+    n = left;
+  _ready += n;
+  return (n);
+}
+
+// drop what was read once it is most of the buffer, keeps memory flat on long runs
+void SimStream::_compact(void) {
+  if (_readPos < 65536 || _readPos < _wire.size() / 2)
+    return;
+
+  _wire.erase(_wire.begin(), _wire.begin() + _readPos);
+  _ready -= _readPos;
+  _readPos = 0;
+}
+
+int SimStream::available(void) { return ((int)(_ready - _readPos)); }
+
+int SimStream::peek(void) { return (_readPos < _ready ? _wire[_readPos] : -1); }
+
+int SimStream::read(void) {
+  if (_readPos >= _ready)
+    return (-1);
+
+  int c = _wire[_readPos++];
+  _compact();
+  return (c);
+}
+
+size_t SimStream::readBytes(uint8_t *buffer, size_t length) {
+  size_t n = _ready - _readPos;
+  if (n > length)
+    n = length;
+
+  memcpy(buffer, &_wire[_readPos], n);
+  _readPos += n;
+  _compact();
+  return (n);
+}
+
+// FF LEN OP DATA.. CRC CRC: hand complete commands to onCommand
+size_t SimStream::write(uint8_t c) {
+  _written++;
+
+  if (_cmd.empty() && c != 0xFF)
+    return (1);
+
+  _cmd.push_back(c);
+  if (_cmd.size() >= 2 && _cmd.size() == (size_t)_cmd[1] + 5) {
+    if (onCommand != NULL)
+      onCommand(*this, _cmd.data(), _cmd.size());
+    _cmd.clear();
+  }
+  return (1);
+}
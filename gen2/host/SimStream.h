@@ -0,0 +1,80 @@
+/*
+  Simulated M7E serial link for the host harness
+
+  Bytes queued with send() are "on the wire": they only become readable
+  after release() moves them into the receive window, the way a UART
+  FIFO fills between two check() calls. Releasing a few bytes at a time
+  splits frames across calls; the fault settings corrupt or drop bytes of
+  each frame as it is queued.
+
+  Whatever the library writes (commands) is counted and discarded, unless
+  onCommand is set: it gets every complete command frame and can answer
+  with send().
+
+    SimStream link;
+    link.setFaults(10, 0);           // 1 % of frames get a flipped bit
+    link.send(frame, len);
+    link.release(64);                // 64 bytes arrived
+    while (rfid.check()) ...
+*/
+
+#ifndef SIM_STREAM_H
+#define SIM_STREAM_H
+
+#include "Arduino.h"
+
+#include <vector>
+
+class SimStream : public Stream
+{
+  public:
+    // queue bytes on the wire; faults apply to the frame as a whole
+    void send(const uint8_t *frame, size_t len);
+
+    // make up to n queued bytes readable, returns how many
+    size_t release(size_t n);
+    size_t releaseAll(void) { return (release(_wire.size() - _ready)); }
+
+    // bytes still on the wire / readable
+    size_t queued(void) const { return (_wire.size() - _ready); }
+    size_t readable(void) const { return (_ready - _readPos); }
+
+    // per mille of frames with one flipped bit / one dropped byte
+    void setFaults(uint16_t corruptPerMille, uint16_t dropPerMille);
+    void seed(uint32_t seed) { _rng = seed ? seed : 1; }
+
+    uint32_t framesCorrupted(void) const { return (_corrupted); }
+    uint32_t framesTruncated(void) const { return (_dropped); }
+    uint32_t bytesWritten(void) const { return (_written); }
+
+    // called for each command frame the library sends
+    void (*onCommand)(SimStream &link, const uint8_t *frame, size_t len) = NULL;
+
+    int available(void);
+    int read(void);
+    int peek(void);
+    size_t readBytes(uint8_t *buffer, size_t length);
+
+    size_t write(uint8_t c);
+    using Print::write;
+
+    uint32_t random(uint32_t range);
+
+  private:
+    void _compact(void);
+
+    std::vector<uint8_t> _wire;  // everything queued, read or not
+    size_t _ready = 0;           // _wire[0 .. _ready) readable
+    size_t _readPos = 0;         // next byte read()
+
+    std::vector<uint8_t> _cmd;   // command frame being written
+
+    uint16_t _corruptPerMille = 0;
+    uint16_t _dropPerMille = 0;
+    uint32_t _rng = 0x2545F491;
+    uint32_t _corrupted = 0;
+    uint32_t _dropped = 0;
+    uint32_t _written = 0;
+};
+
+#endif
@@ -0,0 +1,368 @@
+/*
+  Host benchmark / regression run for the streaming parser
+
+  Feeds a SimStream with either captured frames (--replay) or synthesized
+  tag records (--synth) and measures how fast check() + parseResponse()
+  get through them. Frames can be split across check() calls (--split),
+  corrupted or truncated (--corrupt / --drop, per mille of frames) and
+  paced to a frame rate (--rate, 0 = as fast as possible).
+
+  --continuous 1 starts a continuous read first (the simulated module
+  answers every command), so check() filters the stream the way it does
+  on the device: tag records, keep-alives and throttle notices come
+  through, statistics frames are consumed.
+
+  Exit status is non-zero when a captured frame fails the library's CRC,
+  or when a fault-free run did not decode every tag record and throttle
+  notice it was given, so a script can run it as a regression check.
+
+  Build and run from this directory, see README.md:
+
+    g++ -std=gnu++11 -O2 -DARDUINO=100 -I. -I../src parser_bench.cpp SimStream.cpp Arduino.cpp ../src/SparkFun_UHF_RFID_Reader.cpp -o parser_bench
+    ./parser_bench --replay captures/parse_response.txt --repeat 100000
+    ./parser_bench --synth 1000000 --split 16 --corrupt 5
+    ./parser_bench --continuous 1 --synth 100000 --option 14 --throttle 100
+*/
+
+#include "Arduino.h"
+#include "SimStream.h"
+#include "SparkFun_UHF_RFID_Reader.h"
+
+#include <ctype.h>
+#include <time.h>
+#include <vector>
+
+typedef std::vector<uint8_t> Frame;
+
+static RFID rfid;
+static SimStream link;
+
+static double seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+static void appendCrc(Frame &f) {
+  uint16_t crc = rfid.calculateCRC(&f[1], f.size() - 1);
+  f.push_back(crc >> 8);
+  f.push_back(crc & 0xFF);
+}
+
+// 0x22 with status 0x0504, no data: the module throttled the read
+static bool isThrottle(const Frame &f) {
+  return (f.size() == 7 && f[1] == 0 && f[2] == TMR_SR_OPCODE_READ_TAG_ID_MULTIPLE && f[3] == 0x05 && f[4] == 0x04);
+}
+
+static bool isTagRecord(const Frame &f) {
+  TagRecord rec;
+  return (f.size() > 7 && f[2] == TMR_SR_OPCODE_READ_TAG_ID_MULTIPLE && f[1] > 0x0E &&
+          RFID::decodeTagRecord(f.data(), rec));
+}
+
+// One frame per line as hex bytes, brackets optional ("[FF] [28] ..." or
+// "FF 28 ..."); '#' starts a comment. A line ending in "+crc" is a dump
+// without its CRC: one is appended. Every other frame must carry a CRC the
+// library agrees with.
+static bool loadCapture(const char *path, std::vector<Frame> &frames, bool &crcOk) {
+  FILE *in = fopen(path, "r");
+  if (in == NULL) {
+    fprintf(stderr, "can not open %s\n", path);
+    return (false);
+  }
+
+  char line[2048];
+  unsigned lineNo = 0;
+  crcOk = true;
+
+  while (fgets(line, sizeof(line), in) != NULL) {
+    lineNo++;
+    char *hash = strchr(line, '#');
+    if (hash != NULL)
+      *hash = '\0';
+
+    char *tag = strstr(line, "+crc");
+    bool addCrc = tag != NULL;
+    if (addCrc)
+      *tag = '\0';
+
+    Frame f;
+    for (char *p = line; *p;) {
+      if (!isxdigit((unsigned char)*p)) {
+        p++; // separator or bracket
+        continue;
+      }
+      char *end;
+      f.push_back((uint8_t)strtoul(p, &end, 16));
+      p = end;
+    }
+
+    if (f.empty())
+      continue;
+
+    if (f.size() < 5 || f[0] != 0xFF || f.size() != (size_t)f[1] + (addCrc ? 5 : 7)) {
+      fprintf(stderr, "%s:%u: not a complete frame (%u bytes)\n", path, lineNo, (unsigned)f.size());
+      crcOk = false;
+      continue;
+    }
+
+    if (addCrc)
+      appendCrc(f);
+    else {
+      uint16_t crc = rfid.calculateCRC(&f[1], f.size() - 3);
+      if (f[f.size() - 2] != (crc >> 8) || f[f.size() - 1] != (crc & 0xFF)) {
+        fprintf(stderr, "%s:%u: CRC %02X%02X, library computes %04X\n", path, lineNo,
+                f[f.size() - 2], f[f.size() - 1], crc);
+        crcOk = false;
+      }
+    }
+
+    frames.push_back(f);
+  }
+
+  fclose(in);
+  return (true);
+}
+
+// A continuous read tag record with the fields in metadata, 96-bit EPC.
+// option is the echoed option byte: 0x10, plus the select type with a
+// Gen2 Select (0x14 for the sketch's EPC prefix)
+static Frame tagFrame(uint8_t option, uint16_t metadata, uint16_t tag, int8_t rssi, uint32_t timestamp) {
+  Frame f = {0xFF, 0, TMR_SR_OPCODE_READ_TAG_ID_MULTIPLE, 0x00, 0x00,
+             option, 0x00, 0x1B, (uint8_t)(metadata >> 8), (uint8_t)metadata, 0x01};
+
+  if (metadata & TMR_TRD_METADATA_FLAG_READCOUNT)
+    f.push_back(1);
+  if (metadata & TMR_TRD_METADATA_FLAG_RSSI)
+    f.push_back((uint8_t)rssi);
+  if (metadata & TMR_TRD_METADATA_FLAG_ANTENNAID)
+    f.push_back(0x11);
+  if (metadata & TMR_TRD_METADATA_FLAG_FREQUENCY) {
+    uint32_t khz = 902750 + (tag % 50) * 500;
+    f.insert(f.end(), {(uint8_t)(khz >> 16), (uint8_t)(khz >> 8), (uint8_t)khz});
+  }
+  if (metadata & TMR_TRD_METADATA_FLAG_TIMESTAMP)
+    f.insert(f.end(), {(uint8_t)(timestamp >> 24), (uint8_t)(timestamp >> 16), (uint8_t)(timestamp >> 8), (uint8_t)timestamp});
+  if (metadata & TMR_TRD_METADATA_FLAG_PHASE)
+    f.insert(f.end(), {0x00, (uint8_t)(tag * 7)});
+  if (metadata & TMR_TRD_METADATA_FLAG_PROTOCOL)
+    f.push_back(0x05);
+  if (metadata & TMR_TRD_METADATA_FLAG_DATA)
+    f.insert(f.end(), {0x00, 0x00});
+  for (uint16_t flag = TMR_TRD_METADATA_FLAG_GPIO_STATUS; flag <= TMR_TRD_METADATA_FLAG_GEN2_TARGET; flag <<= 1)
+    if (metadata & flag)
+      f.push_back(0x00);
+  if (metadata & TMR_TRD_METADATA_FLAG_BRAND_IDENTIFIER)
+    f.insert(f.end(), {0x00, 0x00});
+
+  // EPC length in bits with PC and EPC CRC, PC, EPC, EPC CRC
+  f.insert(f.end(), {0x00, 0x80, 0x30, 0x00,
+                     0xE2, 0x80, 0x68, 0x94, 0x00, 0x00, 0x40, 0x33, 0x56, 0x39,
+                     (uint8_t)(tag >> 8), (uint8_t)tag,
+                     0x12, 0x34});
+
+  f[1] = f.size() - 5;
+  appendCrc(f);
+  return (f);
+}
+
+static Frame keepAliveFrame(void) {
+  Frame f = {0xFF, 0x00, TMR_SR_OPCODE_READ_TAG_ID_MULTIPLE, 0x04, 0x00};
+  appendCrc(f);
+  return (f);
+}
+
+static Frame throttleFrame(void) {
+  Frame f = {0xFF, 0x00, TMR_SR_OPCODE_READ_TAG_ID_MULTIPLE, 0x05, 0x04};
+  appendCrc(f);
+  return (f);
+}
+
+static Frame startCommand; // the last 0x2F command the library sent
+
+// The simulated module: every command succeeds, with no data
+static void answerCommand(SimStream &sim, const uint8_t *frame, size_t len) {
+  if (frame[2] == TMR_SR_OPCODE_MULTI_PROTOCOL_TAG_OP)
+    startCommand.assign(frame, frame + len);
+
+  Frame f = {0xFF, 0x00, frame[2], 0x00, 0x00};
+  appendCrc(f);
+  sim.send(f.data(), f.size());
+  sim.releaseAll();
+}
+
+static void usage(void) {
+  fprintf(stderr,
+          "parser_bench [--continuous 1] (--replay FILE [--repeat N] |\n"
+          "             --synth N [--tags K] [--metadata HEX] [--option HEX] [--keepalive M] [--throttle M])\n"
+          "             [--split MAX] [--corrupt PERMILLE] [--drop PERMILLE] [--rate FPS] [--seed S]\n");
+}
+
+int main(int argc, char **argv) {
+  const char *replay = NULL;
+  unsigned long repeat = 1, synth = 0, tags = 16, keepAlive = 0, rate = 0, seed = 1;
+  unsigned long split = 0, corrupt = 0, drop = 0, throttle = 0, continuous = 0;
+  uint8_t option = TMR_SR_GEN2_SINGULATION_OPTION_FLAG_METADATA;
+  uint16_t metadata = TMR_TRD_METADATA_FLAG_RSSI | TMR_TRD_METADATA_FLAG_ANTENNAID;
+
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    const char *val = i + 1 < argc ? argv[i + 1] : NULL;
+    if (val == NULL) {
+      usage();
+      return (2);
+    }
+    i++;
+
+    if (!strcmp(arg, "--replay")) replay = val;
+    else if (!strcmp(arg, "--repeat")) repeat = strtoul(val, NULL, 0);
+    else if (!strcmp(arg, "--synth")) synth = strtoul(val, NULL, 0);
+    else if (!strcmp(arg, "--tags")) tags = strtoul(val, NULL, 0);
+    else if (!strcmp(arg, "--metadata")) metadata = strtoul(val, NULL, 16);
+    else if (!strcmp(arg, "--option")) option = strtoul(val, NULL, 16);
+    else if (!strcmp(arg, "--keepalive")) keepAlive = strtoul(val, NULL, 0);
+    else if (!strcmp(arg, "--throttle")) throttle = strtoul(val, NULL, 0);
+    else if (!strcmp(arg, "--continuous")) continuous = strtoul(val, NULL, 0);
+    else if (!strcmp(arg, "--split")) split = strtoul(val, NULL, 0);
+    else if (!strcmp(arg, "--corrupt")) corrupt = strtoul(val, NULL, 0);
+    else if (!strcmp(arg, "--drop")) drop = strtoul(val, NULL, 0);
+    else if (!strcmp(arg, "--rate")) rate = strtoul(val, NULL, 0);
+    else if (!strcmp(arg, "--seed")) seed = strtoul(val, NULL, 0);
+    else {
+      usage();
+      return (2);
+    }
+  }
+
+  if ((replay == NULL) == (synth == 0) || tags == 0) {
+    usage();
+    return (2);
+  }
+
+  rfid.begin(link, ThingMagic_M7E_HECTO);
+  link.seed(seed);
+
+  if (continuous) {
+    link.onCommand = answerCommand;
+    rfid.startReading();
+    link.onCommand = NULL;
+    if (rfid.msg[0] != ALL_GOOD) {
+      printf("FAIL: startReading() not answered\n");
+      return (1);
+    }
+
+    // startReading() sends a prebuilt frame, it must be what the config
+    // builder makes of its defaults
+    uint8_t blob[CONT_READ_BLOB_MAX];
+    uint8_t len = ContinuousReadConfig().build(blob, sizeof(blob));
+    Frame built = {0xFF, len, TMR_SR_OPCODE_MULTI_PROTOCOL_TAG_OP};
+    built.insert(built.end(), blob, blob + len);
+    appendCrc(built);
+    if (startCommand != built) {
+      printf("FAIL: startReading() frame differs from ContinuousReadConfig().build()\n");
+      return (1);
+    }
+  }
+  link.setFaults(corrupt, drop);
+
+  // ── build the byte stream ──
+  std::vector<Frame> source;
+  bool crcOk = true;
+
+  if (replay != NULL) {
+    if (!loadCapture(replay, source, crcOk))
+      return (2);
+  } else {
+    for (unsigned long i = 0; i < synth; i++) {
+      if (keepAlive && i % keepAlive == keepAlive - 1)
+        source.push_back(keepAliveFrame());
+      else if (throttle && i % throttle == throttle - 1)
+        source.push_back(throttleFrame());
+      else
+        source.push_back(tagFrame(option, metadata, i % tags, -40 - (int8_t)(i % 30), i));
+    }
+    repeat = 1;
+  }
+
+  unsigned long framesSent = 0, tagsSent = 0, throttlesSent = 0;
+  for (unsigned long r = 0; r < repeat; r++) {
+    for (size_t i = 0; i < source.size(); i++) {
+      link.send(source[i].data(), source[i].size());
+      framesSent++;
+      if (isTagRecord(source[i]))
+        tagsSent++;
+      else if (isThrottle(source[i]))
+        throttlesSent++;
+    }
+  }
+
+  size_t totalBytes = link.queued();
+  double bytesPerFrame = framesSent ? (double)totalBytes / framesSent : 0;
+
+  // ── parse ──
+  unsigned long framesOut = 0, tagsOut = 0, keepAlives = 0, throttles = 0, badRecords = 0, checks = 0;
+  double start = seconds();
+
+  while (link.queued() > 0 || link.readable() > 0) {
+    if (rate > 0) {
+      // release what would have arrived by now on a link at this frame rate
+      size_t due = (size_t)((seconds() - start) * rate * bytesPerFrame);
+      size_t arrived = totalBytes - link.queued();
+      if (due > arrived)
+        link.release(due - arrived);
+      else
+        delayMicroseconds(100);
+    } else
+      link.release(split ? 1 + link.random(split) : 256);
+
+    while (rfid.check()) {
+      framesOut++;
+      uint8_t type = rfid.parseResponse();
+      if (type == RESPONSE_IS_TAGFOUND)
+        tagsOut++;
+      else if (type == RESPONSE_IS_KEEPALIVE)
+        keepAlives++;
+      else if (type == RESPONSE_IS_TEMPTHROTTLE)
+        throttles++;
+      else if (type == ERROR_CORRUPT_RESPONSE)
+        badRecords++;
+    }
+    checks++;
+  }
+
+  double elapsed = seconds() - start;
+  RFIDStats stats;
+  rfid.getStats(stats);
+
+  printf("source:          %s%s\n", replay ? replay : "synthesized", continuous ? ", continuous read" : "");
+  printf("frames sent:     %lu (%lu tag records, %.1f bytes/frame)\n", framesSent, tagsSent, bytesPerFrame);
+  printf("faults:          %u corrupted, %u truncated\n", link.framesCorrupted(), link.framesTruncated());
+  printf("frames parsed:   %lu (%lu tags, %lu keep-alives, %lu throttles, %lu corrupt records)\n",
+         framesOut, tagsOut, keepAlives, throttles, badRecords);
+  printf("parser:          %u CRC errors, %u resyncs, %u throttles counted, %lu check() rounds\n",
+         stats.crcErrors, stats.resyncs, stats.thermalThrottles, checks);
+  printf("time:            %.3f s\n", elapsed);
+  if (elapsed > 0)
+    printf("throughput:      %.0f frames/s, %.2f MB/s\n", framesOut / elapsed, totalBytes / elapsed / 1e6);
+
+  if (!crcOk) {
+    printf("FAIL: capture CRC mismatch\n");
+    return (1);
+  }
+  bool clean = corrupt == 0 && drop == 0 && link.framesCorrupted() == 0;
+  if (clean && tagsOut != tagsSent) {
+    printf("FAIL: %lu of %lu tag records decoded\n", tagsOut, tagsSent);
+    return (1);
+  }
+  if (clean && throttles != throttlesSent) {
+    printf("FAIL: %lu of %lu throttle notices came through\n", throttles, throttlesSent);
+    return (1);
+  }
+  if (clean && stats.thermalThrottles != throttlesSent) {
+    printf("FAIL: %u of %lu throttle notices counted in getStats()\n", stats.thermalThrottles, throttlesSent);
+    return (1);
+  }
+
+  printf("OK\n");
+  return (0);
+}
@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+"""
+Decoder for the binary scan log gen2.ino sends (src/ScanLog.h)
+
+Listens for the UDP batches and prints one line per record, or appends
+every received packet to a file first (--save) so a capture can be decoded
+again later (--read). Lost packets (sequence gaps) and records the reader
+dropped are reported per unit.
+
+    ./scanlog_decode.py                        # listen on 5010, print lines
+    ./scanlog_decode.py --csv >> reads.csv     # same, as CSV
+    ./scanlog_decode.py --save scan.log        # keep the raw packets too
+    ./scanlog_decode.py --read scan.log --csv  # decode a saved capture
+
+A saved capture is the packets back to back, each one prefixed by its
+length as 2 bytes little endian.
+"""
+
+import argparse
+import socket
+import struct
+import sys
+
+VERSION = 1
+HEADER = struct.Struct("<2sBBIIHH")  # magic, version, record bytes, unit, sequence, count, dropped
+RECORD = struct.Struct("<IIHhbBBB")  # ms, value, freq, phase, rssi, antenna, type, index
+
+TAG, SCAN_BEGIN, SCAN_END, THROTTLE = 1, 2, 3, 4
+TYPE_NAMES = {TAG: "tag", SCAN_BEGIN: "scan_begin", SCAN_END: "scan_end", THROTTLE: "throttle"}
+NO_INDEX = 0xFF
+
+# the record fields as they are (see src/ScanLog.h for what they carry per
+# type), except freq: kHz for tag records
+CSV_FIELDS = "unit,seq,ms,type,value,freq,phase,rssi,antenna,index"
+
+
+def records(packet):
+    """(header fields, list of record tuples), or None if it is not a scan log packet"""
+    if len(packet) < HEADER.size:
+        return None
+    magic, version, size, unit, seq, count, dropped = HEADER.unpack_from(packet)
+    if magic != b"SL" or version != VERSION or size != RECORD.size:
+        return None
+    if len(packet) < HEADER.size + count * size:
+        return None
+    recs = [RECORD.unpack_from(packet, HEADER.size + i * size) for i in range(count)]
+    return (unit, seq, dropped), recs
+
+
+def line(unit, seq, rec, csv):
+    ms, value, freq, phase, rssi, antenna, kind, index = rec
+    name = TYPE_NAMES.get(kind, "type%d" % kind)
+
+    if csv:
+        if kind == TAG:
+            return "%08x,%u,%u,%s,%08x,%u,%d,%d,%u,%s" % (
+                unit, seq, ms, name, value, freq * 25, phase, rssi, antenna, "" if index == NO_INDEX else index)
+        return "%08x,%u,%u,%s,%u,%u,%d,%d,%u,%u" % (unit, seq, ms, name, value, freq, phase, rssi, antenna, index)
+
+    head = "%08x %10u ms  " % (unit, ms)
+    if kind == TAG:
+        puck = "-" if index == NO_INDEX else str(index)
+        return head + "tag %08x puck %s  %4d dBm  ant %d/%d  %7.3f MHz  phase %d" % (
+            value, puck, rssi, antenna >> 4, antenna & 0x0F, freq * 25 / 1000.0, phase)
+    if kind == SCAN_BEGIN:
+        return head + "scan %u begins, %d dBm, ant %d" % (value, rssi, antenna >> 4)
+    if kind == SCAN_END:
+        return head + "scan ends after %u ms: %d unique tags, %u pucks, combo 0x%x" % (freq, phase, index, value)
+    return head + name
+
+
+class Decoder:
+    def __init__(self, csv, out):
+        self.csv = csv
+        self.out = out
+        self.next_seq = {}
+
+    def packet(self, packet):
+        parsed = records(packet)
+        if parsed is None:
+            sys.stderr.write("not a scan log packet (%d bytes)\n" % len(packet))
+            return
+        (unit, seq, dropped), recs = parsed
+
+        expected = self.next_seq.get(unit)
+        if expected is not None and seq != expected:
+            if seq == 0:
+                sys.stderr.write("%08x restarted\n" % unit)
+            else:
+                sys.stderr.write("%08x lost %d packet(s)\n" % (unit, (seq - expected) & 0xFFFFFFFF))
+        self.next_seq[unit] = (seq + 1) & 0xFFFFFFFF
+        if dropped:
+            sys.stderr.write("%08x dropped %d record(s), ring full\n" % (unit, dropped))
+
+        for rec in recs:
+            self.out.write(line(unit, seq, rec, self.csv) + "\n")
+        self.out.flush()
+
+
+def read_capture(path, decoder):
+    with open(path, "rb") as f:
+        while True:
+            size = f.read(2)
+            if len(size) < 2:
+                return
+            packet = f.read(struct.unpack("<H", size)[0])
+            decoder.packet(packet)
+
+
+def listen(port, decoder, save):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind(("", port))
+    sys.stderr.write("listening on UDP %d\n" % port)
+
+    while True:
+        packet, _ = sock.recvfrom(2048)
+        if save is not None:
+            save.write(struct.pack("<H", len(packet)) + packet)
+            save.flush()
+        decoder.packet(packet)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="decode the gen2.ino scan log")
+    parser.add_argument("--port", type=int, default=5010, help="UDP port to listen on (LOG_HOST_UDP_PORT)")
+    parser.add_argument("--read", metavar="FILE", help="decode a capture saved with --save instead of listening")
+    parser.add_argument("--save", metavar="FILE", help="append the raw packets to FILE")
+    parser.add_argument("--csv", action="store_true", help="CSV instead of text lines")
+    args = parser.parse_args()
+
+    decoder = Decoder(args.csv, sys.stdout)
+    if args.csv:
+        sys.stdout.write(CSV_FIELDS + "\n")
+
+    try:
+        if args.read:
+            read_capture(args.read, decoder)
+        else:
+            save = open(args.save, "ab") if args.save else None
+            listen(args.port, decoder, save)
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,181 @@
+/**
+ * Interactive: building up to Beaker Interactive
+ * File: provision.ino
+ * Description: writes puck IDs to a tray of new pucks on the bench reader
+ *
+ * Author: Isai Sanchez (library written by paulvha)
+ * Board used: Waveshare's ESP32-S3-ETH module
+ * Notes:
+ * - Put the tray on the antenna and send 'p'. The sketch inventories for
+ *   INVENTORY_MS, gives the tags found consecutive IDs from nextId (in EPC
+ *   order, so the same tray always gets the same IDs) and writes each ID
+ *   to user memory word PUCK_ID_WORD, where gen2.ino reads it with
+ *   READ_PUCK_ID. Every write is read back before it counts.
+ * - Each write and read back selects its tag by EPC, so the rest of the
+ *   tray stays out of it. They run back to back through the library's
+ *   command queue (provisionTags()).
+ * - Send 'n<id>' to set the next ID (e.g. n1 for a fresh set), 'p' again
+ *   to retry the tags that failed: tags that already hold their ID
+ *   verify fine and are not counted twice.
+ * - `src` is a link to ../src, the same library the gen2 sketch uses.
+ *
+ * (c) Thanksgiving Point Exhibits Electronics Team — 2025
+*/
+
+#include "src/SparkFun_UHF_RFID_Reader.h"
+
+// ===== HARDWARE CONFIG =====
+#define RFID_REGION REGION_NORTHAMERICA
+
+constexpr uint32_t RFID_BAUD = 115200;       // Module power-on default, the link starts here
+constexpr long RFID_MAX_BAUD = 921600;       // negotiateBaud() goes as high as this
+constexpr size_t RFID_UART_RX_BUFFER = 2048;
+constexpr uint8_t RXD1 = 18;  // ESP32-S3 RX ← M7E TXO
+constexpr uint8_t TXD1 = 17;  // ESP32-S3 TX → M7E RXI
+
+// ===== PROVISIONING CONFIG =====
+constexpr uint8_t TRAY_MAX = 48;          // tags per run
+constexpr uint16_t INVENTORY_MS = 1500;   // time to collect the tray's EPCs
+constexpr uint8_t PUCK_ID_WORD = 0;       // must match gen2.ino
+constexpr int16_t READ_POWER = 1500;      // low: the tray only, not the rest of the bench
+constexpr int16_t WRITE_POWER = 1500;
+
+ProvisionTag tray[TRAY_MAX];
+uint16_t nextId = 1;
+
+RFID rfidModule;
+
+// ─── Module Initialization ──────────────────────────────────────────────────
+bool initializeModule() {
+  rfidModule.begin(Serial1, ThingMagic_M7E_HECTO);
+
+  long baud = rfidModule.negotiateBaud(RFID_MAX_BAUD);
+  if (baud == 0) {
+    return false;
+  }
+
+  rfidModule.setTagProtocol();
+  rfidModule.setAntennaPort();
+  rfidModule.setRegion(RFID_REGION);
+  rfidModule.setReadPower(READ_POWER);
+  rfidModule.setWritePower(WRITE_POWER);
+  rfidModule.setGen2Session(TMR_GEN2_SESSION_S0);  // every tag answers every round
+
+  // selected writes are long, the next one waits in the module's FIFO
+  rfidModule.setCommandWindow(2);
+  return true;
+}
+
+// ─── Provisioning ───────────────────────────────────────────────────────────
+void printId(const ProvisionTag &tag) {
+  for (uint8_t i = 0; i < tag.idLen; i++) {
+    if (tag.id[i] < 0x10) Serial.print('0');
+    Serial.print(tag.id[i], HEX);
+  }
+}
+
+const __FlashStringHelper *resultString(uint8_t result) {
+  switch (result) {
+    case PROVISION_OK: return F("OK");
+    case PROVISION_WRITE_FAILED: return F("write failed");
+    case PROVISION_READ_FAILED: return F("read back failed");
+    case PROVISION_MISMATCH: return F("read back differs");
+    case PROVISION_TIMEOUT: return F("no response");
+  }
+  return F("not run");
+}
+
+void provisionTray() {
+  uint8_t count = rfidModule.inventoryTags(tray, TRAY_MAX, INVENTORY_MS);
+  Serial.print(F("\nTray: "));
+  Serial.print(count);
+  Serial.println(F(" tag(s)"));
+  if (count == 0) return;
+
+  // EPC order: IDs don't depend on which tag answered first
+  for (uint8_t i = 1; i < count; i++) {
+    ProvisionTag t = tray[i];
+    uint8_t j = i;
+    for (; j > 0 && memcmp(tray[j - 1].id, t.id, PROVISION_ID_BYTES) > 0; j--) tray[j] = tray[j - 1];
+    tray[j] = t;
+  }
+
+  for (uint8_t i = 0; i < count; i++) {
+    uint16_t id = nextId + i;
+    tray[i].dataLen = 2;
+    tray[i].data[0] = id >> 8;
+    tray[i].data[1] = id & 0xFF;
+  }
+
+  uint32_t start = millis();
+  uint8_t failed = rfidModule.provisionTags(tray, count, TMR_GEN2_BANK_USER, PUCK_ID_WORD);
+  uint32_t elapsed = millis() - start;
+
+  for (uint8_t i = 0; i < count; i++) {
+    const ProvisionTag &tag = tray[i];
+    Serial.print(F("  ID "));
+    Serial.print((uint16_t)(tag.data[0] << 8 | tag.data[1]));
+    Serial.print(F("  EPC "));
+    printId(tag);
+    Serial.print(F("  "));
+    Serial.print(resultString(tag.result));
+    if (tag.status != 0) {
+      Serial.print(F(" (status 0x"));
+      Serial.print(tag.status, HEX);
+      Serial.print(')');
+    }
+    Serial.println();
+  }
+
+  Serial.print(count - failed);
+  Serial.print('/');
+  Serial.print(count);
+  Serial.print(F(" written in "));
+  Serial.print(elapsed);
+  Serial.println(F(" ms"));
+
+  if (failed == 0) {
+    nextId += count;
+  } else {
+    Serial.println(F("Send 'p' to retry with the same IDs."));
+  }
+  Serial.print(F("Next ID: "));
+  Serial.println(nextId);
+}
+
+/*
+* =======================
+*         MAIN
+* =======================
+*/
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial) { delay(10); }
+
+  Serial.println(F("Puck provisioning"));
+
+  Serial1.setRxBufferSize(RFID_UART_RX_BUFFER);
+  Serial1.begin(RFID_BAUD, SERIAL_8N1, RXD1, TXD1);
+
+  if (!initializeModule()) {
+    Serial.println(F("FATAL: RFID module not responding. Check wiring and power."));
+    while (1) { delay(1000); }
+  }
+
+  Serial.println(F("Send 'p' to provision the tray, 'n<id>' to set the next ID."));
+}
+
+void loop() {
+  if (!Serial.available()) return;
+
+  char c = Serial.read();
+  if (c == 'p') {
+    provisionTray();
+  } else if (c == 'n') {
+    long id = Serial.parseInt();
+    if (id > 0 && id < 0xFFFF) nextId = id;
+    Serial.print(F("Next ID: "));
+    Serial.println(nextId);
+  }
+}
@@ -0,0 +1,117 @@
+/*
+  Time slicing of the inventory across antenna ports, see AntennaScheduler.h
+*/
+
+#include "AntennaScheduler.h"
+
+#include <string.h>
+
+AntennaScheduler::AntennaScheduler(void) { clear(); }
+
+void AntennaScheduler::clear(void) {
+  memset(_ports, 0, sizeof(_ports));
+  _count = 0;
+  _slot = 0xFF;
+}
+
+bool AntennaScheduler::addPort(uint8_t port, uint16_t dwellMs, uint8_t weight) {
+  if (weight == 0 || _count >= ANTENNA_SCHED_PORTS || _find(port) != NULL)
+    return (false);
+
+  AntennaPortState &p = _ports[_count++];
+  memset(&p, 0, sizeof(p));
+  p.port = port;
+  p.weight = weight;
+  p.dwellMs = dwellMs;
+  p.activity = ANTENNA_ACTIVITY_MAX;
+  return (true);
+}
+
+void AntennaScheduler::setLimits(uint16_t minDwellMs, uint16_t maxDwellMs) {
+  _minDwellMs = minDwellMs;
+  _maxDwellMs = maxDwellMs < minDwellMs ? minDwellMs : maxDwellMs;
+}
+
+void AntennaScheduler::reset(void) {
+  for (uint8_t i = 0; i < _count; i++) {
+    _ports[i].activity = ANTENNA_ACTIVITY_MAX;
+    _ports[i].current = 0;
+    _ports[i].newEpcs = 0;
+  }
+  _slot = 0xFF;
+}
+
+AntennaPortState *AntennaScheduler::_find(uint8_t port) {
+  for (uint8_t i = 0; i < _count; i++)
+    if (_ports[i].port == port)
+      return (&_ports[i]);
+  return (NULL);
+}
+
+void AntennaScheduler::tagRead(uint8_t antennaId, bool newEpc) {
+  AntennaPortState *p = _find(antennaId >> 4); // TX port
+
+  if (p == NULL && _slot < _count)
+    p = &_ports[_slot];
+  if (p == NULL)
+    return;
+
+  p->reads++;
+  if (newEpc) {
+    p->newEpcs++;
+    p->totalNew++;
+  }
+}
+
+uint16_t AntennaScheduler::_dwell(const AntennaPortState &p) const {
+  uint16_t base = p.dwellMs < _minDwellMs ? _minDwellMs : p.dwellMs;
+  uint32_t dwell = _minDwellMs + (uint32_t)(base - _minDwellMs) * p.activity / ANTENNA_ACTIVITY_MAX;
+
+  // still finding tags: stay longer, one base dwell more per new EPC
+  dwell += (uint32_t)p.newEpcs * base;
+
+  return (dwell > _maxDwellMs ? _maxDwellMs : (uint16_t)dwell);
+}
+
+uint8_t AntennaScheduler::next(uint16_t &dwellMs) {
+  dwellMs = 0;
+  if (_count == 0)
+    return (0);
+
+  // close the slot(s) that ran: activity follows the new EPCs
+  for (uint8_t i = 0; i < _count; i++) {
+    AntennaPortState &p = _ports[i];
+    bool ran = i == _slot || p.newEpcs > 0;
+    if (!ran)
+      continue;
+
+    if (p.newEpcs > 0) {
+      uint16_t a = p.activity + p.newEpcs * ANTENNA_ACTIVITY_STEP;
+      p.activity = a > ANTENNA_ACTIVITY_MAX ? ANTENNA_ACTIVITY_MAX : a;
+    } else
+      p.activity /= 2;
+  }
+
+  // smooth weighted round robin
+  int16_t total = 0;
+  uint8_t pick = 0;
+  for (uint8_t i = 0; i < _count; i++) {
+    AntennaPortState &p = _ports[i];
+    int16_t w = p.weight * (1 + p.activity / ANTENNA_ACTIVITY_STEP);
+    p.current += w;
+    total += w;
+    if (p.current > _ports[pick].current)
+      pick = i;
+  }
+  _ports[pick].current -= total;
+
+  // dwell uses the slot's result before it is cleared
+  AntennaPortState &p = _ports[pick];
+  dwellMs = _dwell(p);
+
+  for (uint8_t i = 0; i < _count; i++)
+    _ports[i].newEpcs = 0;
+
+  _slot = pick;
+  return (p.port);
+}
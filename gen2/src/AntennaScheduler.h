@@ -0,0 +1,101 @@
+/*
+  Time slicing of the inventory across antenna ports
+
+  The M7E reads one port at a time. With several stations (one antenna
+  per beaker) the sketch runs the continuous read in slots: one port per
+  slot, for the dwell time the scheduler picks. The scheduler does not
+  talk to the module; the sketch switches the port (setAntennaSearchList)
+  and restarts the read, feeds back every tag it sees and asks for the
+  next slot.
+
+  Each port has a base dwell time and a static weight. On top of that it
+  keeps an activity score, raised by new EPCs read on the port and halved
+  after every slot that found nothing new:
+
+    - dwell  = minDwell + (baseDwell - minDwell) * activity / ACTIVITY_MAX
+               (new EPCs in the last slot stretch it up to maxDwell)
+    - weight = static weight * (1 + activity / ACTIVITY_STEP)
+
+  Ports are picked by smooth weighted round robin, so every port keeps
+  being visited, but a station whose population is settled drops to short
+  minDwell probes and the time goes to the ones that still produce new
+  tags. Total inventory time then grows with the number of active
+  stations, not with the number of ports.
+
+  Ports start fully active, so the first pass gives every port its base
+  dwell.
+
+    AntennaScheduler antennas;
+    antennas.addPort(1, 200);
+    antennas.addPort(2, 200);
+    uint16_t dwell;
+    uint8_t port = antennas.next(dwell);
+    ... read on port for dwell ms, antennas.tagRead(rec.antenna, isNew) ...
+    port = antennas.next(dwell);   // closes the slot, picks the next one
+*/
+
+#ifndef ANTENNA_SCHEDULER_H
+#define ANTENNA_SCHEDULER_H
+
+#include <stdint.h>
+
+#define ANTENNA_SCHED_PORTS      8    // M7E supports up to 8 logical ports with a multiplexer
+#define ANTENNA_ACTIVITY_MAX   255
+#define ANTENNA_ACTIVITY_STEP   64    // activity per new EPC, and per extra unit of weight
+#define ANTENNA_MIN_DWELL_MS    30    // default minDwell: about one Gen2 round with a few tags
+#define ANTENNA_MAX_DWELL_MS  1000    // default maxDwell
+
+typedef struct AntennaPortState
+{
+  uint8_t port;         // logical port, 1-based as the module numbers them
+  uint8_t weight;       // static share, 1-255
+  uint16_t dwellMs;     // base dwell
+  uint8_t activity;     // recent new EPCs, decays per quiet slot
+  int16_t current;      // smooth weighted round robin counter
+  uint16_t newEpcs;     // this slot
+  uint32_t reads;       // tag reads on this port, all slots
+  uint32_t totalNew;    // new EPCs credited to this port, all slots
+} AntennaPortState;
+
+class AntennaScheduler
+{
+  public:
+    AntennaScheduler(void);
+
+    // false if the port is already in / the table is full / weight is 0
+    bool addPort(uint8_t port, uint16_t dwellMs, uint8_t weight = 1);
+    void clear(void);
+
+    // shortest probe of a quiet port and longest stretch of a busy one
+    void setLimits(uint16_t minDwellMs, uint16_t maxDwellMs);
+
+    // every port back to fully active (new population, e.g. a new scan)
+    void reset(void);
+
+    // close the running slot and pick the next one
+    // Returns the port (0 if no ports), dwellMs how long to read on it
+    uint8_t next(uint16_t &dwellMs);
+
+    // a tag record: antennaId as in the record (4MSB TX, 4LSB RX),
+    // newEpc = first read of this EPC. Records from another port than the
+    // slot's (multiplexer settling) are credited to the port they name
+    void tagRead(uint8_t antennaId, bool newEpc);
+
+    // port of the running slot, 0 before the first next()
+    uint8_t currentPort(void) const { return (_slot < _count ? _ports[_slot].port : 0); }
+
+    uint8_t portCount(void) const { return (_count); }
+    const AntennaPortState &portState(uint8_t i) const { return (_ports[i]); }
+
+  private:
+    AntennaPortState *_find(uint8_t port);
+    uint16_t _dwell(const AntennaPortState &p) const;
+
+    AntennaPortState _ports[ANTENNA_SCHED_PORTS];
+    uint8_t _count = 0;
+    uint8_t _slot = 0xFF;        // index of the running slot's port
+    uint16_t _minDwellMs = ANTENNA_MIN_DWELL_MS;
+    uint16_t _maxDwellMs = ANTENNA_MAX_DWELL_MS;
+};
+
+#endif
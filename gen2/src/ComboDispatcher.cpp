@@ -0,0 +1,47 @@
+/*
+  When to act on a puck combination, see ComboDispatcher.h
+*/
+
+#include "ComboDispatcher.h"
+
+ComboDispatcher::ComboDispatcher(uint16_t settleMs) : _settleMs(settleMs) {
+  reset();
+}
+
+void ComboDispatcher::reset(void) {
+  _mask = 0;
+  _dispatched = 0;
+  _pending = false;
+  _any = false;
+  _settledMs = 0;
+}
+
+void ComboDispatcher::update(uint32_t mask, uint32_t now) {
+  if (mask == _mask)
+    return;
+
+  _mask = mask;
+  _changedMs = now;
+  // back to what was dispatched last: nothing to do
+  _pending = !_any || mask != _dispatched;
+}
+
+bool ComboDispatcher::_fire(uint32_t now) {
+  _dispatched = _mask;
+  _any = true;
+  _pending = false;
+  _settledMs = now - _changedMs;
+  return (true);
+}
+
+bool ComboDispatcher::poll(uint32_t now) {
+  if (!_pending || now - _changedMs < _settleMs)
+    return (false);
+  return (_fire(now));
+}
+
+bool ComboDispatcher::flush(uint32_t now) {
+  if (_any && _mask == _dispatched)
+    return (false);
+  return (_fire(now));
+}
@@ -0,0 +1,63 @@
+/*
+  When to act on a puck combination
+
+  The combination in the beaker changes as tags come in: the first puck
+  is read, then the second a few ms later, ... Acting on every change
+  would start the wrong media; waiting for the end of the scan (and its
+  logging and LED timing) starts the right one late. The dispatcher sits in
+  between: it fires once the combination has not changed for settleMs, and
+  only if it differs from the one it fired for last. poll() does not block.
+
+  The sketch feeds it the current combination, and when poll() returns
+  true looks mask() up in its ComboTable and sends the action.
+
+    ComboDispatcher dispatcher(COMBO_SETTLE_MS);
+    dispatcher.reset();                      // new scan: the same combo may fire again
+    ... per change: dispatcher.update(comboMask, millis())
+    if (dispatcher.poll(millis())) send(combos.match(dispatcher.mask()));
+    ... end of the scan: if (dispatcher.flush(millis())) send(...)
+*/
+
+#ifndef COMBO_DISPATCHER_H
+#define COMBO_DISPATCHER_H
+
+#include <stdint.h>
+
+class ComboDispatcher
+{
+  public:
+    ComboDispatcher(uint16_t settleMs);
+
+    // forget what was dispatched, the next stable combination fires even if
+    // it is the same one (a new scan)
+    void reset(void);
+
+    // the combination now. Restarts the settle time if it changed
+    void update(uint32_t mask, uint32_t now);
+
+    // true once when the combination has been stable for settleMs and was
+    // not dispatched yet. mask() is the one to act on
+    bool poll(uint32_t now);
+
+    // dispatch the current combination without waiting (the scan is over)
+    // true if it was not dispatched yet
+    bool flush(uint32_t now);
+
+    uint32_t mask(void) const { return (_mask); }
+
+    // ms from the latest change to the dispatch, after poll() / flush()
+    uint32_t settledMs(void) const { return (_settledMs); }
+
+  private:
+    bool _fire(uint32_t now);
+
+    uint16_t _settleMs;
+    uint32_t _mask = 0;
+    uint32_t _changedMs = 0;
+    uint32_t _dispatched = 0;
+    bool _pending = false;     // a combination waiting to settle
+    bool _any = false;         // something was dispatched since reset()
+    uint32_t _settledMs = 0;
+};
+
+#endif
@@ -0,0 +1,68 @@
+/*
+  Compile-time table from puck combinations to actions
+
+  A combination is a bitmask with one bit per registered puck (PuckDef
+  comboId). Declare the actions once as a constexpr array of any struct
+  with a `uint32_t mask` member (plus whatever the action needs: the UDP
+  command, an LED pattern, ...). The constexpr constructor spreads them
+  into a lookup table with one slot per possible combination, so match()
+  is an array index, whatever the number of actions:
+
+    struct ComboAction { uint32_t mask; const char *command; };
+    constexpr ComboAction ACTIONS[] = { {0b0011, "water"}, {0b0101, "salt"}, ... };
+    constexpr ComboTable<ComboAction, 2, 4> combos(ACTIONS);   // 4 pucks
+    static_assert(combos.valid(), "two actions for one combination");
+
+    const ComboAction *a = combos.match(comboMask);   // NULL if none
+
+  BITS (the number of pucks) is at most COMBO_TABLE_MAX_BITS; the table
+  takes 2^BITS bytes.
+*/
+
+#ifndef COMBO_TABLE_H
+#define COMBO_TABLE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define COMBO_TABLE_MAX_BITS 8 // 256 byte table
+
+template <typename T, uint8_t N, uint8_t BITS>
+class ComboTable
+{
+  static_assert(N > 0 && N < 255, "ComboTable holds 1 - 254 actions");
+  static_assert(BITS > 0 && BITS <= COMBO_TABLE_MAX_BITS, "ComboTable covers 1 - 8 pucks");
+
+  public:
+    constexpr ComboTable(const T (&defs)[N]) : _defs(defs) {
+      for (uint8_t i = 0; i < N; i++) {
+        uint32_t mask = defs[i].mask;
+        if (mask >= SIZE || _lut[mask] != 0)
+          return; // outside the pucks, or a duplicate: valid() stays false
+        _lut[mask] = i + 1;
+      }
+      _valid = true;
+    }
+
+    // false if a mask is used twice or has bits beyond BITS
+    constexpr bool valid(void) const { return (_valid); }
+
+    constexpr uint8_t size(void) const { return (N); }
+    constexpr const T &operator[](uint8_t i) const { return (_defs[i]); }
+
+    // action for this combination, NULL if there is none
+    const T *match(uint32_t mask) const {
+      if (mask >= SIZE || _lut[mask] == 0)
+        return (NULL);
+      return (&_defs[_lut[mask] - 1]);
+    }
+
+  private:
+    static constexpr uint16_t SIZE = 1U << BITS;
+
+    const T *_defs;
+    uint8_t _lut[SIZE] {};  // mask -> action index + 1, 0 = no action
+    bool _valid = false;
+};
+
+#endif
@@ -0,0 +1,112 @@
+/*
+  Compile-time registry of known EPCs
+
+  Declare the known tags once as a constexpr array of any struct that has
+  a `uint8_t epc[EPC_REGISTRY_EPC_BYTES]` member (plus whatever else the
+  application needs: LED pin, name, ...). The constexpr constructor looks
+  for byte positions that tell the entries apart and builds a 256-entry
+  lookup table on them, all at compile time:
+
+    1. one byte position where every entry differs  -> key = epc[p]
+    2. otherwise two positions and a multiplier     -> key = epc[p] ^ epc[q] * m
+
+  match() then costs one or two byte loads, one table lookup and a memcmp
+  to reject unknown tags that happen to hash onto a known slot. The cost
+  does not grow with the number of registered entries.
+
+    struct PuckDef { uint8_t epc[12]; uint8_t ledPin; const char *name; };
+    constexpr PuckDef PUCK_DEFS[] = { {{0xE2, ...}, 1, "Yellow"}, ... };
+    constexpr EpcRegistry<PuckDef, 4> pucks(PUCK_DEFS);
+    static_assert(pucks.valid(), "puck EPCs are not unique");
+
+    int i = pucks.match(epc, epcLen);   // index in PUCK_DEFS, or -1
+*/
+
+#ifndef EPC_REGISTRY_H
+#define EPC_REGISTRY_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define EPC_REGISTRY_EPC_BYTES 12 // 96-bit EPC
+
+template <typename T, uint8_t N>
+class EpcRegistry
+{
+  static_assert(N > 0 && N < 255, "EpcRegistry holds 1 - 254 entries");
+
+  public:
+    constexpr EpcRegistry(const T (&defs)[N]) : _defs(defs) {
+      // 1. a single distinguishing byte
+      for (uint8_t p = 0; p < EPC_REGISTRY_EPC_BYTES; p++) {
+        if (_tryKey(p, p, 0)) return;
+      }
+
+      // 2. two bytes mixed with an odd multiplier
+      for (uint8_t p = 0; p < EPC_REGISTRY_EPC_BYTES; p++) {
+        for (uint8_t q = 0; q < EPC_REGISTRY_EPC_BYTES; q++) {
+          if (p == q) continue;
+          for (uint16_t m = 1; m < 256; m += 2) {
+            if (_tryKey(p, q, m)) return;
+          }
+        }
+      }
+      // nothing found (duplicate EPCs): valid() stays false
+    }
+
+    // false if no perfect key exists, i.e. two entries share an EPC
+    constexpr bool valid(void) const { return (_valid); }
+
+    constexpr uint8_t size(void) const { return (N); }
+    constexpr const T &operator[](uint8_t i) const { return (_defs[i]); }
+
+    // index of the entry with this EPC, or -1 if it is not registered
+    int match(const uint8_t *epc, uint8_t len) const {
+      if (len != EPC_REGISTRY_EPC_BYTES)
+        return (-1);
+
+      uint8_t slot = _lut[_key(epc)];
+      if (slot == 0)
+        return (-1);
+
+      if (memcmp(epc, _defs[slot - 1].epc, EPC_REGISTRY_EPC_BYTES) != 0)
+        return (-1);
+
+      return (slot - 1);
+    }
+
+  private:
+    constexpr uint8_t _key(const uint8_t *epc) const {
+      return (_mul == 0 ? epc[_p] : (uint8_t)(epc[_p] ^ (uint8_t)(epc[_q] * _mul)));
+    }
+
+    // use this key if no two entries collide on it, then fill the table
+    constexpr bool _tryKey(uint8_t p, uint8_t q, uint16_t m) {
+      _p = p;
+      _q = q;
+      _mul = (uint8_t)m;
+
+      for (uint8_t i = 1; i < N; i++) {
+        uint8_t k = _key(_defs[i].epc);
+        for (uint8_t j = 0; j < i; j++) {
+          if (_key(_defs[j].epc) == k)
+            return (false);
+        }
+      }
+
+      for (uint8_t i = 0; i < N; i++)
+        _lut[_key(_defs[i].epc)] = i + 1;
+
+      _valid = true;
+      return (true);
+    }
+
+    const T *_defs;
+    uint8_t _lut[256] {};  // key -> entry index + 1, 0 = not registered
+    uint8_t _p = 0;
+    uint8_t _q = 0;
+    uint8_t _mul = 0;      // 0 = single byte key
+    bool _valid = false;
+};
+
+#endif
@@ -0,0 +1,179 @@
+/*
+  Fixed-capacity EPC table with per-tag read statistics
+
+  Open addressing with linear probing over CAPACITY slots (power of 2).
+  The EPC hash is computed once per read and kept in the slot, so a probe
+  only falls back to memcmp() when the hashes already match. Lookup and
+  insert stay O(1) no matter how many tags are in the field, and there is
+  no heap: everything lives inside the object.
+
+  To keep probe chains short the table accepts at most 3/4 of CAPACITY
+  unique EPCs (maxEntries()). Entries can also be walked in the order they
+  were first seen with count() / entry(i), and clear() only touches the
+  slots that were used.
+
+  Typical use per scan:
+
+    EpcTable<64> seen;
+    seen.clear();
+    ...
+    bool isNew;
+    EpcStats *t = seen.record(epc, epcLen, rssi, antenna, millis(), &isNew);
+*/
+
+#ifndef EPC_TABLE_H
+#define EPC_TABLE_H
+
+#include <stdint.h>
+#include <string.h>
+
+#define EPC_TABLE_EPC_BYTES 12 // 96-bit EPC, longer EPCs are not stored
+
+typedef struct EpcStats
+{
+  /** The EPC tag */
+  uint8_t epc[EPC_TABLE_EPC_BYTES];
+
+  /** EPC length, 0 = free slot */
+  uint8_t epcLen;
+
+  /** antenna ID of the latest read */
+  uint8_t antenna;
+
+  /** weakest / strongest RSSI seen */
+  int8_t rssiMin;
+  int8_t rssiMax;
+
+  /** sum of all RSSI values, see rssiMean() */
+  int32_t rssiSum;
+
+  /** Number of times the tag was read */
+  uint32_t readCount;
+
+  /** millis() of the first and latest read */
+  uint32_t firstSeenMs;
+  uint32_t lastSeenMs;
+
+  /** EpcTable hash of the EPC */
+  uint32_t hash;
+
+  int8_t rssiMean(void) const { return (readCount ? rssiSum / (int32_t)readCount : 0); }
+} EpcStats;
+
+template <uint16_t CAPACITY>
+class EpcTable
+{
+  static_assert(CAPACITY >= 4 && (CAPACITY & (CAPACITY - 1)) == 0, "EpcTable capacity must be a power of 2");
+
+  public:
+    EpcTable(void) { memset(_slots, 0, sizeof(_slots)); }
+
+    // Hash of an EPC: whole 32-bit words mixed with a multiply, then a
+    // murmur3 style finalizer. A 96-bit EPC costs three word steps.
+    static uint32_t hashEpc(const uint8_t *epc, uint8_t len) {
+      uint32_t h = 0x9747B28Cu ^ len;
+      uint8_t i = 0;
+
+      for (; i + 4 <= len; i += 4) {
+        uint32_t w;
+        memcpy(&w, &epc[i], 4);
+        h = (h ^ w) * 0x5BD1E995u;
+        h ^= h >> 15;
+      }
+      for (; i < len; i++)
+        h = (h ^ epc[i]) * 0x01000193u;
+
+      h ^= h >> 16;
+      h *= 0x85EBCA6Bu;
+      h ^= h >> 13;
+      h *= 0xC2B2AE35u;
+      h ^= h >> 16;
+      return (h);
+    }
+
+    // Record a read: insert the EPC if new, update its statistics
+    // Returns NULL if the EPC is too long or the table is full.
+    // isNew (optional) tells whether this was the first read of the EPC
+    EpcStats *record(const uint8_t *epc, uint8_t len, int8_t rssi, uint8_t antenna, uint32_t ms, bool *isNew = NULL) {
+      if (isNew)
+        *isNew = false;
+
+      if (len == 0 || len > EPC_TABLE_EPC_BYTES)
+        return (NULL);
+
+      uint32_t hash = hashEpc(epc, len);
+      uint16_t slot = _probe(epc, len, hash);
+      EpcStats *t = &_slots[slot];
+
+      if (t->epcLen == 0) {
+        if (_count >= maxEntries())
+          return (NULL);
+
+        memcpy(t->epc, epc, len);
+        t->epcLen = len;
+        t->hash = hash;
+        t->rssiMin = t->rssiMax = rssi;
+        t->firstSeenMs = ms;
+        _order[_count++] = slot;
+
+        if (isNew)
+          *isNew = true;
+      }
+
+      if (rssi < t->rssiMin)
+        t->rssiMin = rssi;
+      if (rssi > t->rssiMax)
+        t->rssiMax = rssi;
+      t->rssiSum += rssi;
+      t->readCount++;
+      t->lastSeenMs = ms;
+      t->antenna = antenna;
+
+      return (t);
+    }
+
+    // Look up an EPC, NULL if not in the table
+    EpcStats *find(const uint8_t *epc, uint8_t len) {
+      if (len == 0 || len > EPC_TABLE_EPC_BYTES)
+        return (NULL);
+
+      EpcStats *t = &_slots[_probe(epc, len, hashEpc(epc, len))];
+      return (t->epcLen ? t : NULL);
+    }
+
+    // Number of unique EPCs, and the i-th one in order of first read
+    uint16_t count(void) const { return (_count); }
+    EpcStats &entry(uint16_t i) { return (_slots[_order[i]]); }
+    const EpcStats &entry(uint16_t i) const { return (_slots[_order[i]]); }
+
+    bool full(void) const { return (_count >= maxEntries()); }
+    static constexpr uint16_t maxEntries(void) { return (CAPACITY - CAPACITY / 4); }
+
+    // Forget all tags (only the used slots are wiped)
+    void clear(void) {
+      for (uint16_t i = 0; i < _count; i++)
+        memset(&_slots[_order[i]], 0, sizeof(EpcStats));
+      _count = 0;
+    }
+
+  private:
+    // slot holding epc, or the free slot where it would go
+    uint16_t _probe(const uint8_t *epc, uint8_t len, uint32_t hash) const {
+      uint16_t slot = hash & (CAPACITY - 1);
+
+      while (true) {
+        const EpcStats *t = &_slots[slot];
+        if (t->epcLen == 0)
+          return (slot);
+        if (t->hash == hash && t->epcLen == len && memcmp(t->epc, epc, len) == 0)
+          return (slot);
+        slot = (slot + 1) & (CAPACITY - 1); // table never fills, so this ends
+      }
+    }
+
+    EpcStats _slots[CAPACITY];
+    uint16_t _order[CAPACITY];  // slot of the i-th unique EPC
+    uint16_t _count = 0;
+};
+
+#endif
@@ -0,0 +1,67 @@
+/*
+  Gen2 inventory settings sized to the tag population, see Gen2Tuner.h
+*/
+
+#include "Gen2Tuner.h"
+
+Gen2Tuner::Gen2Tuner(const Gen2TunerPolicy &policy) : _policy(policy) {
+  if (_policy.maxQ > GEN2_TUNER_Q_MAX)
+    _policy.maxQ = GEN2_TUNER_Q_MAX;
+  reset();
+}
+
+void Gen2Tuner::reset(void) {
+  _estimate = _policy.minTags;
+  _lastUnique = 0;
+  _stable = 0;
+  _choose();
+  _changed = false;
+}
+
+void Gen2Tuner::scanResult(uint16_t uniqueTags, bool complete, uint32_t reads) {
+  uint32_t raw = uniqueTags;
+
+  // out of time with tags still coming: there were more. Few reads per
+  // tag means the rounds were spent on collisions, likely many more
+  if (!complete)
+    raw += reads < 2UL * uniqueTags ? uniqueTags : uniqueTags / 2 + 1;
+
+  if (raw < _policy.minTags)
+    raw = _policy.minTags;
+  if (raw > 0xFFFF)
+    raw = 0xFFFF;
+
+  // undersized rounds cost more than oversized ones: grow at once, shrink slowly
+  if (raw >= _estimate)
+    _estimate = raw;
+  else
+    _estimate = (_estimate + raw + 1) / 2;
+
+  if (complete && uniqueTags > 0 && uniqueTags == _lastUnique) {
+    if (_stable < 0xFF)
+      _stable++;
+  } else
+    _stable = complete && uniqueTags > 0 ? 1 : 0;
+  _lastUnique = uniqueTags;
+
+  Gen2Choice before = _choice;
+  _choose();
+  _changed = before.qType != _choice.qType || before.initQ != _choice.initQ ||
+             before.target != _choice.target;
+}
+
+void Gen2Tuner::_choose(void) {
+  uint8_t q = 0;
+  while (q < _policy.maxQ && (1U << q) < _estimate)
+    q++;
+
+  // static Q only on a settled, non-empty population. Q 0 is a single slot,
+  // two tags would answer in it on every round
+  bool fixed = _policy.stableScans > 0 && _stable >= _policy.stableScans;
+  if (fixed && q == 0)
+    q = 1;
+
+  _choice.qType = fixed ? TMR_SR_GEN2_Q_STATIC : TMR_SR_GEN2_Q_DYNAMIC;
+  _choice.initQ = q;
+  _choice.target = _estimate >= _policy.singleTargetTags ? TMR_GEN2_TARGET_A : TMR_GEN2_TARGET_AB;
+}
@@ -0,0 +1,98 @@
+/*
+  Gen2 inventory settings sized to the tag population
+
+  The initial Q sets the number of slots of the first inventory round
+  (2^Q). Too few and the tags collide, too many and the round is spent on
+  empty slots; either way the first rounds miss tags. The tuner estimates
+  the population from the previous scans and picks, before the next
+  startReading():
+
+    - initQ   - smallest Q with 2^Q >= estimate (one slot per tag is the
+                best a framed slotted ALOHA round does)
+    - qType   - static Q once stableScans complete scans in a row found the
+                same number of tags (the module's dynamic Q only costs
+                rounds then), dynamic otherwise
+    - target  - A for large populations (tags already read stay in B, the
+                rest get the slots), AB for small ones (rereads are cheap,
+                and tags left in B by the previous scan get read too)
+
+  The module reports neither collided nor empty slots in the stream, so
+  the estimate works from what a scan does show: the unique count, whether
+  the scan ran out of tags (quiet / all found) or out of time, and the
+  reads per tag. A scan cut off by the deadline still had tags to find;
+  one with less than two reads per tag was starved of slots, so the
+  collisions were likely heavy. Growth is taken at once, shrinking is
+  averaged over scans so a single empty scan does not drop Q to nothing.
+
+  The sketch applies the choice (setGen2Q() / setGen2Target() are
+  skipped by the config cache when unchanged):
+
+    Gen2Tuner tuner(TUNER_POLICY);
+    tuner.seed(profileChoice);               // Q / target the module starts with
+    ... scan ...
+    tuner.scanResult(uniqueTags, complete, reads);
+    if (tuner.changed()) {
+      rfid.setGen2Q(tuner.choice().qType, tuner.choice().initQ, true);
+      rfid.setGen2Target(tuner.choice().target);
+    }
+*/
+
+#ifndef GEN2_TUNER_H
+#define GEN2_TUNER_H
+
+#include <stdint.h>
+
+#include "SparkFun_UHF_RFID_Reader.h"
+
+#define GEN2_TUNER_Q_MAX  10   // largest initial Q setGen2Q() accepts
+
+typedef struct Gen2TunerPolicy {
+  uint8_t minTags;           // population floor (1 = at least one slot pair)
+  uint8_t maxQ;              // at most GEN2_TUNER_Q_MAX
+  uint8_t singleTargetTags;  // estimate at or above: target A instead of AB
+  uint8_t stableScans;       // equal complete scans before static Q, 0 = never static
+} Gen2TunerPolicy;
+
+typedef struct Gen2Choice {
+  TMR_SR_GEN2_QType qType;
+  uint8_t initQ;
+  TMR_GEN2_Target target;
+} Gen2Choice;
+
+class Gen2Tuner
+{
+  public:
+    Gen2Tuner(const Gen2TunerPolicy &policy);
+
+    // forget the population history, back to dynamic Q sized for minTags
+    void reset(void);
+
+    // what the module runs now (the boot profile): the next scanResult()
+    // reports changed() against it. The estimate is not touched
+    void seed(const Gen2Choice &current) { _choice = current; _changed = false; }
+
+    // result of the scan just finished: unique EPCs, complete = the scan
+    // stopped because it ran out of tags (not on the deadline), reads =
+    // tag reads in total. Updates choice()
+    void scanResult(uint16_t uniqueTags, bool complete, uint32_t reads);
+
+    const Gen2Choice &choice(void) const { return (_choice); }
+
+    // choice() differs from the one before the last scanResult()
+    bool changed(void) const { return (_changed); }
+
+    // population estimate the choice is sized for
+    uint16_t estimate(void) const { return (_estimate); }
+
+  private:
+    void _choose(void);
+
+    Gen2TunerPolicy _policy;
+    Gen2Choice _choice;
+    bool _changed = false;
+    uint16_t _estimate = 0;
+    uint16_t _lastUnique = 0;
+    uint8_t _stable = 0;       // complete scans in a row with the same count
+};
+
+#endif
@@ -0,0 +1,85 @@
+/*
+  Read power control between scans, see PowerController.h
+*/
+
+#include "PowerController.h"
+
+PowerController::PowerController(const PowerPolicy &policy) : _policy(policy) {
+  _power = _previous = policy.startPower;
+  if (_power < policy.minPower)
+    _power = _previous = policy.minPower;
+  if (_power > policy.maxPower)
+    _power = _previous = policy.maxPower;
+  beginScan();
+}
+
+void PowerController::beginScan(void) {
+  _found = 0;
+  _weakest = 0;
+  _foreign = 0;
+  _throttled = 0;
+}
+
+void PowerController::expectedTag(int8_t rssi) {
+  if (_found == 0 || rssi < _weakest)
+    _weakest = rssi;
+  if (_found < 0xFF)
+    _found++;
+}
+
+void PowerController::_move(int16_t delta, PowerChange reason) {
+  int16_t power = _power + delta;
+
+  if (power < _policy.minPower)
+    power = _policy.minPower;
+  if (power > _policy.maxPower)
+    power = _policy.maxPower;
+
+  _power = power;
+  _change = reason;
+}
+
+int16_t PowerController::endScan(uint8_t missing) {
+  _previous = _power;
+  _change = POWER_HOLD;
+
+  if (missing > 0) {
+    _cleanScans = 0;
+    _move(missing > 1 ? 2 * _policy.step : _policy.step, POWER_UP_MISSED);
+  }
+
+  else if (_found > 0 && _weakest < _policy.weakRssi) {
+    _cleanScans = 0;
+    _move(_policy.step, POWER_UP_WEAK);
+  }
+
+  else if (_throttled > 0) {
+    _cleanScans = 0;
+    _move(-_policy.step, POWER_DOWN_THROTTLE);
+  }
+
+  else {
+    if (_cleanScans < 0xFF)
+      _cleanScans++;
+
+    bool strong = _found > 0 && _weakest > _policy.strongRssi;
+    if (_cleanScans >= _policy.settleScans && (strong || _foreign > 0)) {
+      _cleanScans = 0;
+      _move(-_policy.step, strong ? POWER_DOWN_STRONG : POWER_DOWN_FOREIGN);
+    }
+  }
+
+  return (_power);
+}
+
+const char *PowerController::changeString(PowerChange change) {
+  switch (change) {
+    case POWER_HOLD:          return ("hold");
+    case POWER_UP_MISSED:     return ("up, tags missed");
+    case POWER_UP_WEAK:       return ("up, weak tag");
+    case POWER_DOWN_THROTTLE: return ("down, thermal throttle");
+    case POWER_DOWN_STRONG:   return ("down, all tags strong");
+    case POWER_DOWN_FOREIGN:  return ("down, foreign tags");
+  }
+  return ("unknown");
+}
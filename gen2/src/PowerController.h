@@ -0,0 +1,99 @@
+/*
+  Read power control between scans
+
+  Runs the lowest read power that still finds every expected tag. Less
+  power means fewer thermal throttles and less cross-talk from tags at the
+  neighbouring exhibits. The sketch reports what a scan saw and sets the
+  power endScan() returns (setReadPower() is skipped by the config cache
+  when it did not change).
+
+  Per scan, in this order of priority:
+    - an expected tag was missed            -> up by step (2 steps if > 1 missed)
+    - the weakest expected tag is weak      -> up by step
+      (its best RSSI below weakRssi, about to be missed)
+    - the module throttled                  -> down by step
+    - everything found, the weakest expected tag well above strongRssi,
+      or tags from outside the population  -> down by step, but only after
+      settleScans clean scans in a row (no hunting on a single good scan)
+    - otherwise                             -> hold
+
+  The power stays within [minPower, maxPower], all values centi-dBm like
+  setReadPower().
+
+    PowerController power(POWER_POLICY);
+    power.beginScan();
+    ... per expected tag found: power.expectedTag(stats.rssiMax)
+    ... per unexpected EPC: power.foreignTag(), per throttle: power.throttled()
+    int16_t next = power.endScan(missing);
+    if (power.changed()) rfid.setReadPower(next);
+*/
+
+#ifndef POWER_CONTROLLER_H
+#define POWER_CONTROLLER_H
+
+#include <stdint.h>
+
+typedef enum {
+  POWER_HOLD = 0,
+  POWER_UP_MISSED,      // expected tags missing
+  POWER_UP_WEAK,        // weakest expected tag close to the noise floor
+  POWER_DOWN_THROTTLE,  // module reported thermal throttling
+  POWER_DOWN_STRONG,    // every expected tag strong
+  POWER_DOWN_FOREIGN,   // reading tags outside the population
+} PowerChange;
+
+typedef struct PowerPolicy {
+  int16_t startPower;   // centi-dBm
+  int16_t minPower;
+  int16_t maxPower;     // 2700 on the M7E
+  int16_t step;
+  int8_t weakRssi;      // weakest expected tag below this: ramp up (dBm)
+  int8_t strongRssi;    // weakest expected tag above this: back off (dBm)
+  uint8_t settleScans;  // clean scans before backing off
+} PowerPolicy;
+
+class PowerController
+{
+  public:
+    PowerController(const PowerPolicy &policy);
+
+    // start collecting a scan
+    void beginScan(void);
+
+    // an expected tag was found, rssi = its best RSSI in the scan
+    void expectedTag(int8_t rssi);
+
+    // a tag outside the population was read (a neighbour's, or a stray)
+    void foreignTag(void) { _foreign++; }
+
+    // RESPONSE_IS_TEMPTHROTTLE received
+    void throttled(void) { _throttled++; }
+
+    // end of scan, missing = expected tags not found
+    // Returns the read power for the next scan
+    int16_t endScan(uint8_t missing);
+
+    int16_t power(void) const { return (_power); }
+    bool changed(void) const { return (_change != POWER_HOLD && _power != _previous); }
+    PowerChange lastChange(void) const { return (_change); }
+
+    // weakest expected tag of the last scan, 0 if none
+    int8_t weakestRssi(void) const { return (_found ? _weakest : 0); }
+
+    static const char *changeString(PowerChange change);
+
+  private:
+    void _move(int16_t delta, PowerChange reason);
+
+    PowerPolicy _policy;
+    int16_t _power;
+    int16_t _previous;
+    PowerChange _change = POWER_HOLD;
+    uint8_t _cleanScans = 0;   // scans in a row with everything found
+    uint8_t _found = 0;
+    int8_t _weakest = 0;
+    uint16_t _foreign = 0;
+    uint16_t _throttled = 0;
+};
+
+#endif
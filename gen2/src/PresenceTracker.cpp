@@ -0,0 +1,110 @@
+/*
+  Tag presence from a continuous read, see PresenceTracker.h
+*/
+
+#include <string.h>
+
+#include "PresenceTracker.h"
+
+PresenceTracker::PresenceTracker(const PresencePolicy &policy) : _policy(policy) {
+  if (_policy.arriveReads == 0)
+    _policy.arriveReads = 1;
+  if (_policy.departRssi > _policy.arriveRssi)
+    _policy.departRssi = _policy.arriveRssi;
+  clear();
+}
+
+void PresenceTracker::setCallbacks(PresenceCallback onArrive, PresenceCallback onDepart, void *ctx) {
+  _onArrive = onArrive;
+  _onDepart = onDepart;
+  _ctx = ctx;
+}
+
+void PresenceTracker::clear(void) {
+  memset(_tags, 0, sizeof(_tags));
+  _present = 0;
+  _used = 0;
+}
+
+int PresenceTracker::_find(const uint8_t *epc, uint8_t len, uint32_t hash) const {
+  for (uint8_t i = 0; i < PRESENCE_TRACKER_TAGS; i++) {
+    const PresenceTag &t = _tags[i];
+    if (t.epcLen == len && t.hash == hash && memcmp(t.epc, epc, len) == 0)
+      return (i);
+  }
+  return (-1);
+}
+
+bool PresenceTracker::isPresent(const uint8_t *epc, uint8_t len) const {
+  if (len == 0 || len > EPC_TABLE_EPC_BYTES)
+    return (false);
+
+  int i = _find(epc, len, EpcTable<4>::hashEpc(epc, len));
+  return (i >= 0 && _tags[i].present);
+}
+
+void PresenceTracker::tagRead(const uint8_t *epc, uint8_t len, int8_t rssi, uint32_t now) {
+  if (len == 0 || len > EPC_TABLE_EPC_BYTES)
+    return;
+
+  uint32_t hash = EpcTable<4>::hashEpc(epc, len);
+  int i = _find(epc, len, hash);
+
+  if (i < 0) {
+    if (rssi < _policy.arriveRssi || _used >= PRESENCE_TRACKER_TAGS)
+      return;
+
+    i = 0;
+    while (_tags[i].epcLen != 0)
+      i++;
+
+    PresenceTag &t = _tags[i];
+    memcpy(t.epc, epc, len);
+    t.epcLen = len;
+    t.hash = hash;
+    t.arrivedMs = now;
+    _used++;
+  }
+
+  PresenceTag &t = _tags[i];
+
+  // hysteresis: a present tag stays on weaker reads than it took to arrive
+  if (rssi < (t.present ? _policy.departRssi : _policy.arriveRssi))
+    return;
+
+  // arriving reads must follow each other within departMs
+  if (!t.present && t.reads > 0 && now - t.lastSeenMs >= _policy.departMs) {
+    t.reads = 0;
+    t.arrivedMs = now;
+  }
+
+  t.rssi = rssi;
+  t.lastSeenMs = now;
+  if (t.present)
+    return;
+
+  if (++t.reads >= _policy.arriveReads) {
+    t.present = true;
+    t.arrivedMs = now;
+    _present++;
+    if (_onArrive)
+      _onArrive(t, _ctx);
+  }
+}
+
+void PresenceTracker::poll(uint32_t now) {
+  for (uint8_t i = 0; i < PRESENCE_TRACKER_TAGS; i++) {
+    PresenceTag &t = _tags[i];
+    if (t.epcLen == 0 || now - t.lastSeenMs < _policy.departMs)
+      continue;
+
+    // an arriving tag that went quiet just frees its slot
+    if (t.present) {
+      _present--;
+      if (_onDepart)
+        _onDepart(t, _ctx);
+    }
+    memset(&t, 0, sizeof(t));
+    _used--;
+  }
+}
@@ -0,0 +1,112 @@
+/*
+  Tag presence from a continuous read
+
+  Instead of a scan per trigger, the reader keeps running and every tag
+  record is passed to tagRead(). The tracker turns the stream into two
+  events per tag:
+
+    onArrive  - arriveReads reads at or above arriveRssi, each within
+                departMs of the previous one (a single stray read of a tag
+                passing by does not count)
+    onDepart  - no read at or above departRssi for departMs
+
+  departRssi below arriveRssi is the hysteresis: a puck sitting at the
+  edge of the field, its RSSI going up and down by a few dB, arrives once
+  and then stays instead of flickering in and out. departMs bridges the
+  gaps between reads of a tag that is still there (collisions, session
+  flags, other tags taking the slots); it should be a few inventory rounds
+  at least.
+
+  poll() runs the departures and must be called regularly while the
+  reader runs: a paused reader looks like every tag leaving. Call clear() (no events) when the
+  reader is stopped on purpose.
+
+    PresenceTracker presence(PRESENCE_POLICY);
+    presence.setCallbacks(onArrive, onDepart, NULL);
+    ... per tag record: presence.tagRead(rec.epc, rec.epcLen, rec.rssi, rec.ms)
+    presence.poll(millis());
+
+  At most PRESENCE_TRACKER_TAGS tags at a time, arrived or arriving. Tags
+  read while the table is full are ignored until a slot frees up.
+*/
+
+#ifndef PRESENCE_TRACKER_H
+#define PRESENCE_TRACKER_H
+
+#include <stdint.h>
+
+#include "EpcTable.h"
+
+#define PRESENCE_TRACKER_TAGS 16
+
+typedef struct PresencePolicy {
+  uint8_t arriveReads;  // qualifying reads before onArrive (1 = the first one)
+  int8_t arriveRssi;    // dBm, reads below do not count towards arriving
+  int8_t departRssi;    // dBm, reads below do not keep a present tag (<= arriveRssi)
+  uint16_t departMs;    // no qualifying read for this long: onDepart
+} PresencePolicy;
+
+typedef struct PresenceTag
+{
+  /** The EPC tag */
+  uint8_t epc[EPC_TABLE_EPC_BYTES];
+
+  /** EPC length, 0 = free slot */
+  uint8_t epcLen;
+
+  /** onArrive was sent, waiting for onDepart */
+  bool present;
+
+  /** qualifying reads while arriving (stops counting at arriveReads) */
+  uint8_t reads;
+
+  /** RSSI of the latest qualifying read */
+  int8_t rssi;
+
+  /** millis() of the arrival (first qualifying read until then) and of the latest qualifying read */
+  uint32_t arrivedMs;
+  uint32_t lastSeenMs;
+
+  /** EpcTable hash of the EPC */
+  uint32_t hash;
+} PresenceTag;
+
+// tag holds the EPC; on onDepart its last RSSI and lastSeenMs
+typedef void (*PresenceCallback)(const PresenceTag &tag, void *ctx);
+
+class PresenceTracker
+{
+  public:
+    PresenceTracker(const PresencePolicy &policy);
+
+    void setCallbacks(PresenceCallback onArrive, PresenceCallback onDepart, void *ctx);
+
+    // a tag record, now = its timestamp. May call onArrive
+    void tagRead(const uint8_t *epc, uint8_t len, int8_t rssi, uint32_t now);
+
+    // departures and stale arrivals up to now. May call onDepart
+    void poll(uint32_t now);
+
+    // present tags, arrived and not departed
+    uint8_t present(void) const { return (_present); }
+    bool isPresent(const uint8_t *epc, uint8_t len) const;
+
+    // slot i (0 .. PRESENCE_TRACKER_TAGS - 1), epcLen 0 if free
+    const PresenceTag &slot(uint8_t i) const { return (_tags[i]); }
+
+    // forget all tags without events
+    void clear(void);
+
+  private:
+    int _find(const uint8_t *epc, uint8_t len, uint32_t hash) const;
+
+    PresencePolicy _policy;
+    PresenceCallback _onArrive = NULL;
+    PresenceCallback _onDepart = NULL;
+    void *_ctx = NULL;
+    PresenceTag _tags[PRESENCE_TRACKER_TAGS];
+    uint8_t _present = 0;
+    uint8_t _used = 0;    // slots in use (arrived or arriving)
+};
+
+#endif
@@ -0,0 +1,87 @@
+/*
+  Early-termination rules for a continuous-read scan, see ScanEngine.h
+*/
+
+#include "ScanEngine.h"
+
+ScanEngine::ScanEngine(const ScanCriteria &criteria) : _criteria(criteria) {
+  begin(0);
+}
+
+void ScanEngine::begin(uint32_t now) {
+  _reason = SCAN_RUNNING;
+  _startMs = now;
+  _stopMs = now;
+  _lastNewMs = now;
+  _newTags = 0;
+  _keepAlives = 0;
+  _quietRounds = 0;
+  _expectedSeen = 0;
+}
+
+void ScanEngine::tagRead(bool newEpc, bool expected, uint32_t now) {
+  if (done())
+    return;
+
+  if (expected && _expectedSeen < UINT8_MAX)
+    _expectedSeen++;
+  if (!newEpc)
+    return;
+
+  _newTags++;
+  _lastNewMs = now;
+  _quietRounds = 0;
+}
+
+void ScanEngine::keepAlive(uint32_t now) {
+  (void)now;
+  if (done())
+    return;
+
+  _keepAlives++;
+  if (_quietRounds < 0xFF)
+    _quietRounds++;
+}
+
+ScanStopReason ScanEngine::poll(uint32_t now) {
+  if (done())
+    return (_reason);
+
+  uint32_t elapsed = now - _startMs;
+
+  if (_criteria.expectedTags && _expectedSeen >= _criteria.expectedTags)
+    _stop(SCAN_STOP_ALL_FOUND, now);
+
+  else if (elapsed >= _criteria.deadlineMs)
+    _stop(SCAN_STOP_DEADLINE, now);
+
+  else if (elapsed >= _criteria.minScanMs) {
+    if (_criteria.quietRounds && _quietRounds >= _criteria.quietRounds)
+      _stop(SCAN_STOP_QUIET_ROUNDS, now);
+
+    else if (_criteria.quietMs && now - _lastNewMs >= _criteria.quietMs)
+      _stop(SCAN_STOP_QUIET_TIME, now);
+
+    else if (_criteria.maxKeepAlives && _keepAlives >= _criteria.maxKeepAlives)
+      _stop(SCAN_STOP_KEEPALIVE_LIMIT, now);
+  }
+
+  return (_reason);
+}
+
+void ScanEngine::_stop(ScanStopReason reason, uint32_t now) {
+  _reason = reason;
+  _stopMs = now;
+}
+
+const char *ScanEngine::reasonString(ScanStopReason reason) {
+  switch (reason) {
+    case SCAN_RUNNING:              return ("running");
+    case SCAN_STOP_ALL_FOUND:       return ("all expected tags found");
+    case SCAN_STOP_QUIET_ROUNDS:    return ("quiet rounds");
+    case SCAN_STOP_QUIET_TIME:      return ("no new tag");
+    case SCAN_STOP_KEEPALIVE_LIMIT: return ("keep-alive limit");
+    case SCAN_STOP_DEADLINE:        return ("deadline");
+  }
+  return ("unknown");
+}
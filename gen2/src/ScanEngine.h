@@ -0,0 +1,101 @@
+/*
+  Early-termination rules for a continuous-read scan
+
+  The engine does not talk to the module. Neither do the other helpers
+  in this directory (PowerController, Gen2Tuner, PresenceTracker,
+  ThermalScheduler, ComboDispatcher, ScanLog, ZoneClassifier): the sketch
+  does all the I/O. It feeds the engine the events it sees while
+  draining tag records and calls poll() in its loop; poll()
+  returns SCAN_RUNNING until one of the enabled criteria fires, and then
+  keeps returning that reason.
+
+  Criteria (0 disables a rule, the deadline is always active):
+    expectedTags  - stop once this many distinct expected tags were seen
+    quietRounds   - stop after N keep-alive rounds without a new EPC
+    quietMs       - stop when no new EPC appeared for this long
+    maxKeepAlives - stop after this many keep-alives in total
+    minScanMs     - the quiet / keep-alive rules never fire before this
+    deadlineMs    - hard limit
+
+  A keep-alive (RESPONSE_IS_KEEPALIVE) is the module's end-of-round message
+  when a search cycle found nothing, so it is the natural round counter.
+
+    ScanEngine scan(criteria);
+    scan.begin(millis());
+    while (scan.poll(millis()) == SCAN_RUNNING) {
+      ... scan.tagRead(isNew, isExpected, ms) / scan.keepAlive(ms) ...
+    }
+*/
+
+#ifndef SCAN_ENGINE_H
+#define SCAN_ENGINE_H
+
+#include <stdint.h>
+
+typedef enum {
+  SCAN_RUNNING = 0,
+  SCAN_STOP_ALL_FOUND,        // expectedTags seen
+  SCAN_STOP_QUIET_ROUNDS,     // quietRounds keep-alives without a new EPC
+  SCAN_STOP_QUIET_TIME,       // quietMs without a new EPC
+  SCAN_STOP_KEEPALIVE_LIMIT,  // maxKeepAlives reached
+  SCAN_STOP_DEADLINE,         // deadlineMs reached
+} ScanStopReason;
+
+typedef struct ScanCriteria {
+  uint8_t expectedTags;
+  uint8_t quietRounds;
+  uint16_t quietMs;
+  uint16_t maxKeepAlives;
+  uint16_t minScanMs;
+  uint32_t deadlineMs;
+} ScanCriteria;
+
+class ScanEngine
+{
+  public:
+    ScanEngine(const ScanCriteria &criteria);
+
+    // start (or restart) a scan at time now
+    void begin(uint32_t now);
+
+    // a tag record: newEpc = first read of this EPC in the scan,
+    // expected = it is one of the tags counted by expectedTags, once per
+    // tag (on the read it first counts, not necessarily its first read)
+    void tagRead(bool newEpc, bool expected, uint32_t now);
+
+    // RESPONSE_IS_KEEPALIVE received
+    void keepAlive(uint32_t now);
+
+    // evaluate the criteria, SCAN_RUNNING while the scan should go on
+    ScanStopReason poll(uint32_t now);
+
+    bool done(void) const { return (_reason != SCAN_RUNNING); }
+    ScanStopReason reason(void) const { return (_reason); }
+
+    // scan duration in ms, fixed once stopped
+    uint32_t elapsed(uint32_t now) const { return ((done() ? _stopMs : now) - _startMs); }
+
+    // ms from begin() to the latest new EPC, 0 if none
+    uint32_t lastNewTagMs(void) const { return (_newTags ? _lastNewMs - _startMs : 0); }
+
+    uint16_t newTags(void) const { return (_newTags); }
+    uint8_t expectedSeen(void) const { return (_expectedSeen); }
+    uint16_t keepAlives(void) const { return (_keepAlives); }
+
+    static const char *reasonString(ScanStopReason reason);
+
+  private:
+    void _stop(ScanStopReason reason, uint32_t now);
+
+    ScanCriteria _criteria;
+    ScanStopReason _reason;
+    uint32_t _startMs;
+    uint32_t _stopMs;
+    uint32_t _lastNewMs;      // latest new EPC, or begin()
+    uint16_t _newTags;
+    uint16_t _keepAlives;
+    uint8_t _quietRounds;     // keep-alives since the latest new EPC
+    uint8_t _expectedSeen;
+};
+
+#endif
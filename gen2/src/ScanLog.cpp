@@ -0,0 +1,115 @@
+/*
+  Binary scan log, see ScanLog.h
+*/
+
+#include <string.h>
+
+#include "ScanLog.h"
+#include "EpcTable.h"
+
+static void put16(uint8_t *p, uint16_t v) {
+  p[0] = v & 0xFF;
+  p[1] = v >> 8;
+}
+
+static void put32(uint8_t *p, uint32_t v) {
+  put16(p, v & 0xFFFF);
+  put16(p + 2, v >> 16);
+}
+
+void ScanLog::begin(uint8_t *storage, uint32_t bytes, uint32_t unit) {
+  _ring = storage;
+  _capacity = storage != NULL ? bytes / SCANLOG_RECORD_BYTES : 0;
+  _head = 0;
+  _count = 0;
+  _unit = unit;
+  _sequence = 0;
+  _dropped = 0;
+  _droppedSent = 0;
+  _packetDropped = 0;
+  _packetCount = 0;
+}
+
+bool ScanLog::add(const ScanLogRecord &rec) {
+  if (_count >= _capacity) {
+    _dropped++;
+    return (false);
+  }
+
+  uint8_t *p = &_ring[_head * SCANLOG_RECORD_BYTES];
+  put32(&p[0], rec.ms);
+  put32(&p[4], rec.value);
+  put16(&p[8], rec.freq);
+  put16(&p[10], (uint16_t)rec.phase);
+  p[12] = (uint8_t)rec.rssi;
+  p[13] = rec.antenna;
+  p[14] = rec.type;
+  p[15] = rec.index;
+
+  if (++_head == _capacity)
+    _head = 0;
+  _count++;
+  return (true);
+}
+
+bool ScanLog::tagRead(uint32_t ms, const uint8_t *epc, uint8_t epcLen, uint8_t index,
+                      int8_t rssi, uint8_t antenna, uint32_t freq, int16_t phase) {
+  ScanLogRecord rec;
+
+  rec.ms = ms;
+  rec.value = EpcTable<4>::hashEpc(epc, epcLen);
+  rec.freq = freq / 25;
+  rec.phase = phase;
+  rec.rssi = rssi;
+  rec.antenna = antenna;
+  rec.type = SCANLOG_TAG;
+  rec.index = index;
+  return (add(rec));
+}
+
+uint16_t ScanLog::packet(uint8_t *buf, uint16_t size) {
+  _packetCount = 0;
+  if (_count == 0 || size < SCANLOG_HEADER_BYTES + SCANLOG_RECORD_BYTES)
+    return (0);
+
+  uint32_t n = (size - SCANLOG_HEADER_BYTES) / SCANLOG_RECORD_BYTES;
+  if (n > SCANLOG_PACKET_RECORDS)
+    n = SCANLOG_PACKET_RECORDS;
+  if (n > _count)
+    n = _count;
+
+  _packetDropped = _dropped;
+  uint32_t dropped = _dropped - _droppedSent;
+
+  buf[0] = 'S';
+  buf[1] = 'L';
+  buf[2] = SCANLOG_VERSION;
+  buf[3] = SCANLOG_RECORD_BYTES;
+  put32(&buf[4], _unit);
+  put32(&buf[8], _sequence);
+  put16(&buf[12], n);
+  put16(&buf[14], dropped > 0xFFFF ? 0xFFFF : dropped);
+
+  // oldest first, in (at most) two pieces around the end of the ring
+  uint32_t tail = _head >= _count ? _head - _count : _head + _capacity - _count;
+  uint32_t first = _capacity - tail;
+  if (first > n)
+    first = n;
+  memcpy(&buf[SCANLOG_HEADER_BYTES], &_ring[tail * SCANLOG_RECORD_BYTES],
+         first * SCANLOG_RECORD_BYTES);
+  memcpy(&buf[SCANLOG_HEADER_BYTES + first * SCANLOG_RECORD_BYTES], &_ring[0],
+         (n - first) * SCANLOG_RECORD_BYTES);
+
+  _packetCount = n;
+  return (SCANLOG_HEADER_BYTES + n * SCANLOG_RECORD_BYTES);
+}
+
+void ScanLog::sent(void) {
+  if (_packetCount == 0)
+    return;
+
+  _count -= _packetCount;
+  _packetCount = 0;
+  _sequence++;
+  _droppedSent = _packetDropped;
+}
@@ -0,0 +1,124 @@
+/*
+  Binary scan log, buffered in RAM (or PSRAM) and sent in batches
+
+  Per tag read a fixed 16 byte record goes into a ring buffer: a few
+  stores in the read loop instead of a Serial line. When the sketch has
+  time (after a scan, every few seconds while reading) it takes the oldest
+  records out as packets for a log host, and the history outlives the
+  session. host/scanlog_decode.py turns the packets back into lines.
+
+  Record, little endian, SCANLOG_RECORD_BYTES:
+
+    offset  size  field
+     0      4     ms       millis() of the read / event
+     4      4     value    TAG: EPC hash, SCAN_BEGIN: scan number,
+                           SCAN_END: combination mask
+     8      2     freq     TAG: carrier in 25 kHz steps (0 = not in the
+                           record), SCAN_END: ms the scan took
+    10      2     phase    TAG: phase (0 = not in the record),
+                           SCAN_END: unique tags
+    12      1     rssi     TAG: dBm, SCAN_BEGIN: read power in dBm
+    13      1     antenna  TAG / SCAN_BEGIN: antenna ID (4MSB = TX, 4LSB = RX)
+    14      1     type     SCANLOG_xxx
+    15      1     index    TAG: puck index (SCANLOG_NO_INDEX = another tag),
+                           SCAN_END: pucks found
+
+  Packet: SCANLOG_HEADER_BYTES of header, then count records
+
+     0      2     'S' 'L'
+     2      1     SCANLOG_VERSION
+     3      1     SCANLOG_RECORD_BYTES
+     4      4     unit      set by begin(), tells the readers apart
+     8      4     sequence  +1 per packet, a gap is a lost packet
+    12      2     count     records that follow
+    14      2     dropped   records lost to a full ring since the previous packet
+
+  The sketch sends what packet() builds and then calls sent().
+
+    ScanLog scanLog;
+    scanLog.begin(storage, bytes, unit);       // ps_malloc() or a static array
+    ... per tag read: scanLog.tagRead(rec.ms, rec.epc, rec.epcLen, puck, rec.rssi, rec.antenna, rec.freq, rec.phase)
+    ... later:
+    uint8_t buf[SCANLOG_PACKET_BYTES];
+    uint16_t len;
+    while ((len = scanLog.packet(buf, sizeof(buf))) > 0 && udpSend(buf, len))
+      scanLog.sent();
+
+  A full ring drops new records (counted in dropped()) and keeps the ones
+  not sent yet.
+*/
+
+#ifndef SCAN_LOG_H
+#define SCAN_LOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SCANLOG_VERSION        1
+#define SCANLOG_RECORD_BYTES   16
+#define SCANLOG_HEADER_BYTES   16
+#define SCANLOG_PACKET_RECORDS 64   // 1040 byte packets, one Ethernet frame
+#define SCANLOG_PACKET_BYTES   (SCANLOG_HEADER_BYTES + SCANLOG_PACKET_RECORDS * SCANLOG_RECORD_BYTES)
+#define SCANLOG_NO_INDEX       0xFF
+
+typedef enum {
+  SCANLOG_TAG = 1,      // one tag read
+  SCANLOG_SCAN_BEGIN,   // trigger
+  SCANLOG_SCAN_END,     // stop rule fired
+  SCANLOG_THROTTLE,     // module throttled (RESPONSE_IS_TEMPTHROTTLE)
+} ScanLogType;
+
+typedef struct ScanLogRecord {
+  uint32_t ms;
+  uint32_t value;
+  uint16_t freq;
+  int16_t phase;
+  int8_t rssi;
+  uint8_t antenna;
+  uint8_t type;         // ScanLogType
+  uint8_t index;
+} ScanLogRecord;
+
+class ScanLog
+{
+  public:
+    ScanLog(void) {}
+
+    // bytes of storage (a multiple of SCANLOG_RECORD_BYTES is used). unit
+    // goes into every packet header. Forgets everything logged so far
+    void begin(uint8_t *storage, uint32_t bytes, uint32_t unit);
+
+    // false if the ring is full (or begin() was not called)
+    bool add(const ScanLogRecord &rec);
+
+    // a SCANLOG_TAG record, freq in kHz. The EPC is logged as its hash
+    bool tagRead(uint32_t ms, const uint8_t *epc, uint8_t epcLen, uint8_t index,
+                 int8_t rssi, uint8_t antenna, uint32_t freq, int16_t phase);
+
+    // header and up to SCANLOG_PACKET_RECORDS of the oldest records in buf.
+    // Returns the packet length, 0 if nothing is waiting (or size is too
+    // small for a record). The records stay until sent()
+    uint16_t packet(uint8_t *buf, uint16_t size);
+
+    // the packet from the last packet() went out: drop its records
+    void sent(void);
+
+    uint32_t count(void) const { return (_count); }
+    uint32_t capacity(void) const { return (_capacity); }
+    uint32_t dropped(void) const { return (_dropped); }
+    uint32_t sequence(void) const { return (_sequence); }
+
+  private:
+    uint8_t *_ring = NULL;
+    uint32_t _capacity = 0;   // records
+    uint32_t _head = 0;       // next record written
+    uint32_t _count = 0;
+    uint32_t _unit = 0;
+    uint32_t _sequence = 0;
+    uint32_t _dropped = 0;
+    uint32_t _droppedSent = 0;   // _dropped as of the last packet sent
+    uint32_t _packetDropped = 0; // _dropped as of the last packet()
+    uint16_t _packetCount = 0;   // records in the last packet()
+};
+
+#endif
@@ -52,8 +52,48 @@
 
 #include "SparkFun_UHF_RFID_Reader.h"
 
+#ifdef ARDUINO_ARCH_ESP32
+#include <Preferences.h>
+#endif
+
+// The commands that never change, CRC and all, see RFIDFrame
+typedef RFIDFrame<TMR_SR_OPCODE_VERSION> VersionFrame;
+
+// 00 00 = Timeout, currently ignored
+// 02 = Option - stop continuous reading
+typedef RFIDFrame<TMR_SR_OPCODE_MULTI_PROTOCOL_TAG_OP, 0x00, 0x00, 0x02> StopReadingFrame;
+
+// What ContinuousReadConfig() builds: search flags 0x011B, 1000 ms on, no
+// off time, metadata 0x01FF (read count up to GPIO status), temperature
+// statistics. Keep the two in step, parser_bench --continuous checks it
+typedef RFIDFrame<TMR_SR_OPCODE_MULTI_PROTOCOL_TAG_OP,
+                  0x00, 0x00, 0x01, 0x22, 0x00, 0x00, 0x05, 0x09, 0x22,
+                  0x10, 0x01, 0x1B, 0x03, 0xE8, 0x01, 0xFF, 0x01, 0x00> StartReadingFrame;
+
+// [key value form] [read filter] [on / off], see setReaderConfiguration()
+typedef RFIDFrame<TMR_SR_OPCODE_SET_READER_OPTIONAL_PARAMS, 0x01, 0x0C, 0x01> ReadFilterOnFrame;
+typedef RFIDFrame<TMR_SR_OPCODE_SET_READER_OPTIONAL_PARAMS, 0x01, 0x0C, 0x00> ReadFilterOffFrame;
+
+// [GEN2] [parameter] [value..] per TMR_GEN2_Session / TMR_GEN2_Target
+static const uint8_t *const gen2SessionFrames[] = {
+    RFIDFrame<TMR_SR_OPCODE_SET_PROTOCOL_PARAM, 0x05, 0x00, TMR_GEN2_SESSION_S0>::bytes,
+    RFIDFrame<TMR_SR_OPCODE_SET_PROTOCOL_PARAM, 0x05, 0x00, TMR_GEN2_SESSION_S1>::bytes,
+    RFIDFrame<TMR_SR_OPCODE_SET_PROTOCOL_PARAM, 0x05, 0x00, TMR_GEN2_SESSION_S2>::bytes,
+    RFIDFrame<TMR_SR_OPCODE_SET_PROTOCOL_PARAM, 0x05, 0x00, TMR_GEN2_SESSION_S3>::bytes,
+};
+
+static const uint8_t *const gen2TargetFrames[] = {
+    RFIDFrame<TMR_SR_OPCODE_SET_PROTOCOL_PARAM, 0x05, 0x01, 0x01, 0x00>::bytes, // A
+    RFIDFrame<TMR_SR_OPCODE_SET_PROTOCOL_PARAM, 0x05, 0x01, 0x01, 0x01>::bytes, // B
+    RFIDFrame<TMR_SR_OPCODE_SET_PROTOCOL_PARAM, 0x05, 0x01, 0x00, 0x00>::bytes, // AB
+    RFIDFrame<TMR_SR_OPCODE_SET_PROTOCOL_PARAM, 0x05, 0x01, 0x00, 0x01>::bytes, // BA
+};
+
 RFID::RFID(void) {
   // Constructor
+  memset(&_tag, 0, sizeof(_tag)); // no record decoded yet
+  resetStats();
+  invalidateConfigCache();        // nothing known about the module yet
   _continuousModeTemp =
       false;     // indicate measuring temperature in continuous mode
   _contTemp = 0; // store Temperature in continuous mode
@@ -66,6 +106,29 @@ void RFID::begin(Stream &serialPort, ThingMagic_Module_t moduleType) {
   _moduleType = moduleType; // Save the module type for later
 }
 
+#ifdef ARDUINO_ARCH_ESP32
+// Uses the ESP32 UART receive event to wake up sendCommand() the moment
+// response bytes arrive (onReceive() fires on FIFO threshold and on RX
+// idle, i.e. at the end of every frame) instead of polling with delay().
+void RFID::begin(HardwareSerial &serialPort, ThingMagic_Module_t moduleType) {
+  begin((Stream &)serialPort, moduleType);
+  _uart = &serialPort;
+
+  if (_rxSignal == NULL)
+    _rxSignal = xSemaphoreCreateBinary();
+
+  SemaphoreHandle_t signal = _rxSignal;
+  serialPort.onReceive([signal]() { xSemaphoreGive(signal); });
+
+  // the driver dropped bytes: they will show up as CRC errors / resyncs too
+  volatile uint32_t *overflows = &_uartOverflows;
+  serialPort.onReceiveError([overflows](hardwareSerial_error_t error) {
+    if (error == UART_FIFO_OVF_ERROR || error == UART_BUFFER_FULL_ERROR)
+      (*overflows)++;
+  });
+}
+#endif
+
 // Enable or disable the printing of sent/response HEX values.
 // Use this in conjunction with 'Transport Logging' from the Universal Reader
 // Assistant to see what they're doing that we're not
@@ -86,13 +149,119 @@ void RFID::disableDebugging(void) {
 // Returns response in the msg array
 void RFID::setBaud(long baudRate) {
   // Copy this setting into a temp data array
-  uint8_t size = sizeof(baudRate);
-  uint8_t data[size];
-  for (uint8_t x = 0; x < size; x++)
-    data[x] = (uint8_t)(baudRate >> (8 * (size - 1 - x)));
+  uint8_t data[sizeof(baudRate)];
+  for (uint8_t x = 0; x < sizeof(data); x++)
+    data[x] = (uint8_t)(baudRate >> (8 * (sizeof(data) - 1 - x)));
+
+  sendMessage(TMR_SR_OPCODE_SET_BAUD_RATE, data, sizeof(data));
+}
+
+#ifdef ARDUINO_ARCH_ESP32
+// rates the module supports, fastest first
+static const long baudRates[] = {921600, 460800, 230400, 115200, 57600, 38400, 19200, 9600};
+
+long RFID::savedBaud(void) {
+  Preferences prefs;
+  long baud = 0;
+
+  if (prefs.begin(RFID_PREFS, true)) {
+    baud = prefs.getLong(RFID_BAUD_PREFS_KEY, 0);
+    prefs.end();
+  }
+  return (baud);
+}
+
+// Switch the UART to baudRate and ask for the version `replies` times
+// A module that is still streaming tag records is stopped first
+bool RFID::_linkAt(long baudRate, uint8_t replies) {
+  _uart->updateBaudRate(baudRate);
+  while (_uart->available())
+    _uart->read();
+  _flushRing();
+
+  for (uint8_t i = 0; i < replies; i++) {
+    getVersion();
+
+    // framed fine, the module is just busy streaming 0x22 reads from a
+    // previous session: rate is right. stopReading() waits for the ack, so
+    // no fixed delay is needed, only tag frames still in flight to skip
+    for (uint8_t stop = 0; stop < RFID_STOP_RETRIES && msg[0] == ERROR_WRONG_OPCODE_RESPONSE; stop++) {
+      stopReading();
+      getVersion();
+    }
+
+    if (msg[0] != ALL_GOOD)
+      return (false);
+  }
+  return (true);
+}
+
+long RFID::probeBaud(long hint) {
+  if (_uart == NULL)
+    return (0);
+
+  if (hint > 0 && _linkAt(hint, 1))
+    return (hint);
+
+  // not where we left it, so it probably restarted: settings are gone too
+  invalidateConfigCache();
+
+  for (uint8_t i = 0; i < sizeof(baudRates) / sizeof(baudRates[0]); i++) {
+    if (baudRates[i] == hint)
+      continue;
+    if (_linkAt(baudRates[i], 1))
+      return (baudRates[i]);
+  }
+  return (0);
+}
+
+long RFID::negotiateBaud(long maxBaud, bool persist) {
+  long saved = savedBaud();
+  long current = probeBaud(saved);
+
+  if (current == 0)
+    return (0);
+
+  for (uint8_t i = 0; i < sizeof(baudRates) / sizeof(baudRates[0]); i++) {
+    long target = baudRates[i];
+
+    if (target > maxBaud)
+      continue;
+
+    if (target != current) {
+      setBaud(target); // acknowledged at the old rate, then the module switches
+      delay(RFID_BAUD_SETTLE_MS);
+    }
+
+    if (_linkAt(target, RFID_BAUD_VERIFY)) {
+      current = target;
+      break;
+    }
 
-  sendMessage(TMR_SR_OPCODE_SET_BAUD_RATE, data, size);
+    // not reliable at target: the module often still hears us even when
+    // its replies don't get through, so ask it to go back before looking
+    // for it again (it may also have refused the change), then step down
+    if (target != current) {
+      setBaud(current);
+      delay(RFID_BAUD_SETTLE_MS);
+    }
+
+    current = probeBaud(current);
+    if (current == 0)
+      return (0);
+  }
+
+  if (persist && current != saved) {
+    Preferences prefs;
+    if (prefs.begin(RFID_PREFS, false)) {
+      prefs.putLong(RFID_BAUD_PREFS_KEY, current);
+      prefs.end();
+    }
+  }
+
+  return (current);
 }
+#endif
 
 /* September 2020 special / paulvha
  *
@@ -112,11 +281,7 @@ void RFID::setBaud(long baudRate) {
  */
 void RFID::startReadingBank(uint8_t bank, uint32_t address, uint8_t length) {
 
-  /* Create special blob
-   * ff           header (added later on)
-   * 1f           message length (added later on)
-   * 2f           embedded read (added later on)
-   *
+  /* The blob ContinuousReadConfig builds for this:
    * 00 00        no timeouts
    * 01           embedded command
    * 22           opcode
@@ -136,22 +301,8 @@ void RFID::startReadingBank(uint8_t bank, uint32_t address, uint8_t length) {
    * 00 03        bank(s)
    * 00 00 00 00  start address
    * 00           number of words expected (zero == all)
-   *
-   * 84 35        CRC (added later on)
    */
 
-  uint8_t configBlob[30] = {0x00, 0x00, 0x01, 0x22, 0x00, 0x00, 0x05, 0x15,
-                            0x22, 0x10, 0x01, 0x1f, 0x00, 0xfa, 0x01, 0xff,
-                            0x01, 0x00, 0x01, 0x09, 0x28, 0x07, 0xd0, 0x00,
-                            0x03, 0x00, 0x00, 0x00, 0x00, 0x00};
-
-  // overwrite bank in configBlob
-  configBlob[24] = bank;
-
-  // set start address to read
-  for (uint8_t x = 0; x < sizeof(address); x++)
-    configBlob[25 + x] = address >> (8 * (3 - x)) & 0xFF;
-
   /*
    * 32 words is the maximum length with embedded read (datasheet page 58)
    * If more than 32 words an incorrect message is returned. (tried that and
@@ -169,15 +320,8 @@ void RFID::startReadingBank(uint8_t bank, uint32_t address, uint8_t length) {
    * You have to request less words.
    */
 
-  if (bank == TMR_GEN2_BANK_USER) {
-    if (length == 0 || length > 32)
-      length = 32;
-  } else {
-    if (length > 32)
-      length = 32;
-  }
-
-  configBlob[29] = length;
+  if (bank == TMR_GEN2_BANK_USER && length == 0)
+    length = CONT_READ_EMBEDDED_WORDS;
 
   // Sending:  ff 03 9a 01 08 00 a7 5d
   // This allows tags with the same EPC ID but different values in the specified
@@ -187,64 +331,394 @@ void RFID::startReadingBank(uint8_t bank, uint32_t address, uint8_t length) {
   uint8_t c2[] = {0x01, 0x08, 0x00};
   sendMessage(TMR_SR_OPCODE_SET_READER_OPTIONAL_PARAMS, c2, sizeof(c2));
 
-  disableReadFilter();
-
-  _continuousModeTemp = true;
-  _contTemp = 0; // reset temperature
-
-  sendMessage(TMR_SR_OPCODE_MULTI_PROTOCOL_TAG_OP, configBlob,
-              sizeof(configBlob));
+  ContinuousReadConfig config;
+  config.onTime(250).embeddedRead(bank, address, length);
+  startReading(config);
 }
 
 // Begin scanning for tags
 // There are many many options and features to the rfid reader, this sets
 // options for continuous read of GEN2 type tags
 void RFID::startReading() {
+  // The default config is the blob found by using the 'Transport Logs' option
+  // from the Universal Reader Assistant, with temperature statistics added
+  // May 2020 paulvh:
+  // 00 00 01 22 00 00 05 09 22 10 01 1B 03 E8 01 FF 01 00
+  // That is ContinuousReadConfig's default, prebuilt as StartReadingFrame
+  disableReadFilter(); // Don't filter for a specific tag, read all tags
+  _readStarting();
+  sendFrame(StartReadingFrame::bytes);
+}
+
+// Begin scanning for tags with the metadata / timing / stats in config
+void RFID::startReading(const ContinuousReadConfig &config) {
   disableReadFilter(); // Don't filter for a specific tag, read all tags
 
-  // This blob was found by using the 'Transport Logs' option from the Universal
-  // Reader Assistant And connecting the Nano eval kit from Thing Magic to the
-  // URA A lot of it has been deciphered but it's easier and faster just to pass
-  // a blob than to assemble every option and sub-opcode.
-
-  // added for streaming to provide temperature statistics.  May 2020 paulvh
-  //                                                               length add
-  //                                                               stats add
-  //                                                               stats_temp
-  uint8_t configBlob[] = {0x00, 0x00, 0x01, 0x22, 0x00, 0x00, 0x05, 0x09, 0x22,
-                          0x10, 0x01, 0x1B, 0x03, 0xE8, 0x01, 0xFF, 0x01, 0x00};
+  uint8_t configBlob[CONT_READ_BLOB_MAX];
+  uint8_t len = config.build(configBlob, sizeof(configBlob));
+  if (len == 0) {
+    msg[0] = ERROR_INVALID_REQ;
+    return;
+  }
+
+  _readStarting();
+  sendMessage(TMR_SR_OPCODE_MULTI_PROTOCOL_TAG_OP, configBlob, len);
+}
+
+void RFID::_readStarting(void) {
+  _holdHead = _holdTail = 0; // whatever a previous read left is stale now
   _continuousModeTemp = true;
   _contTemp = 0; // reset temperature
 
-  // original without temperature statistics
-  // uint8_t configBlob[] = {0x00, 0x00, 0x01, 0x22, 0x00, 0x00, 0x05, 0x07,
-  // 0x22, 0x10, 0x00, 0x1B, 0x03, 0xE8, 0x01, 0xFF};
+  // time to first / unique reads count from here
+  _readStartMs = millis();
+  _stats.firstReadMs = 0;
+  _stats.uniqueEpcs = 0;
+}
 
-  /*
-    //Timeout should be zero for true continuous reading
-    SETU16(newMsg, i, 0);
-    SETU8(newMsg, i, (uint8_t)0x1); // TM Option 1, for continuous reading
-    SETU8(newMsg, i, (uint8_t)TMR_SR_OPCODE_READ_TAG_ID_MULTIPLE); // sub
-    command opcode SETU16(newMsg, i, (uint16_t)0x0000); // search flags, only
-    0x0001 is supported SETU8(newMsg, i, (uint8_t)TMR_TAG_PROTOCOL_GEN2); //
-    protocol ID
-  */
+void RFID::getStats(RFIDStats &stats) {
+  uint32_t now = millis();
+  uint32_t window = now - _statsLastMs;
 
-  sendMessage(TMR_SR_OPCODE_MULTI_PROTOCOL_TAG_OP, configBlob,
-              sizeof(configBlob));
+  _stats.uartOverflows = _uartOverflows;
+
+  if (window > 0) {
+    _stats.bytesPerSec = (uint64_t)(_stats.bytesReceived - _statsLastBytes) * 1000 / window;
+    _stats.readsPerSec = (uint64_t)(_stats.tagReads - _statsLastReads) * 1000 / window;
+  }
+  _statsLastMs = now;
+  _statsLastBytes = _stats.bytesReceived;
+  _statsLastReads = _stats.tagReads;
+
+  stats = _stats;
 }
 
-// Stop a continuous read
-void RFID::stopReading() {
-  // 00 00 = Timeout, currently ignored
-  // 02 = Option - stop continuous reading
-  uint8_t configBlob[] = {0x00, 0x00, 0x02};
+void RFID::resetStats(void) {
+  memset(&_stats, 0, sizeof(_stats));
+  _uartOverflows = 0;
+  _statsLastMs = millis();
+  _statsLastBytes = 0;
+  _statsLastReads = 0;
+}
+
+void RFID::_countLatency(uint32_t ms) {
+  uint8_t bucket = 0;
+  while (bucket < RFID_LATENCY_BUCKETS - 1 && ms >= (1UL << bucket))
+    bucket++;
+
+  _stats.commands++;
+  _stats.latency[bucket]++;
+  if (ms > _stats.latencyMaxMs)
+    _stats.latencyMaxMs = ms;
+}
+
+// parseResponse() decoded a tag record into _tag
+void RFID::_countTagRead(void) {
+  uint32_t ms = millis() - _readStartMs;
+
+  _stats.tagReads++;
+  if (_stats.firstReadMs == 0)
+    _stats.firstReadMs = ms ? ms : 1;
+
+  if (_stats.uniqueEpcs >= RFID_STATS_UNIQUE_EPCS)
+    return;
+
+  // FNV-1a, only has to tell a handful of EPCs apart
+  uint32_t hash = 0x811C9DC5u;
+  for (uint8_t i = 0; i < _tag.epcLen; i++)
+    hash = (hash ^ _tag.epc[i]) * 0x01000193u;
+
+  for (uint8_t i = 0; i < _stats.uniqueEpcs; i++)
+    if (_uniqueHash[i] == hash)
+      return;
+
+  _uniqueHash[_stats.uniqueEpcs] = hash;
+  _stats.uniqueMs[_stats.uniqueEpcs++] = ms;
+}
+
+// Select as the read multiple and the tag operations carry it, after their
+// other fields: access password, bit pointer, mask length in bits, mask.
+// Returns the bytes added to blob, option gets the singulation option bits
+static uint8_t gen2SelectBytes(uint8_t *blob, uint8_t &option, uint8_t bank,
+                               uint32_t bitPointer, const uint8_t *mask,
+                               uint16_t bitLen, bool invert, uint32_t password) {
+  uint8_t i = 0;
+  bool extended = bitLen > 0xFF;
+
+  switch (bank) {
+  case TMR_GEN2_BANK_EPC:
+    option = TMR_SR_GEN2_SINGULATION_OPTION_SELECT_ON_ADDRESSED_EPC;
+    break;
+  case TMR_GEN2_BANK_TID:
+    option = TMR_SR_GEN2_SINGULATION_OPTION_SELECT_ON_TID;
+    break;
+  case TMR_GEN2_BANK_USER:
+    option = TMR_SR_GEN2_SINGULATION_OPTION_SELECT_ON_USER_MEM;
+    break;
+  default:
+    option = bank; // TMR_GEN2_EPC_LENGTH_FILTER, TMR_GEN2_EPC_TRUNCATE
+    break;
+  }
+  if (invert)
+    option |= TMR_SR_GEN2_SINGULATION_OPTION_INVERSE_SELECT_BIT;
+  if (extended)
+    option |= TMR_SR_GEN2_SINGULATION_OPTION_EXTENDED_DATA_LENGTH;
+
+  for (uint8_t x = 0; x < 4; x++)
+    blob[i++] = password >> (8 * (3 - x)) & 0xFF;
+  for (uint8_t x = 0; x < 4; x++)
+    blob[i++] = bitPointer >> (8 * (3 - x)) & 0xFF;
+  if (extended)
+    blob[i++] = bitLen >> 8;
+  blob[i++] = bitLen & 0xFF;
+
+  uint8_t maskBytes = (bitLen + 7) / 8;
+  memcpy(&blob[i], mask, maskBytes);
+  return (i + maskBytes);
+}
+
+ContinuousReadConfig::ContinuousReadConfig(void) {
+  _metadata = 0x01FF; // up to and including GPIO status
+  _onTime = 1000;
+  _offTime = 0;
+  _stats = true;
+  _selectBits = 0;
+  _password = 0;
+  _embedded = false;
+}
+
+ContinuousReadConfig &ContinuousReadConfig::metadata(uint16_t flags) {
+  _metadata = flags;
+  return (*this);
+}
+
+ContinuousReadConfig &ContinuousReadConfig::onTime(uint16_t ms) {
+  _onTime = ms;
+  return (*this);
+}
+
+ContinuousReadConfig &ContinuousReadConfig::offTime(uint16_t ms) {
+  _offTime = ms;
+  return (*this);
+}
+
+ContinuousReadConfig &ContinuousReadConfig::temperatureStats(bool enable) {
+  _stats = enable;
+  return (*this);
+}
+
+ContinuousReadConfig &ContinuousReadConfig::select(uint8_t bank, uint32_t bitPointer,
+                                                  const uint8_t *mask, uint16_t bitLen,
+                                                  bool invert) {
+  if (mask == NULL || bitLen == 0 || bitLen > CONT_READ_SELECT_BYTES * 8)
+    return (noSelect());
+
+  _selectBank = bank;
+  _selectPointer = bitPointer;
+  _selectBits = bitLen;
+  _selectInvert = invert;
+  memcpy(_selectMask, mask, (bitLen + 7) / 8);
+  return (*this);
+}
+
+ContinuousReadConfig &ContinuousReadConfig::selectEpcPrefix(const uint8_t *prefix, uint8_t len,
+                                                           bool invert) {
+  return (select(TMR_GEN2_BANK_EPC, GEN2_EPC_BIT_POINTER, prefix, (uint16_t)len * 8, invert));
+}
+
+ContinuousReadConfig &ContinuousReadConfig::noSelect(void) {
+  _selectBits = 0;
+  return (*this);
+}
+
+ContinuousReadConfig &ContinuousReadConfig::embeddedRead(uint8_t bank, uint32_t wordAddress,
+                                                        uint8_t wordCount) {
+  _embedded = true;
+  _embeddedBank = bank;
+  _embeddedAddress = wordAddress;
+  _embeddedWords = wordCount > CONT_READ_EMBEDDED_WORDS ? CONT_READ_EMBEDDED_WORDS : wordCount;
+  return (*this);
+}
+
+// The one window an embedded read of several banks covers: from the lowest
+// word address asked for to the highest end (words 0 = to the end of each
+// bank, if any range asked for that). Returns the number of banks
+static uint8_t bankWindow(const BankReadRequest &request, uint32_t &address, uint8_t &words) {
+  uint8_t banks = 0;
+  uint16_t end = 0;
+  bool toEnd = false;
+
+  address = 0xFF;
+  for (uint8_t b = 0; b < BANK_READ_BANKS; b++) {
+    if (!(request.banks & (1 << b)))
+      continue;
+    banks++;
+    if (request.wordAddress[b] < address)
+      address = request.wordAddress[b];
+    if (request.wordCount[b] == 0)
+      toEnd = true;
+    if (request.wordAddress[b] + request.wordCount[b] > end)
+      end = request.wordAddress[b] + request.wordCount[b];
+  }
+
+  if (banks == 0)
+    address = 0;
+  words = toEnd || banks == 0 ? 0 : end - address;
+  return (banks);
+}
 
-  sendMessage(TMR_SR_OPCODE_MULTI_PROTOCOL_TAG_OP, configBlob,
-              sizeof(configBlob), COMMAND_TIME_OUT,
-              false); // Do not wait for response
+ContinuousReadConfig &ContinuousReadConfig::embeddedReadBanks(const BankReadRequest &request) {
+  uint32_t address;
+  uint8_t words;
+  uint8_t banks = bankWindow(request, address, words);
+
+  if (banks == 0 || words > CONT_READ_EMBEDDED_WORDS ||
+      (uint16_t)banks * (2 + 2 * words) > BANK_READ_DATA_MAX)
+    return (noEmbeddedRead());
+
+  // a single bank as embeddedRead() would. More: the lowest one plus an
+  // enable bit per bank (TMR_GEN2_BANK_xxx_ENABLED), each comes back with
+  // a bank / length header
+  uint8_t bank = 0;
+  while (!(request.banks & (1 << bank)))
+    bank++;
+  if (banks > 1)
+    for (uint8_t b = 0; b < BANK_READ_BANKS; b++)
+      if (request.banks & (1 << b))
+        bank |= TMR_GEN2_BANK_RESERVED_ENABLED << b;
+
+  embeddedRead(bank, address, words);
+  return (*this);
+}
+
+ContinuousReadConfig &ContinuousReadConfig::noEmbeddedRead(void) {
+  _embedded = false;
+  return (*this);
+}
+
+ContinuousReadConfig &ContinuousReadConfig::accessPassword(uint32_t password) {
+  _password = password;
+  return (*this);
+}
+
+/*
+ * 00 00        no timeouts
+ * 01           TM option 1, continuous reading
+ * 22           sub command opcode: read tag multiple
+ * 00 00        search flags, only 0x0001 is supported
+ * 05           protocol: GEN2
+ * xx           length of the sub command that follows (after 22)
+ * 22           read tag multiple
+ * 10           option byte: metadata included, with a Select also the
+ *              bank's select option (+ 0x08 inverted, + 0x20 16-bit mask length)
+ * 01 1B        search flags (see TMR_SR_SEARCH_FLAG_xxx)
+ * 03 E8        on-time (ms)
+ * [xx xx]      off-time (ms), with TMR_SR_SEARCH_FLAG_DUTY_CYCLE_CONTROL
+ * 01 FF        metadata flags
+ * [01 00]      stats flags, with TMR_SR_SEARCH_FLAG_STATS_REPORT_STREAMING
+ * [xx xx xx xx access password
+ *  xx xx xx xx bit pointer
+ *  xx [xx]     mask length in bits
+ *  xx ..]      mask, with a Select
+ * [01          one embedded command, with an embedded read
+ *  09          its length (after the opcode)
+ *  28          read tag data
+ *  07 D0       timeout (ms)
+ *  00          option
+ *  xx          bank
+ *  xx xx xx xx word address
+ *  xx]         word count
+ */
+uint8_t ContinuousReadConfig::build(uint8_t *blob, uint8_t size) const {
+  uint8_t i = 0;
+  uint8_t maskBytes = (_selectBits + 7) / 8;
+  bool extended = _selectBits > 0xFF;
+
+  if (size < 22 + (_selectBits ? 10 + extended + maskBytes : 0) + (_embedded ? 12 : 0))
+    return (0);
+
+  uint16_t searchFlags = TMR_SR_SEARCH_FLAG_CONFIGURED_LIST |
+                         TMR_SR_SEARCH_FLAG_TAG_STREAMING |
+                         TMR_SR_SEARCH_FLAG_LARGE_TAG_POPULATION;
+  if (_offTime)
+    searchFlags |= TMR_SR_SEARCH_FLAG_DUTY_CYCLE_CONTROL;
+  if (_stats)
+    searchFlags |= TMR_SR_SEARCH_FLAG_STATS_REPORT_STREAMING;
+  if (_embedded)
+    searchFlags |= TMR_SR_SEARCH_FLAG_EMBEDDED_COMMAND;
+
+  uint16_t metadata = _metadata;
+  if (_embedded)
+    metadata |= TMR_TRD_METADATA_FLAG_DATA; // where the words come back
+
+  blob[i++] = 0x00; // timeout
+  blob[i++] = 0x00;
+  blob[i++] = 0x01; // continuous reading
+  blob[i++] = TMR_SR_OPCODE_READ_TAG_ID_MULTIPLE;
+  blob[i++] = 0x00; // search flags
+  blob[i++] = 0x00;
+  blob[i++] = 0x05; // GEN2
+
+  uint8_t lenPos = i++; // filled in below
+
+  blob[i++] = TMR_SR_OPCODE_READ_TAG_ID_MULTIPLE;
+  uint8_t optionPos = i++;
+  blob[optionPos] = TMR_SR_GEN2_SINGULATION_OPTION_FLAG_METADATA;
+  blob[i++] = searchFlags >> 8;
+  blob[i++] = searchFlags & 0xFF;
+  blob[i++] = _onTime >> 8;
+  blob[i++] = _onTime & 0xFF;
+
+  if (_offTime) {
+    blob[i++] = _offTime >> 8;
+    blob[i++] = _offTime & 0xFF;
+  }
+
+  blob[i++] = metadata >> 8;
+  blob[i++] = metadata & 0xFF;
+
+  if (_stats) {
+    blob[i++] = TMR_SR_STATS_FLAG_TEMPERATURE >> 8;
+    blob[i++] = TMR_SR_STATS_FLAG_TEMPERATURE & 0xFF;
+  }
+
+  if (_selectBits) {
+    uint8_t option;
+    i += gen2SelectBytes(&blob[i], option, _selectBank, _selectPointer, _selectMask,
+                         _selectBits, _selectInvert, _password);
+    blob[optionPos] |= option;
+  }
+
+  if (_embedded) {
+    blob[i++] = 0x01; // one embedded command
+    blob[i++] = 0x09; // length after the opcode
+    blob[i++] = TMR_SR_OPCODE_READ_TAG_DATA;
+    blob[i++] = 0x07; // timeout 2000 ms
+    blob[i++] = 0xD0;
+    blob[i++] = 0x00; // option
+    blob[i++] = _embeddedBank;
+    for (uint8_t x = 0; x < 4; x++)
+      blob[i++] = _embeddedAddress >> (8 * (3 - x)) & 0xFF;
+    blob[i++] = _embeddedWords;
+  }
+
+  blob[lenPos] = i - lenPos - 1 - 1; // count from after the 0x22 sub opcode
+
+  return (i);
+}
+
+// Stop a continuous read
+// Tag records that were still in flight are skipped (stopBackgroundReading()
+// queues them) and we return as soon
+// as the module acknowledges the stop with its 0x2F response, which can
+// take up to one search cycle (on-time in the startReading() blob).
+bool RFID::stopReading() {
+  sendFrame(StopReadingFrame::bytes);
 
   _continuousModeTemp = false;
+  _holdHead = _holdTail = 0; // nobody asks check() for the records held behind the ack
+
+  return (msg[0] == ALL_GOOD);
 }
 
 // Given a region, set the correct freq
@@ -312,17 +786,37 @@ bool RFID::setPowerMode(uint8_t mode) {
 // Because the Nano module has only one antenna port, it is not user
 // configurable
 void RFID::setAntennaPort(void) {
-  uint8_t configBlob[] = {0x01, 0x01}; // TX port = 1, RX port = 1
+  setAntennaPort(1, 1); // TX port = 1, RX port = 1
+}
+
+void RFID::setAntennaPort(uint8_t txPort, uint8_t rxPort) {
+  uint8_t configBlob[] = {txPort, rxPort};
   sendMessage(TMR_SR_OPCODE_SET_ANTENNA_PORT, configBlob, sizeof(configBlob));
 }
 
 // This was found in the logs. It seems to be very close to setAntennaPort
 // Search serial_reader_l3.c for cmdSetAntennaSearchList for more info
 void RFID::setAntennaSearchList(void) {
-  uint8_t configBlob[] = {
-      0x02, 0x01,
-      0x01}; // logical antenna list option, TX port = 1, RX port = 1
-  sendMessage(TMR_SR_OPCODE_SET_ANTENNA_PORT, configBlob, sizeof(configBlob));
+  uint8_t port = 1;
+  setAntennaSearchList(&port, 1);
+}
+
+// [02 = logical antenna list option] [TX port] [RX port] ...
+void RFID::setAntennaSearchList(const uint8_t *ports, uint8_t count) {
+  uint8_t configBlob[1 + 2 * RFID_ANTENNA_LIST_MAX];
+
+  if (count == 0 || count > RFID_ANTENNA_LIST_MAX) {
+    msg[0] = ERROR_INVALID_REQ;
+    return;
+  }
+
+  configBlob[0] = 0x02;
+  for (uint8_t i = 0; i < count; i++) {
+    configBlob[1 + 2 * i] = ports[i];
+    configBlob[2 + 2 * i] = ports[i];
+  }
+
+  sendMessage(TMR_SR_OPCODE_SET_ANTENNA_PORT, configBlob, 1 + 2 * count);
 }
 
 // Sets the protocol of the module
@@ -344,13 +838,10 @@ void RFID::setTagProtocol(uint8_t protocol) {
 
 // set GEN2 session (July 2025)
 bool RFID::setGen2Session(TMR_GEN2_Session session) {
-  uint8_t data[3];
-
-  data[0] = 0x05; // TMR_TAG_PROTOCOL_GEN2;
-  data[1] = 0x00; // TMR_SR_GEN2_CONFIGURATION_SESSION;
-  data[2] = session;
+  if (session > TMR_GEN2_SESSION_S3)
+    return (false);
 
-  sendMessage(TMR_SR_OPCODE_SET_PROTOCOL_PARAM, data, sizeof(data));
+  sendFrame(gen2SessionFrames[session]);
 
   if (msg[0] == ALL_GOOD && msg[3] == 0x0 && msg[4] == 0x0)
     return true;
@@ -364,19 +855,23 @@ bool RFID::setGen2Q(TMR_SR_GEN2_QType Q_state, uint8_t init_value,
   if (Q_state == TMR_SR_GEN2_Q_INVALID)
     return (false);
 
+  // only checked where it is sent: dynamic Q without set_init keeps the
+  // module's initial Q (applyProfile() with qInit > 10)
+  if ((set_init || Q_state == TMR_SR_GEN2_Q_STATIC) && init_value > 10)
+    return (false);
+
   data[0] = 0x05;    // TMR_TAG_PROTOCOL_GEN2;
   data[1] = 0x12;    // TMR_SR_GEN2_CONFIGURATION_Q
   data[2] = Q_state; // either static or dynamic
+  data[3] = init_value;
 
-  sendMessage(TMR_SR_OPCODE_SET_PROTOCOL_PARAM, data, 3);
+  // static Q carries the Q value itself
+  sendMessage(TMR_SR_OPCODE_SET_PROTOCOL_PARAM, data, Q_state == TMR_SR_GEN2_Q_STATIC ? 4 : 3);
 
   if (msg[0] != ALL_GOOD || msg[3] != 0x0 || msg[4] != 0x0)
     return (false);
 
   if (set_init) {
-    if (init_value > 10)
-      return (false);
-
     data[0] = 0x05; // TMR_TAG_PROTOCOL_GEN2;
     data[1] = 0x16; // TMR_SR_GEN2_INITIAL_Q
     data[2] = 0x01; // enable
@@ -430,45 +925,24 @@ bool RFID::setGen2RFmode(TMR_GEN2_RFMode mode) {
 
 // set GEN2 TARGET (July 2025)
 bool RFID::setGen2Target(TMR_GEN2_Target target) {
-  uint8_t data[4];
-
-  data[0] = 0x05; // TMR_TAG_PROTOCOL_GEN2;
-  data[1] = 0x01; // TMR_SR_GEN2_CONFIGURATION_TARGET;
-
-  switch (target) {
-  case TMR_GEN2_TARGET_A:
-    data[2] = 0x01;
-    data[3] = 0x00;
-    break;
-  case TMR_GEN2_TARGET_B:
-    data[2] = 0x01;
-    data[3] = 0x01;
-    break;
-  case TMR_GEN2_TARGET_AB:
-    data[2] = 0x00;
-    data[3] = 0x00;
-    break;
-  case TMR_GEN2_TARGET_BA:
-    data[2] = 0x00;
-    data[3] = 0x01;
-    break;
-  default:
+  if (target >= TMR_GEN2_TARGET_INVALID)
     return (false);
-  }
-  sendMessage(TMR_SR_OPCODE_SET_PROTOCOL_PARAM, data, sizeof(data));
+
+  sendFrame(gen2TargetFrames[target]);
 
   if (msg[0] == ALL_GOOD && msg[3] == 0x0 && msg[4] == 0x0)
     return (true);
   return (false);
 }
 
+// setReaderConfiguration(0x0C, 0x01), prebuilt
 void RFID::enableReadFilter(void) {
-  setReaderConfiguration(0x0C, 0x01); // Enable read filter
+  sendFrame(ReadFilterOnFrame::bytes); // Enable read filter
 }
 
 // Disabling the read filter allows continuous reading of tags
 void RFID::disableReadFilter(void) {
-  setReaderConfiguration(0x0C, 0x00); // Diable read filter
+  sendFrame(ReadFilterOffFrame::bytes); // Diable read filter
 }
 
 // Sends optional parameters to the module
@@ -499,7 +973,7 @@ void RFID::getOptionalParameters(uint8_t option1, uint8_t option2) {
 }
 
 // Get the version number from the module
-void RFID::getVersion(void) { sendMessage(TMR_SR_OPCODE_VERSION); }
+void RFID::getVersion(void) { sendFrame(VersionFrame::bytes); }
 
 // Set the read TX power
 // Maximum power is 2700 = 27.00 dBm
@@ -510,12 +984,18 @@ void RFID::setReadPower(int16_t powerSetting) {
     powerSetting = 2700; // Limit to 27dBm
 
   // Copy this setting into a temp data array
-  uint8_t size = sizeof(powerSetting);
-  uint8_t data[size];
-  for (uint8_t x = 0; x < size; x++)
-    data[x] = (uint8_t)(powerSetting >> (8 * (size - 1 - x)));
+  uint8_t data[sizeof(powerSetting)];
+  for (uint8_t x = 0; x < sizeof(data); x++)
+    data[x] = (uint8_t)(powerSetting >> (8 * (sizeof(data) - 1 - x)));
 
-  sendMessage(TMR_SR_OPCODE_SET_READ_TX_POWER, data, size);
+  sendMessage(TMR_SR_OPCODE_SET_READ_TX_POWER, data, sizeof(data));
+}
+
+// Set the hop time (option 0x01 of the hop table command)
+void RFID::setHopTime(uint32_t ms) {
+  uint8_t data[] = {0x01, (uint8_t)(ms >> 24), (uint8_t)(ms >> 16), (uint8_t)(ms >> 8), (uint8_t)ms};
+
+  sendMessage(TMR_SR_OPCODE_SET_FREQ_HOP_TABLE, data, sizeof(data));
 }
 
 // Get the read TX power
@@ -530,12 +1010,11 @@ void RFID::getReadPower() {
 // Maximum power is 2700 = 27.00 dBm
 // 1005 = 10.05dBm
 void RFID::setWritePower(int16_t powerSetting) {
-  uint8_t size = sizeof(powerSetting);
-  uint8_t data[size];
-  for (uint8_t x = 0; x < size; x++)
-    data[x] = (uint8_t)(powerSetting >> (8 * (size - 1 - x)));
+  uint8_t data[sizeof(powerSetting)];
+  for (uint8_t x = 0; x < sizeof(data); x++)
+    data[x] = (uint8_t)(powerSetting >> (8 * (sizeof(data) - 1 - x)));
 
-  sendMessage(TMR_SR_OPCODE_SET_WRITE_TX_POWER, data, size);
+  sendMessage(TMR_SR_OPCODE_SET_WRITE_TX_POWER, data, sizeof(data));
 }
 
 // Get the write TX power
@@ -953,93 +1432,19 @@ error
  * @return :
  *    ERROR_INVALID_EPC_REQ         : invalid data in EPC selection
  *    RESPONSE_FAIL                 : error during reading tag
- *    ERROR_COMMAND_RESPONSE_TIMEOUT: retry count to get the right tag / EPC
-exceeded
+ *    ERROR_COMMAND_RESPONSE_TIMEOUT: no tag with the EPC answered within
+timeOut
  *    ERROR_INVALID_REQ             : requested position (Address and/or length)
 not available
  *    RESPONSE_SUCCESS              : Data has been read
 
-////////////////////////////////////////////////////////////////////////////////////
-////// Sending BLOB basic
-////////////////////////////////////////////////////////////////////////////////////
-  special blob being send
-  0x88    TMR_SR_TAGOP_MULTI_SELECT
-  0x10    option byte
-  0x0017  search flag
-          0001 0111
-          0001 ---- large population
-          ------1-- embedded command
-          -------11 use configured antenna list (sent earlier)
-  0x07d0  timeout (overwrite with user provides)
-  0x0fff  metadata
-  0x01,   embedded command count (only 1 supported)
-  0x09,   length of embedded command
-  0x28,   TMR_SR_OPCODE_READ_TAG_DATA
-  0x07d0, timeout
-  0x00,   option byte
-  0x01,   banks to read TMR_GEN2_BANK_EPC (potential add |
-TMR_GEN2_BANK_USER_ENABLED | TMR_GEN2_BANK_RESERVED_ENABLED
-|TMR_GEN2_BANK_TID_ENABLED) 0x00, 0x00, 0x00, 0x00, starting wordaddress 0x00
-length (read complete bank)
-
-////////////////////////////////////////////////////////////////////////////////////
- response (simular WITH either user bank or TID or reserved bank)
-////////////////////////////////////////////////////////////////////////////////////
- [FF] [62] [22] [06] [01] [88] [00] [00] [17] [00] [00] [00] [18] [01] [28] [00]
-[18] [00] [00] [10] [08] [B8] [57] [34] [00] [E2] [00] [00] [15] [86] [0E] [02]
-[88] [15] [40] [29] [80] [30] [20] [FF] [F1] [11] [22] [33] [44] [33] [34] [42]
-[44] [74] [6F] [20] [77] [72] [69] [74] [65] [74] [6F] [20] [63] [61] [72] [64]
-[00] [00] [00] [00] [00] [00] [00] [00] [00] [00] [00] [00] [00] [00] [00] [00]
-[00] [00] [00] [00] [00] [00] [00] [00] [00] [00] [00] [00] [00] [00] [00] [00]
-[00] [00] [00] [00] [00] [00] [00]
-
-0  [FF]               header
-1  [62]               length
-2  [22]               opcode
-3  [06] [01]          status
-5  [88]               multiselect
-6  [00]               option byte
-7  [00] [17]          searchflag
-9  [00] [00] [00] [18]succesfull reader count
-13 [01]               1 embedded command
-14 [28]               opcode
-15 [00] [18]          succesfull reader count
-17 [00] [00]          failure count
-19 [10]               EPC memory
-20 [08]               length 8 words = 16 bytes
-21 [B8] [57]          EPC CRC
-23 [34] [00]          PC
-25 [E2] [00] [00] [15] [86] [0E] [02] [88] [15] [40] [29] [80]  EPC
-37 [30]               user memory read
-38 [20]               length of memory read (32 words = 64 bytes)
-39 [FF] [F1] [11] [22] [33] [44] [33] [34] [42] [44] [74] [6F] [20] [77] [72]
-[69] [74] [65] [74] [6F] [20] [63] [61] [72] [64] [00] [00] [00] [00] [00] [00]
-[00] [00] [00] [00] [00] [00] [00] [00] [00] [00] [00] [00] [00] [00] [00] [00]
-[00] [00] [00] [00] [00] [00] [00] [00] [00] [00] [00] [00] [00] [00] [00] [00]
-[00] 2 bytes CRC
-
-//////////////////////////////////////////
-response if ONLY EPC bank was request
-//////////////////////////////////////////
-[FF] [14] [22] [88] [10] [00] [17] [07] [D0] [0F] [FF] [01] [09] [28] [07] [D0]
-[00] [01] [00] [00] [00] [00] [00] [F0] [A7]
-
-0 [FF]            header
-1 [1E]            length
-2 [22]            opcode
-3 [06] [01]       status
-5 [88]            multiselect
-6 [00]            option byte
-8 [00] [17]       search
-9 [00] [00] [00] [29]succesfull reader count
-13 [01]           # embedded commands
-14 [28]           opcode
-15 [00] [29]      succesfull reader count
-17 [00] [00]      failure count
-19 [B8] [57]      EPC CRC
-21 [34] [00]      EPC PC
-23 [E2] [00] [00] [15] [86] [0E] [02] [88] [15] [40] [29] [80] EPC
-2 bytes CRC
+ The tag is singled out with a Gen2 Select on the EPC bytes: a read tag
+ data (0x28) with the select after the word count, as selectedRead()
+ sends it. Only the matching tag answers, the module keeps searching for it
+ up to timeOut, so there is no re-inventory loop in the library any more and
+ RetryCount is not used.
+
+ response: FF len 28 status(2) option(echo) data
 */
 
 uint8_t RFID::SelectiveReadDataRegion(SelectEPC *selepc, uint8_t bank,
@@ -1047,136 +1452,153 @@ uint8_t RFID::SelectiveReadDataRegion(SelectEPC *selepc, uint8_t bank,
                                       uint8_t *dataRead,
                                       uint8_t &dataLengthRead,
                                       uint16_t timeOut) {
-  bool MatchFound = false; // Matching tag not found yet
-  uint8_t retryCount = 0;  // how often to try to find a match
-  uint8_t BankStartPos, EPCBankStartPos, Banklength;
-  ;
+  uint8_t data[8 + 10 + 12];
+  uint8_t i = 0;
 
   // Basic checks on the EPC selection request
-  if (selepc->EPCoffset + selepc->EPClen > 12 || selepc->EPCoffset == 12) {
+  if (selepc->EPCoffset + selepc->EPClen > 12 || selepc->EPCoffset == 12 ||
+      selepc->EPClen == 0) {
     dataLengthRead = 0; // Inform caller that we weren't able to read anything
     return (ERROR_INVALID_EPC_REQ);
   }
 
-  // Sending:  ff 03 9a 01 08 00 a7 5d
-  // This allows tags with the same EPC ID but different values in the specified
-  // memory bank to be treated as unique tags during inventories, else the
-  // readcount is just increased
+  data[i++] = timeOut >> 8 & 0xFF; // Timeout msB in ms
+  data[i++] = timeOut & 0xFF;      // Timeout lsB in ms
+  uint8_t optionPos = i++;
+  data[i++] = bank;
+  for (uint8_t x = 0; x < sizeof(address); x++)
+    data[i++] = address >> (8 * (3 - x)) & 0xFF;
+  data[i++] = length; // Number of 16-bit chunks to read.
 
-  uint8_t c2[] = {0x01, 0x08, 0x00};
-  sendMessage(TMR_SR_OPCODE_SET_READER_OPTIONAL_PARAMS, c2, sizeof(c2));
+  uint32_t pointer = GEN2_EPC_BIT_POINTER + selepc->EPCoffset * 8;
+  i += gen2SelectBytes(&data[i], data[optionPos], TMR_GEN2_BANK_EPC, pointer,
+                       selepc->TMR_EPC, (uint16_t)selepc->EPClen * 8, false, 0);
 
-  // Don't filter for a specific tag, read all tags
-  disableReadFilter();
+  sendMessage(TMR_SR_OPCODE_READ_TAG_DATA, data, i, timeOut);
 
-  // clear tag ID buffer
-  sendMessage(TMR_SR_OPCODE_CLEAR_TAG_ID_BUFFER);
+  if (msg[0] != ALL_GOOD) {
+    dataLengthRead = 0;
+    return (RESPONSE_FAIL);
+  }
 
-  // Starting blob                               0x01f4 = 5 EPC bank(0x01) as
-  // FIRST to read
-  uint8_t configBlob[] = {0x88, 0x10, 0x00, 0x17, 0x01, 0xf4, 0x0f,
-                          0xff, 0x01, 0x09, 0x28, 0x07, 0xd0, 0x00,
-                          0x01, 0x00, 0x00, 0x00, 0x00, 0x00};
-
-  // Update timeout in BLOB
-  configBlob[4] = timeOut >> 8 & 0xFF; // Timeout msB in ms
-  configBlob[5] = timeOut & 0xFF;      // Timeout lsB in ms
-
-  // if EPC bank was targeted for reading, only this bank information is
-  // returned
-  if (bank == TMR_GEN2_BANK_EPC)
-    EPCBankStartPos = 23; // As this is the only bank to read the offset in
-                          // response is different
-  else {
-    EPCBankStartPos = 25; // M6E will add 'Banktype' and 'length' as part of the
-                          // response, hence 2 bytes more
-
-    // Add additional bank requested. EPC is already in the blob defined to be
-    // read first
-    switch (bank) {
-
-    case TMR_GEN2_BANK_USER:
-      configBlob[14] |= TMR_GEN2_BANK_USER_ENABLED;
-      break;
-    case TMR_GEN2_BANK_TID:
-      configBlob[14] |= TMR_GEN2_BANK_TID_ENABLED;
-      break;
-    case TMR_GEN2_BANK_RESERVED:
-      configBlob[14] |= TMR_GEN2_BANK_RESERVED_ENABLED;
-      break;
-    }
+  uint16_t status = msg[3] << 8 | msg[4];
+  if (status != 0x0000) {
+    dataLengthRead = 0;
+    if (status == TMR_SR_STATUS_NO_TAGS_FOUND)
+      return (ERROR_COMMAND_RESPONSE_TIMEOUT);
+    if (status == TMR_SR_STATUS_GEN2_MEMORY_OVERRUN)
+      return (ERROR_INVALID_REQ);
+    return (RESPONSE_FAIL);
   }
 
-  // Look to a match the EPC with the TAG in front of the reader
-  while (!MatchFound) {
-    sendMessage(TMR_SR_OPCODE_READ_TAG_ID_MULTIPLE, configBlob,
-                sizeof(configBlob));
+  // words follow the echoed option byte
+  uint8_t responseLength = msg[1] > 0 ? msg[1] - 1 : 0;
+  if (responseLength < dataLengthRead)
+    dataLengthRead = responseLength;
 
-    if (msg[0] != ALL_GOOD) {
-      dataLengthRead = 0; // Inform caller that we weren't able to read anything
-      return RESPONSE_FAIL;
-    }
+  for (uint8_t x = 0; x < dataLengthRead; x++)
+    dataRead[x] = msg[6 + x];
 
-    // Now check for the correct EPC. EPCBankStartPos is where EPC starts in
-    // response
-    uint8_t EPCstart = EPCBankStartPos + selepc->EPCoffset;
+  return (RESPONSE_SUCCESS);
+}
 
-    // check for match
-    uint8_t e;
-    for (e = 0; e < selepc->EPClen; e++) {
-      // if mismatch
-      if (msg[EPCstart + e] != selepc->TMR_EPC[e])
-        break;
-    }
+/*
+ * One continuous read with an embedded read of the requested banks
+ * (ContinuousReadConfig::embeddedReadBanks()), each record handed to the
+ * callback as check() takes it from the UART. Nothing is collected in
+ * between: a diagnostics station reading TID + user memory of dozens of pucks
+ * prints or checks each one as it comes in.
+ */
+uint16_t RFID::readBanks(const BankReadRequest &request, BankReadCallback callback,
+                         void *ctx, uint16_t ms, const uint8_t *epc, uint8_t epcLen) {
+  uint16_t records = 0;
 
-    if (e == selepc->EPClen) {
-      MatchFound = true;
-    } else {
-      // try for RetryCount times to fail (if set)
-      if (selepc->RetryCount != 0) {
-        if (retryCount++ > selepc->RetryCount) {
-          dataLengthRead =
-              0; // Inform caller that we weren't able to read anything
-          return ERROR_COMMAND_RESPONSE_TIMEOUT;
-        }
-      }
+  ContinuousReadConfig config;
+  config.metadata(TMR_TRD_METADATA_FLAG_RSSI).temperatureStats(false).embeddedReadBanks(request);
+  if (!config.hasEmbeddedRead())
+    return (0); // no banks, or more than a record holds
+
+  if (epc != NULL && epcLen > 0)
+    config.selectEpcPrefix(epc, epcLen);
+
+  // tags with the same EPC but different data are unique (as startReadingBank())
+  uint8_t c2[] = {0x01, 0x08, 0x00};
+  sendMessage(TMR_SR_OPCODE_SET_READER_OPTIONAL_PARAMS, c2, sizeof(c2));
+
+  startReading(config);
+  if (msg[0] != ALL_GOOD)
+    return (0);
+
+  uint32_t start = millis();
+  while (millis() - start < ms) {
+    if (!check()) {
+      _waitForRx(5);
+      continue;
     }
+    if (parseResponse() != RESPONSE_IS_TAGFOUND)
+      continue;
+
+    BankData banks;
+    splitBanks(_tag, request, banks);
+    records++;
+    if (callback != NULL && !callback(_tag, banks, ctx))
+      break;
   }
 
-  /////////////////////////////////////////////////////////////////////
-  //  NOW we have the right tag and good data for the requested bank
-  ////////////////////////////////////////////////////////////////////
+  stopReading();
+  return (records);
+}
 
-  if (bank == TMR_GEN2_BANK_EPC) {
-    BankStartPos = 23; // the EPC bank in the response blob start here (skipping
-                       // EPC-CRC and PC)
-    Banklength = 12;   // expect the EPC is 12 bytes (96 bits).
-  } else {
-    BankStartPos =
-        39; // the other (requested) bank data in the response blob start here
-    Banklength = msg[38]; // get the length of requested bank
-  }
+/*
+ * Embedded read data of several banks, one after the other:
+ *   bank << 4, length in words, the words
+ * A single bank comes without the header (see embeddedReadBanks())
+ */
+bool RFID::splitBanks(const TagRecord &rec, const BankReadRequest &request, BankData &banks) {
+  uint32_t address;
+  uint8_t words;
+  uint8_t count = bankWindow(request, address, words);
+  uint8_t found = 0;
+
+  memset(&banks, 0, sizeof(banks));
+  if (rec.data == NULL || count == 0)
+    return (false);
 
-  // Make sure we can fullfil the request. Convert words requested to bytes
-  if (Banklength < (address * 2) + (length * 2)) {
-    dataLengthRead = 0; // Inform caller that we weren't able to read anything
-    return (ERROR_INVALID_REQ);
-  }
+  for (uint8_t i = 0; i < rec.dataLen;) {
+    uint8_t bank, len;
 
-  // set for address start, word aligned
-  uint8_t BankStart = BankStartPos + (address * 2);
+    if (count == 1) {
+      bank = 0;
+      while (!(request.banks & (1 << bank)))
+        bank++;
+      len = rec.dataLen;
+    } else {
+      if (i + 2 > rec.dataLen)
+        break;
+      bank = rec.data[i] >> 4 & 0xf;
+      len = rec.data[i + 1] * 2;
+      i += 2;
+      if (i + len > rec.dataLen)
+        break;
+    }
 
-  // copy the data up to requested or maximum
-  uint8_t x;
-  for (x = 0; x < (length * 2) & x < dataLengthRead; x++) {
-    dataRead[x] = msg[BankStart + x];
+    if (bank < BANK_READ_BANKS && (request.banks & (1 << bank)) && banks.data[bank] == NULL) {
+      // the range of this bank within the window
+      uint8_t skip = (request.wordAddress[bank] - address) * 2;
+      uint8_t want = request.wordCount[bank] * 2;
+
+      if (want == 0 && skip <= len)
+        want = len - skip; // to the end of the bank
+      if (want > 0 && skip + want <= len) {
+        banks.data[bank] = &rec.data[i + skip];
+        banks.len[bank] = want;
+        found++;
+      }
+    }
+    i += len;
   }
 
-  // return the number of bytes copied
-  dataLengthRead = x;
-
-  // pfff.... finally we are done
-  return (RESPONSE_SUCCESS);
+  return (found == count);
 }
 
 /**
@@ -1265,7 +1687,9 @@ uint8_t RFID::writeDataRegion(uint8_t bank, uint32_t address,
                               uint16_t timeOut) {
   dataLengthToRecord =
       (dataLengthToRecord / 2) * 2; // make sure on 16 bit boundery = 2 bytes
-  uint8_t data[8 + dataLengthToRecord];
+  uint8_t data[TAG_WRITE_DATA_MAX];
+  if (8 + dataLengthToRecord > TAG_WRITE_DATA_MAX)
+    return (RESPONSE_FAIL);
 
   // Pre-load array options
   data[0] = timeOut >> 8 & 0xFF; // Timeout msB in ms
@@ -1282,7 +1706,7 @@ uint8_t RFID::writeDataRegion(uint8_t bank, uint32_t address,
   for (uint8_t x = 0; x < dataLengthToRecord; x++)
     data[8 + x] = dataToRecord[x];
 
-  sendMessage(TMR_SR_OPCODE_WRITE_TAG_DATA, data, sizeof(data), timeOut);
+  sendMessage(TMR_SR_OPCODE_WRITE_TAG_DATA, data, 8 + dataLengthToRecord, timeOut);
 
   if (msg[0] == ALL_GOOD) // We received a good response
   {
@@ -1355,7 +1779,9 @@ uint8_t RFID::writeData(uint8_t bank, uint32_t address, uint8_t *dataToRecord,
   // 00 EE = Data
   // 58 9D = CRC
 
-  uint8_t data[8 + dataLengthToRecord];
+  uint8_t data[TAG_WRITE_DATA_MAX];
+  if (8 + dataLengthToRecord > TAG_WRITE_DATA_MAX)
+    return (RESPONSE_FAIL);
 
   // Pre-load array options
   data[0] = timeOut >> 8 & 0xFF; // Timeout msB in ms
@@ -1376,7 +1802,7 @@ uint8_t RFID::writeData(uint8_t bank, uint32_t address, uint8_t *dataToRecord,
   for (uint8_t x = 0; x < dataLengthToRecord; x++)
     data[8 + x] = dataToRecord[x];
 
-  sendMessage(TMR_SR_OPCODE_WRITE_TAG_DATA, data, sizeof(data), timeOut);
+  sendMessage(TMR_SR_OPCODE_WRITE_TAG_DATA, data, 8 + dataLengthToRecord, timeOut);
 
   if (msg[0] == ALL_GOOD) // We received a good response
   {
@@ -1473,7 +1899,9 @@ uint8_t RFID::readData(uint8_t bank, uint32_t address, uint8_t *dataRead,
 // TODO Can we add ability to write to specific EPC?
 uint8_t RFID::killTag(uint8_t *password, uint8_t passwordLength,
                       uint16_t timeOut) {
-  uint8_t data[4 + passwordLength];
+  uint8_t data[8];
+  if (passwordLength > 4)
+    return (RESPONSE_FAIL);
 
   data[0] = timeOut >> 8 & 0xFF; // Timeout msB in ms
   data[1] = timeOut & 0xFF;      // Timeout lsB in ms
@@ -1485,7 +1913,7 @@ uint8_t RFID::killTag(uint8_t *password, uint8_t passwordLength,
 
   data[3 + passwordLength] = 0x00; // RFU
 
-  sendMessage(TMR_SR_OPCODE_KILL_TAG, data, sizeof(data), timeOut);
+  sendMessage(TMR_SR_OPCODE_KILL_TAG, data, 4 + passwordLength, timeOut);
 
   if (msg[0] == ALL_GOOD) // We received a good response
   {
@@ -1499,142 +1927,566 @@ uint8_t RFID::killTag(uint8_t *password, uint8_t passwordLength,
   return (RESPONSE_FAIL);
 }
 
-// Checks incoming buffer for the start characters
-// Returns true if a new message is complete and ready to be cracked
-bool RFID::check() {
-  while (_rfidSerial->available()) {
-    uint8_t incomingData = _rfidSerial->read();
+/*
+ * Tag operations on one selected tag (provisioning)
+ *
+ * write 0x24: timeout (2), option, address (4), bank, select, data
+ * read  0x28: timeout (2), option, bank, address (4), word count, select
+ *
+ * The option byte carries the select type (see gen2SelectBytes()). A read
+ * sent with it answers with the option byte echoed in msg[5], the words
+ * follow from msg[6]
+ */
+static uint8_t tagSelect(const ProvisionTag &tag, uint8_t *blob, uint8_t &option) {
+  uint32_t pointer = tag.idBank == TMR_GEN2_BANK_EPC ? GEN2_EPC_BIT_POINTER : 0;
+  return (gen2SelectBytes(blob, option, tag.idBank, pointer, tag.id, (uint16_t)tag.idLen * 8, false, 0));
+}
 
-    // Wait for header byte
-    if (_head == 0 && incomingData != 0xFF) {
-      // Do nothing. Ignore this byte because we need a start byte
-    } else {
-      // Load this value into the array
-      msg[_head++] = incomingData;
+uint8_t RFID::selectedWrite(const ProvisionTag &tag, uint8_t bank, uint32_t address,
+                            uint16_t timeOut, uint8_t *data) {
+  uint8_t i = 0;
 
-      _head %= MAX_MSG_SIZE; // Wrap variable
+  if (tag.idLen == 0 || tag.idLen > PROVISION_ID_BYTES || tag.dataLen > PROVISION_DATA_MAX ||
+      8 + 9 + tag.idLen + tag.dataLen > CMD_QUEUE_DATA_MAX)
+    return (0);
 
-      if ((_head > 0) && (_head == msg[1] + 7)) {
-        // We've got a complete sentence!
+  data[i++] = timeOut >> 8 & 0xFF;
+  data[i++] = timeOut & 0xFF;
+  uint8_t optionPos = i++;
+  for (uint8_t x = 0; x < sizeof(address); x++)
+    data[i++] = address >> (8 * (3 - x)) & 0xFF;
+  data[i++] = bank;
+  i += tagSelect(tag, &data[i], data[optionPos]);
 
-        // Erase the remainder of the array
-        for (uint8_t x = _head; x < MAX_MSG_SIZE; x++)
-          msg[x] = 0;
+  uint8_t len = (tag.dataLen / 2) * 2; // whole words
+  memcpy(&data[i], tag.data, len);
+  return (i + len);
+}
 
-        _head = 0; // Reset
+uint8_t RFID::selectedRead(const ProvisionTag &tag, uint8_t bank, uint32_t address,
+                           uint16_t timeOut, uint8_t *data) {
+  uint8_t i = 0;
 
-        // Used for debugging: Does the user want us to print the command to
-        // serial port?
-        if (_printDebug == true) {
-          _debugSerial->print(F("response: "));
-          printMessageArray();
-        }
-#ifdef ARDUINO_ARCH_ESP32
-        else
-          delay(ESP32_DELAY);
-#endif
+  if (tag.idLen == 0 || tag.idLen > PROVISION_ID_BYTES || tag.dataLen > PROVISION_DATA_MAX)
+    return (0);
 
-        if (_continuousModeTemp) { // added for temperature special (may2020 /
-                                   // paulvha)
-                                   /*
-                                    *
-                                    * September 2020
-                                    * [FF] [3D] [22] [00] [00] [10] [01] [1F] [0F] [FF] [01] [01] [DD]
-                                   [11] [0D] [37] [FC] [00] [00] [00] [B3] [00] [AE] [05] [00] [90] [FF]
-                                   [00] [06] [2F] [80] [29] [01] [0E] [01] [54] [00] [0D] [5F] [FB] [FF]
-                                   [FF] [DC] [00] [80] [02] [00] [00] [00] [80] [34] [00] [E2] [00] [00]
-                                   [15] [86] [0E] [02] [88] [15] [40] [80] [29] [3B] [72]
-                         
-                         
-                                   [FF]                header
-                                   [3D]                length
-                                   [22]                opcode
-                                   [00] [00]           status
-                                   [10]                option byte / continuous reading
-                                   [01] [1F]           searchflag
-                                   [0F] [FF]           metadata to return
-                                   [01]                number of tags
-                                   [01]                count
-                                   [DD]                RSSI
-                                   [11]                antenna
-                                   [0D] [37] [FC]      frequency
-                                   [00] [00] [00] [B3] Timestamp in ms since last keep alive msg
-                                   [00] [AE]           phase
-                                   [05]                GEN5
-                                   [00] [90]           data length in bits = 144 / 8 = 18
-                                   [FF] [00] [06] [2F] [80] [29] [01] [0E] [01] [54] [00] [0D] [5F] [FB]
-                                   [FF] [FF] [DC] [00]
-                         
-                                   [80]                GPIO status
-                                   [02]                initial Q
-                                   [00]                GEN2_LINKFREQUENCY
-                                   [00]                GEN2_TARGET_A
-                                   [00] [80]           length EPC in bits = 128 / 8 = 16 bytes
-                                   [34] [00]           PC word
-                                   [E2] [00] [00] [15] [86] [0E] [02] [88] [15] [40] [80] [29] EPC
-                                   [3B] [72]           EPC CRC
-                                   */
-
-          if (msg[5] == 0x10)
-            return true; // we have valid data
-
-          else if (msg[3] == 0x04)
-            return true; // scan indication (added January 2022)
-                         // May 2020 & September 2020
-                         // positie   14  (dus 1A is de temperatuure = 26C)
-          //             0    1    2    3    4    5   6    7    8    9    10 11
-          //             12   13   14
-          // response:  [FF] [0A] [22] [00] [00] [00] [01] [1F] [02] [82] [00]
-          // [82] [00] [01] [1A]
-          /*  0  [FF]
-           *  1  [0A]         length
-           *  2  [22]         opcode
-           *  3  [00] [00]    status
-           *  5  [00]         port
-           *  6  [01] [1F]    search flag
-           *  8  [02]         STATS UPDATE
-           *  9  [82] [00]    EBV is set ( > 0x80)
-           *  11 [82] [00]    the real indicter (temperature)
-           *  13 [01]         1 data byte
-           *  14 [1A]         TEMP !!!! (26 C)
-           */
-          else if (msg[8] == 0x02) { // stats update
-            if (msg[13] == 1 && msg[11] == 0x82)
-              _contTemp = msg[14]; // get temperature
-          }
-
-          return (false);
-        }
+  data[i++] = timeOut >> 8 & 0xFF;
+  data[i++] = timeOut & 0xFF;
+  uint8_t optionPos = i++;
+  data[i++] = bank;
+  for (uint8_t x = 0; x < sizeof(address); x++)
+    data[i++] = address >> (8 * (3 - x)) & 0xFF;
+  data[i++] = tag.dataLen / 2; // words
+  i += tagSelect(tag, &data[i], data[optionPos]);
+  return (i);
+}
+
+uint8_t RFID::inventoryTags(ProvisionTag *tags, uint8_t max, uint16_t ms) {
+  uint8_t count = 0;
+
+  ContinuousReadConfig config;
+  config.metadata(TMR_TRD_METADATA_FLAG_RSSI).temperatureStats(false);
+  startReading(config);
+  if (msg[0] != ALL_GOOD)
+    return (0);
+
+  uint32_t start = millis();
+  while (millis() - start < ms) {
+    if (!check()) {
+      _waitForRx(5);
+      continue;
+    }
+    if (parseResponse() != RESPONSE_IS_TAGFOUND || _tag.epcLen == 0)
+      continue;
+
+    uint8_t len = _tag.epcLen > PROVISION_ID_BYTES ? PROVISION_ID_BYTES : _tag.epcLen;
+    uint8_t t = 0;
+    while (t < count && (tags[t].idLen != len || memcmp(tags[t].id, _tag.epc, len) != 0))
+      t++;
+    if (t < count || count == max)
+      continue;
+
+    ProvisionTag &tag = tags[count++];
+    memset(&tag, 0, sizeof(tag));
+    tag.idBank = TMR_GEN2_BANK_EPC;
+    tag.idLen = len;
+    memcpy(tag.id, _tag.epc, len);
+    tag.result = PROVISION_PENDING;
+  }
+
+  stopReading();
+  return (count);
+}
+
+uint8_t RFID::provisionTags(ProvisionTag *tags, uint8_t count, uint8_t bank,
+                            uint32_t address, uint16_t timeOut) {
+  uint8_t data[CMD_QUEUE_DATA_MAX];
+  uint8_t next = 0;
+
+  flushCommands(); // the queue holds only our commands below
+  _provTags = tags;
+  _provHead = _provTail = 0;
+
+  while (true) {
+    // two commands per tag, queued together
+    while (next < count && _cmdCount + 2 <= CMD_QUEUE_SIZE) {
+      ProvisionTag &tag = tags[next++];
+      tag.result = PROVISION_PENDING;
+      tag.status = 0;
+
+      uint8_t writeSize = selectedWrite(tag, bank, address, timeOut, data);
+      if (writeSize == 0) {
+        tag.result = PROVISION_WRITE_FAILED; // does not fit a command
+        continue;
       }
+      queueCommand(TMR_SR_OPCODE_WRITE_TAG_DATA, data, writeSize, _provisionDone, this, timeOut);
+      _provIndex[_provHead++ & (CMD_QUEUE_SIZE - 1)] = next - 1;
+
+      uint8_t readSize = selectedRead(tag, bank, address, timeOut, data);
+      queueCommand(TMR_SR_OPCODE_READ_TAG_DATA, data, readSize, _provisionDone, this, timeOut);
+      _provIndex[_provHead++ & (CMD_QUEUE_SIZE - 1)] = next - 1;
     }
+
+    if (processCommands() == 0 && next == count)
+      break;
+    _waitForRx(5);
+  }
+
+  flushCommands();
+  _provTags = NULL;
+
+  uint8_t failed = 0;
+  for (uint8_t t = 0; t < count; t++)
+    if (tags[t].result != PROVISION_OK)
+      failed++;
+  return (failed);
+}
+
+// command queue callback of provisionTags(). Commands complete in the order
+// they were queued, _provIndex has the tag of each
+void RFID::_provisionDone(uint8_t opcode, uint8_t result, uint16_t status, void *ctx) {
+  RFID *self = (RFID *)ctx;
+  ProvisionTag &tag = self->_provTags[self->_provIndex[self->_provTail++ & (CMD_QUEUE_SIZE - 1)]];
+  bool verify = opcode == TMR_SR_OPCODE_READ_TAG_DATA;
+
+  if (tag.result != PROVISION_PENDING)
+    return; // the write failed already
+
+  if (result != ALL_GOOD)
+    tag.result = result == ERROR_COMMAND_RESPONSE_TIMEOUT ? PROVISION_TIMEOUT
+                 : verify ? PROVISION_READ_FAILED : PROVISION_WRITE_FAILED;
+  else if (status != 0) {
+    tag.result = verify ? PROVISION_READ_FAILED : PROVISION_WRITE_FAILED;
+    tag.status = status;
+  } else if (verify) {
+    uint8_t len = (tag.dataLen / 2) * 2;
+    bool same = self->msg[1] >= len + 1 && memcmp(&self->msg[6], tag.data, len) == 0;
+    tag.result = same ? PROVISION_OK : PROVISION_MISMATCH;
+  }
+}
+
+// Checks incoming buffer for the start characters
+// Returns true if a new message is complete and ready to be cracked
+//
+// Bytes are pulled from the UART in bulk into _rxRing and framed from
+// there, so a single call never blocks and several records can be waiting
+// in the ring at once. Each true return hands out exactly one CRC-checked
+// frame in msg; call again (without waiting) to get the next one.
+bool RFID::check() {
+  _fillRing();
+
+  // records held back while a command was answered are older than the ring
+  while (_heldFrame(msg) || _nextFrame(msg)) {
+    // Used for debugging: Does the user want us to print the command to
+    // serial port?
+    if (_printDebug == true) {
+      _debugSerial->print(F("response: "));
+      printMessageArray();
+    }
+
+    // counted here rather than in parseResponse(), so it is counted whatever
+    // the caller (or the filter below) does with the frame
+    if (msg[1] == 0 && msg[2] == TMR_SR_OPCODE_READ_TAG_ID_MULTIPLE && msg[3] == 0x05 && msg[4] == 0x04)
+      _stats.thermalThrottles++;
+
+    if (!_continuousModeTemp)
+      return true;
+
+    // added for temperature special (may2020 / paulvha)
+    /*
+     * September 2020
+     * [FF] [3D] [22] [00] [00] [10] [01] [1F] [0F] [FF] [01] [01] [DD]
+     * [11] [0D] [37] [FC] [00] [00] [00] [B3] [00] [AE] [05] [00] [90] [FF]
+     * [00] [06] [2F] [80] [29] [01] [0E] [01] [54] [00] [0D] [5F] [FB] [FF]
+     * [FF] [DC] [00] [80] [02] [00] [00] [00] [80] [34] [00] [E2] [00] [00]
+     * [15] [86] [0E] [02] [88] [15] [40] [80] [29] [3B] [72]
+     *
+     * [FF]                header
+     * [3D]                length
+     * [22]                opcode
+     * [00] [00]           status
+     * [10]                option byte / continuous reading
+     * [01] [1F]           searchflag
+     * [0F] [FF]           metadata to return
+     * [01]                number of tags
+     * [01]                count
+     * [DD]                RSSI
+     * [11]                antenna
+     * [0D] [37] [FC]      frequency
+     * [00] [00] [00] [B3] Timestamp in ms since last keep alive msg
+     * [00] [AE]           phase
+     * [05]                GEN5
+     * [00] [90]           data length in bits = 144 / 8 = 18
+     * [FF] [00] [06] [2F] [80] [29] [01] [0E] [01] [54] [00] [0D] [5F] [FB]
+     * [FF] [FF] [DC] [00]
+     *
+     * [80]                GPIO status
+     * [02]                initial Q
+     * [00]                GEN2_LINKFREQUENCY
+     * [00]                GEN2_TARGET_A
+     * [00] [80]           length EPC in bits = 128 / 8 = 16 bytes
+     * [34] [00]           PC word
+     * [E2] [00] [00] [15] [86] [0E] [02] [88] [15] [40] [80] [29] EPC
+     * [3B] [72]           EPC CRC
+     */
+    // tag record: the echoed option byte has the metadata flag, plus the
+    // select type when a Gen2 Select is active (0x11 .. 0x14)
+    if (msg[1] > 0 && (msg[5] & TMR_SR_GEN2_SINGULATION_OPTION_FLAG_METADATA))
+      return true; // we have valid data
+
+    if (msg[3] == 0x04)
+      return true; // scan indication (added January 2022)
+
+    if (msg[3] == 0x05 && msg[4] == 0x04)
+      return true; // thermal throttle (status 0x0504), RESPONSE_IS_TEMPTHROTTLE
+
+    // May 2020 & September 2020
+    // positie   14  (dus 1A is de temperatuure = 26C)
+    //             0    1    2    3    4    5   6    7    8    9    10 11
+    //             12   13   14
+    // response:  [FF] [0A] [22] [00] [00] [00] [01] [1F] [02] [82] [00]
+    // [82] [00] [01] [1A]
+    /*  0  [FF]
+     *  1  [0A]         length
+     *  2  [22]         opcode
+     *  3  [00] [00]    status
+     *  5  [00]         port
+     *  6  [01] [1F]    search flag
+     *  8  [02]         STATS UPDATE
+     *  9  [82] [00]    EBV is set ( > 0x80)
+     *  11 [82] [00]    the real indicter (temperature)
+     *  13 [01]         1 data byte
+     *  14 [1A]         TEMP !!!! (26 C)
+     */
+    if (msg[8] == 0x02) { // stats update
+      if (msg[13] == 1 && msg[11] == 0x82)
+        _contTemp = msg[14]; // get temperature
+    }
+
+    // Consumed internally, try the next buffered frame
   }
 
   return (false);
 }
 
-// See parseResponse for breakdown of fields
-// Pulls the number of EPC bytes out of the response
-// Often this is 12 bytes
-uint8_t RFID::getTagEPCBytes(void) {
-  uint16_t epcBits = 0; // Number of bits of EPC (including PC, EPC, and EPC
-                        // CRC)
+// Move whatever the UART has received into the ring with as few bulk reads
+// as possible (at most two: up to the wrap point, then from the start).
+// Only asks for bytes that are already available, so readBytes() never
+// waits on its timeout.
+void RFID::_fillRing(void) {
+  int avail = _rfidSerial->available();
+
+  while (avail > 0) {
+    uint16_t space = RX_RING_SIZE - (uint16_t)(_rxHead - _rxTail);
+    if (space == 0)
+      break; // ring full, leave the rest in the UART buffer for next time
 
-  uint8_t tagDataBytes = getTagDataBytes(); // We need this offset
+    uint16_t idx = _rxHead & (RX_RING_SIZE - 1);
+    uint16_t chunk = RX_RING_SIZE - idx; // contiguous room up to the wrap
+    if (chunk > space)
+      chunk = space;
+    if (chunk > avail)
+      chunk = avail;
 
-  for (uint8_t x = 0; x < 2; x++)
-    epcBits |= (uint16_t)msg[27 + tagDataBytes + x] << (8 * (1 - x));
-  uint8_t epcBytes = epcBits / 8;
-  epcBytes -=
-      4; // Ignore the first two bytes (PC word) and last two bytes (CRC EPC)
+    size_t got = _rfidSerial->readBytes(&_rxRing[idx], chunk);
+    if (got == 0)
+      break;
 
-  return (epcBytes);
+    _rxHead += got;
+    _stats.bytesReceived += got;
+    avail -= got;
+  }
 }
 
+// Extract the next complete frame from the ring into dest.
+// Layout: FF LEN OP STATUSHI STATUSLO [LEN data bytes] CRCHI CRCLO
+//
+// Returns false (leaving the partial frame in the ring) if the frame is
+// not complete yet. A candidate header whose length is impossible or whose
+// CRC does not match is skipped one byte at a time, so after line noise or
+// a lost byte we resync on the next 0xFF instead of dropping a whole buffer.
+bool RFID::_nextFrame(uint8_t *dest) {
+  bool inSync = true; // _rxTail is where the previous frame ended
+
+  while (_rxHead != _rxTail) {
+    int16_t len = _frameAt(0, dest);
+
+    if (len > 0) {
+      _rxTail += len;
+      _stats.framesReceived++;
+      return (true);
+    }
+
+    if (len < 0) {
+      if (inSync) {
+        if (len == -2)
+          _stats.crcErrors++;
+        _stats.resyncs++;
+        inSync = false;
+      }
+      _rxTail++; // not a frame, resync on the next 0xFF
+      continue;
+    }
+
+    // Incomplete. After corruption the "header" may really be an 0xFF inside
+    // tag data claiming a long length, which would hold back every good
+    // frame behind it. If a complete valid frame already sits further into
+    // the ring, the candidate was false: skip up to it. Only rescan when new
+    // bytes came in, a genuine partial frame just waits.
+    uint16_t used = _rxHead - _rxTail;
+    if (_rxScanned == _rxHead)
+      return (false);
+    _rxScanned = _rxHead;
+
+    for (uint16_t off = 1; off < used; off++) {
+      if (_rxRing[(_rxTail + off) & (RX_RING_SIZE - 1)] == 0xFF &&
+          _frameAt(off, dest) > 0) {
+        _rxTail += off;
+        if (inSync)
+          _stats.resyncs++;
+        break;
+      }
+    }
+
+    if ((uint16_t)(_rxHead - _rxTail) == used)
+      return (false); // nothing better found, wait for more bytes
+  }
+
+  return (false);
+}
+
+// Check whether a frame starts at _rxTail + offset
+// Returns the frame length if a complete, CRC-valid frame is found (it is
+// copied into dest), 0 if it could still be one but is incomplete, -1 if
+// it can not be a frame, or -2 if it is complete but fails the CRC.
+int16_t RFID::_frameAt(uint16_t offset, uint8_t *dest) {
+  const uint16_t mask = RX_RING_SIZE - 1;
+  uint16_t start = _rxTail + offset;
+  uint16_t used = _rxHead - start;
+
+  // Wait for header byte
+  if (_rxRing[start & mask] != 0xFF)
+    return (-1);
+
+  if (used < 2)
+    return (0); // need the length byte
+
+  uint16_t frameLength = _rxRing[(start + 1) & mask] + 7;
+  if (frameLength > MAX_MSG_SIZE)
+    return (-1); // can not be a real header
+
+  if (used < frameLength)
+    return (0); // rest of the frame still on its way
+
+  // copy out in (at most) two pieces around the wrap point
+  uint16_t idx = start & mask;
+  uint16_t first = RX_RING_SIZE - idx;
+  if (first > frameLength)
+    first = frameLength;
+  memcpy(dest, &_rxRing[idx], first);
+  memcpy(dest + first, &_rxRing[0], frameLength - first);
+
+  uint16_t crc = calculateCRC(&dest[1], frameLength - 3);
+  if ((dest[frameLength - 2] != (crc >> 8)) ||
+      (dest[frameLength - 1] != (crc & 0xFF)))
+    return (-2); // corrupted, or a false header (0xFF inside data)
+
+  return (frameLength);
+}
+
+// Discard both the ring and anything still waiting in the UART
+void RFID::_flushRing(void) {
+  _rxHead = _rxTail = _rxScanned = 0;
+
+  while (_rfidSerial->available())
+    _rfidSerial->read();
+}
+
+// A streamed record that came in ahead of a command response. Stored as
+// it is, the frame's own length byte tells where the next one starts
+void RFID::_holdFrame(const uint8_t *frame) {
+  const uint16_t mask = RX_HOLD_SIZE - 1;
+  uint16_t frameLength = frame[1] + 7;
+
+  _stats.recordsHeld++;
+  if (RX_HOLD_SIZE - (uint16_t)(_holdHead - _holdTail) < frameLength) {
+    _stats.recordsHeldDropped++;
+    return;
+  }
+
+  uint16_t idx = _holdHead & mask;
+  uint16_t first = RX_HOLD_SIZE - idx;
+  if (first > frameLength)
+    first = frameLength;
+  memcpy(&_holdRing[idx], frame, first);
+  memcpy(&_holdRing[0], frame + first, frameLength - first);
+  _holdHead += frameLength;
+}
+
+bool RFID::_heldFrame(uint8_t *dest) {
+  const uint16_t mask = RX_HOLD_SIZE - 1;
+
+  if (_holdHead == _holdTail)
+    return (false);
+
+  uint16_t frameLength = _holdRing[(_holdTail + 1) & mask] + 7;
+  uint16_t idx = _holdTail & mask;
+  uint16_t first = RX_HOLD_SIZE - idx;
+  if (first > frameLength)
+    first = frameLength;
+  memcpy(dest, &_holdRing[idx], first);
+  memcpy(dest + first, &_holdRing[0], frameLength - first);
+  _holdTail += frameLength;
+  return (true);
+}
+
+// Decode one tag record (see parseResponse for breakdown of fields)
+//
+// The fields after the tag count are walked in metadata flag order, so the
+// offsets follow whatever metadata was requested in the read blob instead
+// of being fixed for 0x01FF. Everything is resolved in this single pass;
+// epc and data point into frame.
+bool RFID::decodeTagRecord(const uint8_t *frame, TagRecord &rec) {
+  memset(&rec, 0, sizeof(rec));
+
+  // [5] option [6, 7] search flags [8, 9] metadata [10] tag count
+  uint16_t end = frame[1] + 5; // first CRC byte
+  uint16_t metadata = frame[8] << 8 | frame[9];
+  uint16_t i = 11;
+
+  if (end < i || (metadata & ~TMR_TRD_METADATA_FLAG_ALL_KNOWN))
+    return (false);
+
+  rec.metadata = metadata;
+
+  // fixed size metadata up to (and excluding) DATA
+  static const uint8_t fieldSize[] = {1, 1, 1, 3, 4, 2, 1};
+  uint8_t fixed = 0;
+  for (uint8_t f = 0; f < sizeof(fieldSize); f++)
+    if (metadata & (1 << f))
+      fixed += fieldSize[f];
+  if (i + fixed > end)
+    return (false);
+
+  if (metadata & TMR_TRD_METADATA_FLAG_READCOUNT)
+    rec.readCount = frame[i++];
+
+  if (metadata & TMR_TRD_METADATA_FLAG_RSSI)
+    rec.rssi = (int8_t)frame[i++];
+
+  if (metadata & TMR_TRD_METADATA_FLAG_ANTENNAID)
+    rec.antenna = frame[i++];
+
+  if (metadata & TMR_TRD_METADATA_FLAG_FREQUENCY) {
+    rec.freq = (uint32_t)frame[i] << 16 | (uint16_t)frame[i + 1] << 8 |
+               frame[i + 2];
+    i += 3;
+  }
+
+  if (metadata & TMR_TRD_METADATA_FLAG_TIMESTAMP) {
+    rec.timestamp = (uint32_t)frame[i] << 24 | (uint32_t)frame[i + 1] << 16 |
+                    (uint16_t)frame[i + 2] << 8 | frame[i + 3];
+    i += 4;
+  }
+
+  if (metadata & TMR_TRD_METADATA_FLAG_PHASE) {
+    rec.phase = frame[i] << 8 | frame[i + 1];
+    i += 2;
+  }
+
+  if (metadata & TMR_TRD_METADATA_FLAG_PROTOCOL)
+    rec.protocol = frame[i++];
+
+  if (metadata & TMR_TRD_METADATA_FLAG_DATA) {
+    if (i + 2 > end)
+      return (false);
+
+    uint16_t dataBits = frame[i] << 8 | frame[i + 1];
+    i += 2;
+
+    uint16_t dataBytes = (dataBits + 7) / 8; // Ceiling trick
+    if (i + dataBytes > end)
+      return (false);
+
+    rec.dataLen = dataBytes;
+    rec.data = dataBytes ? &frame[i] : NULL;
+    i += dataBytes;
+  }
+
+  // the remaining single byte fields, then the 2 byte brand ID
+  if (metadata & TMR_TRD_METADATA_FLAG_GPIO_STATUS)
+    i++;
+  if (metadata & TMR_TRD_METADATA_FLAG_GEN2_Q)
+    i++;
+  if (metadata & TMR_TRD_METADATA_FLAG_GEN2_LF)
+    i++;
+  if (metadata & TMR_TRD_METADATA_FLAG_GEN2_TARGET)
+    i++;
+  if (metadata & TMR_TRD_METADATA_FLAG_BRAND_IDENTIFIER)
+    i += 2;
+
+  // EPC length in bits, including PC and EPC CRC
+  if (i + 2 > end)
+    return (false);
+  uint16_t epcBytes = (frame[i] << 8 | frame[i + 1]) / 8;
+  i += 2;
+
+  if (epcBytes < 4 || i + epcBytes > end)
+    return (false);
+
+  rec.pc = frame[i] << 8 | frame[i + 1];
+  i += 2;
+  epcBytes -= 4; // Ignore the PC word and last two bytes (CRC EPC)
+
+  // XPC_W1 (and XPC_W2) follow the PC word if its XI bit is set
+  if (rec.pc & 0x0200) {
+    if (epcBytes < 2)
+      return (false);
+    bool xpcW2 = frame[i] & 0x80;
+    i += 2;
+    epcBytes -= 2;
+    if (xpcW2) {
+      if (epcBytes < 2)
+        return (false);
+      i += 2;
+      epcBytes -= 2;
+    }
+  }
+
+  rec.epc = &frame[i];
+  rec.epcLen = epcBytes;
+
+  return (true);
+}
+
+// Pulls the number of EPC bytes out of the response
+// Often this is 12 bytes
+uint8_t RFID::getTagEPCBytes(void) { return (_tag.epcLen); }
+
 // get the data that was received in continuous mode from the msg
-// See parseResponse for breakdown of fields
 // added september 2020
 uint8_t RFID::getTagData(uint8_t *buf, uint8_t len) {
-  uint8_t tagDataBytes = getTagDataBytes();
+  uint8_t tagDataBytes = _tag.dataLen;
 
   // no data
   if (tagDataBytes == 0)
@@ -1645,65 +2497,31 @@ uint8_t RFID::getTagData(uint8_t *buf, uint8_t len) {
     tagDataBytes = len;
 
   // copy the data
-  for (uint8_t x = 0; x < tagDataBytes; x++)
-    buf[x] = msg[26 + x];
+  memcpy(buf, _tag.data, tagDataBytes);
 
   // return number of bytes in buffer
   return (tagDataBytes);
 }
 
-// See parseResponse for breakdown of fields
 // Pulls the number of data bytes out of the response
 // Often this is zero
-uint8_t RFID::getTagDataBytes(void) {
-  // Number of bits of embedded tag data
-  uint16_t tagDataLength = 0;
-
-  // get number of data bits
-  for (uint8_t x = 0; x < 2; x++)
-    tagDataLength |= (uint16_t)msg[24 + x] << (8 * (1 - x));
-
-  // turn to bytes
-  uint8_t tagDataBytes = tagDataLength / 8;
-  if (tagDataLength % 8 > 0)
-    tagDataBytes++; // Ceiling trick
-
-  return (tagDataBytes);
-}
-
-// See parseResponse for breakdown of fields
-// Pulls the timestamp since last Keep-Alive message from a full response record
-// stored in msg
-uint16_t RFID::getTagTimestamp(void) {
-  // Timestamp since last Keep-Alive message
-  uint32_t timeStamp = 0;
-  for (uint8_t x = 0; x < 4; x++)
-    timeStamp |= (uint32_t)msg[17 + x] << (8 * (3 - x));
-
-  return (timeStamp);
-}
+uint8_t RFID::getTagDataBytes(void) { return (_tag.dataLen); }
 
-// See parseResponse for breakdown of fields
-// Pulls the frequency value from a full response record stored in msg
-uint32_t RFID::getTagFreq(void) {
-  // Frequency of the tag detected is loaded over three bytes
-  uint32_t freq = 0;
-  for (uint8_t x = 0; x < 3; x++)
-    freq |= (uint32_t)msg[14 + x] << (8 * (2 - x));
+// Pulls the timestamp since last Keep-Alive message from a full response
+// record
+uint16_t RFID::getTagTimestamp(void) { return (_tag.timestamp); }
 
-  return (freq);
-}
+// Pulls the frequency value from a full response record
+uint32_t RFID::getTagFreq(void) { return (_tag.freq); }
 
-// See parseResponse for breakdown of fields
-// Pulls the RSSI value from a full response record stored in msg
-int8_t RFID::getTagRSSI(void) { return (msg[12] - 256); }
+// Pulls the RSSI value from a full response record
+int8_t RFID::getTagRSSI(void) { return (_tag.rssi); }
 
 // get the tag phasing
 // special add September 2024
-int16_t RFID::getTagPhase(void) {
-  uint16_t ret = msg[21] << 8 | msg[22];
-  return ret;
-}
+int16_t RFID::getTagPhase(void) { return (_tag.phase); }
+
+uint8_t RFID::getTagAntenna(void) { return (_tag.antenna); }
 
 // This will parse whatever response is currently in msg into its constituents
 // Mostly used for parsing out the tag IDs and RSSI from a multi tag continuous
@@ -1776,21 +2594,11 @@ uint8_t RFID::parseResponse(void) {
   32 + M + N [3B] [72]            EPC CRC
   */
 
-  uint8_t msgLength =
-      msg[1] + 7; // Add 7 (the header, length, opcode, status, and CRC) to the
-                  // LEN field to get total bytes
   uint8_t opCode = msg[2];
   uint16_t statusMsg = 0;
 
-  // Check the CRC on this response
-  uint16_t messageCRC = calculateCRC(
-      &msg[1],
-      msgLength -
-          3); // Ignore header (start spot 1), remove 3 bytes (header + 2 CRC)
-  if ((msg[msgLength - 2] != (messageCRC >> 8)) ||
-      (msg[msgLength - 1] != (messageCRC & 0xFF))) {
-    return (ERROR_CORRUPT_RESPONSE);
-  }
+  // No CRC check here: msg is only filled by _nextFrame() (check() and
+  // sendCommand()), which already dropped every frame with a bad CRC
 
   if (opCode == TMR_SR_OPCODE_READ_TAG_ID_MULTIPLE) // opCode = 0x22
   {
@@ -1805,9 +2613,10 @@ uint8_t RFID::parseResponse(void) {
         statusMsg |= (uint32_t)msg[3 + x] << (8 * (1 - x));
 
       if (statusMsg == 0x0400) {
+        _stats.keepAlives++;
         return (RESPONSE_IS_KEEPALIVE);
       } else if (statusMsg == 0x0504) {
-        return (RESPONSE_IS_TEMPTHROTTLE);
+        return (RESPONSE_IS_TEMPTHROTTLE); // counted by check()
       }
     } else if (msg[1] == 0x08) // Unknown
     {
@@ -1818,6 +2627,7 @@ uint8_t RFID::parseResponse(void) {
     else if (msg[1] == 0x0E) // added September 2020
     {
       if (statusMsg == 0x0400) {
+        _stats.keepAlives++;
         return (RESPONSE_IS_KEEPALIVE);
       }
     }
@@ -1830,8 +2640,15 @@ uint8_t RFID::parseResponse(void) {
     } else // Full tag record
     {
       // This is a full tag response
-      // User can now pull out RSSI, frequency of tag, timestamp, EPC, Protocol
-      // control bits, EPC CRC, CRC
+      // Resolve RSSI, frequency of tag, timestamp, EPC, Protocol control bits
+      // and embedded data once. User can now pull them out with
+      // getTagRecord() (or the getTagxxx() shortcuts)
+      if (!decodeTagRecord(msg, _tag)) {
+        _stats.corruptRecords++;
+        return (ERROR_CORRUPT_RESPONSE);
+      }
+
+      _countTagRead();
       return (RESPONSE_IS_TAGFOUND);
     }
   }
@@ -1848,25 +2665,195 @@ uint8_t RFID::parseResponse(void) {
 // sentence and send it
 void RFID::sendMessage(uint8_t opcode, uint8_t *data, uint8_t size,
                        uint16_t timeOut, boolean waitForResponse) {
+  if (_skipSend(opcode, data, size, timeOut, waitForResponse))
+    return;
+
   msg[1] = size; // Load the length of this operation into msg array
   msg[2] = opcode;
 
   // Copy the data into msg array
-  for (uint8_t x = 0; x < size; x++)
-    msg[3 + x] = data[x];
+  if (size > 0)
+    memcpy(&msg[3], data, size);
 
   sendCommand(timeOut, waitForResponse); // Send and wait for response
+
+  _cacheResult(opcode, data, size, waitForResponse);
+}
+
+// A frame that is complete already (RFIDFrame): no copy, no CRC
+void RFID::sendFrame(const uint8_t *frame, uint16_t timeOut,
+                     boolean waitForResponse) {
+  uint8_t size = frame[1];
+  uint8_t opcode = frame[2];
+
+  if (_skipSend(opcode, &frame[3], size, timeOut, waitForResponse))
+    return;
+
+  if (_printDebug == true) {
+    memcpy(msg, frame, size + 5);
+    _debugSerial->print(F("sendFrame: "));
+    printMessageArray();
+  }
+
+  _transmit(frame, timeOut, waitForResponse);
+
+  _cacheResult(opcode, &frame[3], size, waitForResponse);
+}
+
+// The cases where a command does not go on the wire, msg holds the result
+bool RFID::_skipSend(uint8_t opcode, const uint8_t *data, uint8_t size,
+                     uint16_t timeOut, boolean waitForResponse) {
+  // The module already has this setting: nothing to send
+  if (waitForResponse && _cacheHit(opcode, data, size)) {
+    msg[0] = ALL_GOOD;
+    msg[1] = 0;
+    msg[2] = opcode;
+    msg[3] = 0; // status word
+    msg[4] = 0;
+    return (true);
+  }
+
+  // Warm start: the module is known to have it, just remember it
+  if (_seeding) {
+    _cacheStore(opcode, data, size);
+    msg[0] = ALL_GOOD;
+    msg[3] = 0;
+    msg[4] = 0;
+    return (true);
+  }
+
+  // Between beginBatch() and endBatch(): queue it and tell the caller it
+  // went fine, the real result goes to the batch callback / endBatch()
+  if (_batching) {
+    bool queued = queueCommand(opcode, data, size, _batchCallback, _batchCtx, timeOut);
+    if (queued)
+      _cacheStore(opcode, data, size); // forgotten again if it fails
+    msg[0] = queued ? ALL_GOOD : ERROR_INVALID_REQ;
+    msg[3] = 0;
+    msg[4] = 0;
+    return (true);
+  }
+
+  return (false);
+}
+
+// Remember a setting the module took, forget one it may not have
+void RFID::_cacheResult(uint8_t opcode, const uint8_t *data, uint8_t size,
+                        boolean waitForResponse) {
+  if (!waitForResponse)
+    _cacheForget(opcode, data, size); // no idea whether it was taken
+  else if (msg[0] == ALL_GOOD && msg[3] == 0 && msg[4] == 0)
+    _cacheStore(opcode, data, size);
+  else
+    _cacheForget(opcode, data, size);
+}
+
+/*********************************************************************
+ * Shadow configuration
+ *********************************************************************/
+
+void RFID::useConfigCache(bool enable) {
+  _configCacheOn = enable;
+  invalidateConfigCache();
+}
+
+void RFID::invalidateConfigCache(void) {
+  memset(_configCache, 0, sizeof(_configCache));
+}
+
+// The cache entry for a settings command, NULL if the opcode is not a
+// setting (or there is no room when create is true)
+ConfigCacheEntry *RFID::_cacheEntry(uint8_t opcode, const uint8_t *data,
+                                    uint8_t size, bool create) {
+  uint8_t key = 0;
+
+  if (!_configCacheOn)
+    return (NULL);
+
+  switch (opcode) {
+  case TMR_SR_OPCODE_SET_REGION:
+  case TMR_SR_OPCODE_SET_READ_TX_POWER:
+  case TMR_SR_OPCODE_SET_WRITE_TX_POWER:
+  case TMR_SR_OPCODE_SET_TAG_PROTOCOL:
+  case TMR_SR_OPCODE_SET_POWER_MODE:
+    break;
+
+  // port (2 bytes) or one of the antenna list options
+  case TMR_SR_OPCODE_SET_ANTENNA_PORT:
+    key = size == 2 ? 0xFF : data[0];
+    break;
+
+  // [key value form / protocol] [parameter] [value..]
+  case TMR_SR_OPCODE_SET_READER_OPTIONAL_PARAMS:
+  case TMR_SR_OPCODE_SET_PROTOCOL_PARAM:
+    if (size < 2)
+      return (NULL);
+    key = data[1];
+    break;
+
+  default:
+    return (NULL);
+  }
+
+  ConfigCacheEntry *slot = NULL;
+
+  for (uint8_t i = 0; i < CONFIG_CACHE_SIZE; i++) {
+    ConfigCacheEntry *e = &_configCache[i];
+    if (e->opcode == opcode && e->key == key) {
+      // too long to remember (a long antenna list): the old value is stale
+      if (create && size > CONFIG_CACHE_DATA) {
+        memset(e, 0, sizeof(ConfigCacheEntry));
+        return (NULL);
+      }
+      return (e);
+    }
+    if (e->opcode == 0 && slot == NULL)
+      slot = e;
+  }
+
+  if (!create || slot == NULL || size > CONFIG_CACHE_DATA)
+    return (NULL);
+
+  slot->opcode = opcode;
+  slot->key = key;
+  slot->size = 0xFF; // no value yet
+  return (slot);
+}
+
+bool RFID::_cacheHit(uint8_t opcode, const uint8_t *data, uint8_t size) {
+  ConfigCacheEntry *e = _cacheEntry(opcode, data, size, false);
+
+  return (e != NULL && e->size == size && memcmp(e->data, data, size) == 0);
+}
+
+void RFID::_cacheStore(uint8_t opcode, const uint8_t *data, uint8_t size) {
+  ConfigCacheEntry *e = _cacheEntry(opcode, data, size, true);
+
+  if (e == NULL)
+    return;
+
+  e->size = size;
+  memcpy(e->data, data, size);
+}
+
+void RFID::_cacheForget(uint8_t opcode, const uint8_t *data, uint8_t size) {
+  ConfigCacheEntry *e = _cacheEntry(opcode, data, size, false);
+
+  if (e != NULL)
+    memset(e, 0, sizeof(ConfigCacheEntry));
 }
 
 // Given an array, calc CRC, assign header, send it out
 // Modifies the caller's msg array
+//
+// The response is collected through the same streaming parser as check().
+// We sleep until the UART reports new bytes (see begin(HardwareSerial &))
+// and return as soon as a CRC-valid frame with our opcode is complete, or
+// after responseTimeout() if the module stays silent.
 void RFID::sendCommand(uint16_t timeOut, boolean waitForResponse) {
   msg[0] = 0xFF; // Universal header
   uint8_t messageLength = msg[1];
 
-  uint8_t opcode =
-      msg[2]; // Used to see if response from module has the same opcode
-
   // Attach CRC
   uint16_t crc = calculateCRC(
       &msg[1], messageLength + 2); // Calc CRC starting from spot 1, not 0. Add
@@ -1881,126 +2868,439 @@ void RFID::sendCommand(uint16_t timeOut, boolean waitForResponse) {
     _debugSerial->print(F("sendCommand: "));
     printMessageArray();
   }
+
+  _transmit(msg, timeOut, waitForResponse);
+}
+
+// Put a complete frame on the wire and collect the response into msg
+// frame may be msg itself, it is written out before anything is received
+void RFID::_transmit(const uint8_t *frame, uint16_t timeOut,
+                     boolean waitForResponse) {
 #ifdef ARDUINO_ARCH_ESP32
-  else
-    delay(ESP32_DELAY);
+  // the task stays paused until the sketch is done with the response in
+  // msg, it resumes on the next readStreamedTag()
+  if (_pauseStreaming())
+    _bgResume = true;
+  _exchange(frame, timeOut, waitForResponse);
+#else
+  _exchange(frame, timeOut, waitForResponse);
 #endif
+}
 
-  // Remove anything in the incoming buffer
-  // TODO this is a bad idea if we are constantly readings tags
-  while (_rfidSerial->available())
-    _rfidSerial->read();
+void RFID::_exchange(const uint8_t *frame, uint16_t timeOut,
+                     boolean waitForResponse) {
+  uint8_t opcode = frame[2];
 
-  // Send the command to the module
-  for (uint8_t x = 0; x < messageLength + 5; x++)
-    _rfidSerial->write(msg[x]);
+  // Remove anything left over in the incoming buffer: a late answer to an
+  // earlier command must not pass for this one. Not while reading though,
+  // the ring is full of tag records then. They are held for check() below
+  if (!_continuousModeTemp)
+    _flushRing();
+
+  // Send the command to the module, one write for the whole frame
+  _rfidSerial->write(frame, frame[1] + 5);
 
   // There are some commands (setBaud) that we can't or don't want the response
-  // _rfidSerial->flush() a working function not implemented on all MCU
-  if (waitForResponse == false) {
-    //_rfidSerial->flush(); // (changed july 2025) Wait for serial sending to
-    //complete
-    delay(50);
-    unsigned long drainStart = millis();
-    while (millis() - drainStart < 250) {
-      while (_rfidSerial->available()) {
-        _rfidSerial->read();
-      }
-      delay(5);
-    }
+  if (waitForResponse == false)
     return;
-  }
-
-  // For debugging, probably remove
-  // for (uint8_t x = 0 ; x < 100 ; x++) msg[x] = 0;
 
-  // Wait for response with timeout
+  // Layout of response in data array:
+  // [0] [1] [2] [3]      [4]      [5] [6]  ... [LEN+4] [LEN+5] [LEN+6]
+  // FF  LEN OP  STATUSHI STATUSLO xx  xx   ... xx      CRCHI   CRCLO
+  uint32_t maxWait = responseTimeout(opcode, timeOut);
   uint32_t startTime = millis();
 
-  while (_rfidSerial->available() == false) {
-    if (millis() - startTime > (timeOut * 2)) {
+  while (true) {
+    _fillRing();
+
+    if (_nextFrame(msg)) {
+      // did we get a response to the command we sent or a different one?
+      if (msg[2] == opcode)
+        break;
+
+      // While continuous reading the module keeps streaming tag records
+      // around the answer to our command. Those are not an error: keep
+      // them for check(). A stop may also be sent to a module left reading
+      // by a previous session, nobody is waiting for those records
+      if (msg[2] == TMR_SR_OPCODE_READ_TAG_ID_MULTIPLE) {
+        if (_continuousModeTemp) {
+          _holdFrame(msg);
+          continue;
+        }
+        if (opcode == TMR_SR_OPCODE_MULTI_PROTOCOL_TAG_OP)
+          continue;
+      }
+
+      if (_printDebug == true) {
+        _debugSerial->print("Wrong opcode response expected ");
+        _debugSerial->print(opcode, HEX);
+        _debugSerial->print(" got ");
+        _debugSerial->println(msg[2], HEX);
+      }
+      msg[0] = ERROR_WRONG_OPCODE_RESPONSE;
+      return;
+    }
+
+    uint32_t elapsed = millis() - startTime;
+    if (elapsed >= maxWait) {
       if (_printDebug == true)
-        _debugSerial->println(F("Time out 1: No response from module"));
+        _debugSerial->println(F("Time out: No (complete) response from module"));
+      _stats.commandTimeouts++;
       msg[0] = ERROR_COMMAND_RESPONSE_TIMEOUT;
       return;
     }
-    delay(1);
+
+    _waitForRx(maxWait - elapsed);
   }
 
-  // Layout of response in data array:
-  // [0] [1] [2] [3]      [4]      [5] [6]  ... [LEN+4] [LEN+5] [LEN+6]
-  // FF  LEN OP  STATUSHI STATUSLO xx  xx   ... xx      CRCHI   CRCLO
-  messageLength =
-      MAX_MSG_SIZE -
-      1; // Make the max length for now, adjust it when the actual len comes in
-  startTime = millis();
-  uint8_t spot = 0;
-  while (spot < messageLength) {
-    if (millis() - startTime > timeOut) {
-      if (_printDebug == true) {
-        _debugSerial->print(F("Time out 2: Incomplete response "));
-        _debugSerial->println(spot);
-      }
-      msg[0] = ERROR_COMMAND_RESPONSE_TIMEOUT;
-      return;
+  _countLatency(millis() - startTime);
+
+  // Used for debugging: Does the user want us to print the command to serial
+  // port?
+  if (_printDebug == true) {
+    _debugSerial->print(F("response: "));
+    printMessageArray();
+  }
+
+  // CRC was checked by the parser and opcode matches
+  // If everything is ok, load all ok into msg array
+  msg[0] = ALL_GOOD;
+}
+
+/*********************************************************************
+ * Asynchronous command queue
+ *********************************************************************/
+
+bool RFID::queueCommand(uint8_t opcode, const uint8_t *data, uint8_t size,
+                        RFIDCommandCallback callback, void *ctx,
+                        uint16_t timeOut) {
+  if (_cmdCount >= CMD_QUEUE_SIZE || size > CMD_QUEUE_DATA_MAX)
+    return (false);
+
+  QueuedCommand &cmd = _cmdQueue[(_cmdTail + _cmdCount) & (CMD_QUEUE_SIZE - 1)];
+  cmd.callback = callback;
+  cmd.ctx = ctx;
+  cmd.timeOut = timeOut;
+  cmd.opcode = opcode;
+  cmd.size = size;
+  if (size > 0)
+    memcpy(cmd.data, data, size);
+
+  _cmdCount++;
+  return (true);
+}
+
+void RFID::setCommandWindow(uint8_t window) {
+  if (window < 1)
+    window = 1;
+  if (window > CMD_WINDOW_MAX)
+    window = CMD_WINDOW_MAX;
+  _cmdWindow = window;
+}
+
+void RFID::_sendQueued(QueuedCommand &cmd) {
+  uint8_t frame[CMD_QUEUE_DATA_MAX + 5];
+
+  frame[0] = 0xFF;
+  frame[1] = cmd.size;
+  frame[2] = cmd.opcode;
+  memcpy(&frame[3], cmd.data, cmd.size);
+
+  uint16_t crc = calculateCRC(&frame[1], cmd.size + 2);
+  frame[cmd.size + 3] = crc >> 8;
+  frame[cmd.size + 4] = crc & 0xFF;
+
+  if (_printDebug == true) {
+    _debugSerial->print(F("queued command: "));
+    for (uint8_t x = 0; x < cmd.size + 5; x++) {
+      _debugSerial->print(F(" ["));
+      if (frame[x] < 0x10)
+        _debugSerial->print(F("0"));
+      _debugSerial->print(frame[x], HEX);
+      _debugSerial->print(F("]"));
     }
+    _debugSerial->println();
+  }
+
+  _rfidSerial->write(frame, cmd.size + 5);
+  cmd.sentMs = millis();
+}
+
+void RFID::_completeCommand(uint8_t result) {
+  QueuedCommand &cmd = _cmdQueue[_cmdTail];
+  uint16_t status = 0;
+
+  if (result == ALL_GOOD) {
+    status = ((uint16_t)msg[3] << 8) | msg[4];
+    _countLatency(millis() - cmd.sentMs);
+  } else if (result == ERROR_COMMAND_RESPONSE_TIMEOUT)
+    _stats.commandTimeouts++;
+
+  if (result != ALL_GOOD || status != 0) {
+    _cmdFailed++;
+    _cacheForget(cmd.opcode, cmd.data, cmd.size);
+  }
+
+  _cmdTail = (_cmdTail + 1) & (CMD_QUEUE_SIZE - 1);
+  _cmdCount--;
+  _cmdSent--;
 
-    if (_rfidSerial->available()) {
-      msg[spot] = _rfidSerial->read();
+  // the module only starts on the next one now
+  if (_cmdSent > 0)
+    _cmdQueue[_cmdTail].sentMs = millis();
 
-      if (spot == 1) // Grab the length of this response (spot 1)
-        messageLength =
-            msg[1] +
-            7; // Actual length of response is ? + 7 for extra stuff (header,
-               // Length, opcode, 2 status bytes, ..., 2 bytes CRC = 7)
+  if (cmd.callback != NULL)
+    cmd.callback(cmd.opcode, result, status, cmd.ctx);
+}
+
+uint8_t RFID::processCommands(void) {
+  // fill the window
+  while (_cmdSent < _cmdCount && _cmdSent < _cmdWindow) {
+    _sendQueued(_cmdQueue[(_cmdTail + _cmdSent) & (CMD_QUEUE_SIZE - 1)]);
+    _cmdSent++;
+  }
+
+  _fillRing();
 
-      spot++;
+  while (_cmdSent > 0 && _nextFrame(msg)) {
+    uint8_t opcode = _cmdQueue[_cmdTail].opcode;
 
-      // There's a case were we miss the end of one message and spill into
-      // another message. We don't want spot pointing at an illegal spot in the
-      // array
-      spot %= MAX_MSG_SIZE; // Wrap condition
+    if (msg[2] == opcode) {
+      if (_printDebug == true) {
+        _debugSerial->print(F("response: "));
+        printMessageArray();
+      }
+      _completeCommand(ALL_GOOD);
+    }
+    // still reading: keep the record for check(), else a left over
+    else if (msg[2] == TMR_SR_OPCODE_READ_TAG_ID_MULTIPLE) {
+      if (_continuousModeTemp)
+        _holdFrame(msg);
+      continue;
+    }
+    else {
+      if (_printDebug == true) {
+        _debugSerial->print("Wrong opcode response expected ");
+        _debugSerial->print(opcode, HEX);
+        _debugSerial->print(" got ");
+        _debugSerial->println(msg[2], HEX);
+      }
+      _completeCommand(ERROR_WRONG_OPCODE_RESPONSE);
+    }
+
+    // keep the module busy
+    while (_cmdSent < _cmdCount && _cmdSent < _cmdWindow) {
+      _sendQueued(_cmdQueue[(_cmdTail + _cmdSent) & (CMD_QUEUE_SIZE - 1)]);
+      _cmdSent++;
     }
   }
 
-  // Used for debugging: Does the user want us to print the command to serial
-  // port?
+  if (_cmdSent > 0) {
+    QueuedCommand &cmd = _cmdQueue[_cmdTail];
+    if (millis() - cmd.sentMs >= responseTimeout(cmd.opcode, cmd.timeOut)) {
+      if (_printDebug == true)
+        _debugSerial->println(F("Time out: No (complete) response from module"));
+      _completeCommand(ERROR_COMMAND_RESPONSE_TIMEOUT);
+    }
+  }
 
-  if (_printDebug == true) {
-    _debugSerial->print(F("response: "));
-    printMessageArray();
+  return (_cmdCount);
+}
+
+uint8_t RFID::flushCommands(void) {
+  while (processCommands() > 0)
+    _waitForRx(5);
+
+  uint8_t failed = _cmdFailed;
+  _cmdFailed = 0;
+  return (failed);
+}
+
+void RFID::beginBatch(RFIDCommandCallback callback, void *ctx) {
+  _batchCallback = callback;
+  _batchCtx = ctx;
+  _batching = true;
+}
+
+uint8_t RFID::endBatch(void) {
+  _batching = false;
+  return (flushCommands());
+}
+
+uint8_t RFID::applyProfile(const ReaderProfile &profile,
+                           RFIDCommandCallback callback, void *ctx) {
+  beginBatch(callback, ctx);
+  _profileCommands(profile);
+  return (endBatch());
+}
+
+void RFID::_profileCommands(const ReaderProfile &profile) {
+  setTagProtocol();       // GEN2 (0x05)
+  setAntennaPort();       // TX=1, RX=1
+  setAntennaSearchList();
+  _checkedCommands(profile);
+}
+
+// The part of a profile profileMatches() reads back
+void RFID::_checkedCommands(const ReaderProfile &profile) {
+  setRegion(profile.region);
+  setReadPower(profile.readPower);
+
+  setGen2Session(profile.session);
+  setGen2Target(profile.target);
+  setGen2Q(profile.qType, profile.qInit, profile.qInit <= 10);
+  if (profile.rfMode != TMR_GEN2_RFMODE_INVALID)
+    setGen2RFmode(profile.rfMode);
+}
+
+bool RFID::profileMatches(const ReaderProfile &profile) {
+  uint8_t region = profile.region;
+  if (region == REGION_NORTHAMERICA && _moduleType == ThingMagic_M6E_NANO)
+    region = REGION_NORTHAMERICA2; // as setRegion() does
+
+  // response data starts at msg[5]
+  sendMessage(TMR_SR_OPCODE_GET_REGION);
+  if (msg[0] != ALL_GOOD || msg[5] != region)
+    return (false);
+
+  // [option] [power hi] [power lo]
+  getReadPower();
+  if (msg[0] != ALL_GOOD || (int16_t)(((uint16_t)msg[6] << 8) | msg[7]) != profile.readPower)
+    return (false);
+
+  // [protocol] [parameter] [value..]
+  uint8_t data[2] = {0x05, 0x00}; // GEN2, TMR_SR_GEN2_CONFIGURATION_SESSION
+  sendMessage(TMR_SR_OPCODE_GET_PROTOCOL_PARAM, data, sizeof(data));
+  if (msg[0] != ALL_GOOD || msg[7] != profile.session)
+    return (false);
+
+  // the two bytes setGen2Target() sends after the parameter
+  if (profile.target >= TMR_GEN2_TARGET_INVALID)
+    return (false);
+  data[1] = 0x01; // TMR_SR_GEN2_CONFIGURATION_TARGET
+  sendMessage(TMR_SR_OPCODE_GET_PROTOCOL_PARAM, data, sizeof(data));
+  const uint8_t *target = gen2TargetFrames[profile.target];
+  if (msg[0] != ALL_GOOD || msg[7] != target[5] || msg[8] != target[6])
+    return (false);
+
+  // [Q type] [Q], the value only with static Q
+  data[1] = 0x12; // TMR_SR_GEN2_CONFIGURATION_Q
+  sendMessage(TMR_SR_OPCODE_GET_PROTOCOL_PARAM, data, sizeof(data));
+  if (msg[0] != ALL_GOOD || msg[7] != profile.qType ||
+      (profile.qType == TMR_SR_GEN2_Q_STATIC && msg[8] != profile.qInit))
+    return (false);
+
+  // [enabled] [initial Q], only set for qInit 0 - 10
+  if (profile.qInit <= 10) {
+    data[1] = 0x16; // TMR_SR_GEN2_INITIAL_Q
+    sendMessage(TMR_SR_OPCODE_GET_PROTOCOL_PARAM, data, sizeof(data));
+    if (msg[0] != ALL_GOOD || msg[7] != 0x01 || msg[8] != profile.qInit)
+      return (false);
+  }
+
+  if (profile.rfMode != TMR_GEN2_RFMODE_INVALID) {
+    data[1] = 0x18; // TMR_SR_GEN2_CONFIGURATION_RFMODE
+    sendMessage(TMR_SR_OPCODE_GET_PROTOCOL_PARAM, data, sizeof(data));
+    if (msg[0] != ALL_GOOD || (((uint16_t)msg[7] << 8) | msg[8]) != profile.rfMode)
+      return (false);
   }
+
+  return (true);
+}
+
 #ifdef ARDUINO_ARCH_ESP32
-  else
-    delay(ESP32_DELAY);
+static bool sameProfile(const ReaderProfile &a, const ReaderProfile &b) {
+  return (a.region == b.region && a.readPower == b.readPower &&
+          a.session == b.session && a.target == b.target &&
+          a.qType == b.qType && a.qInit == b.qInit && a.rfMode == b.rfMode);
+}
+
+bool RFID::loadProfile(ReaderProfile &profile) {
+  Preferences prefs;
+  bool found = false;
+
+  if (prefs.begin(RFID_PREFS, true)) {
+    if (prefs.getBytesLength(RFID_PROFILE_PREFS_KEY) == sizeof(ReaderProfile))
+      found = prefs.getBytes(RFID_PROFILE_PREFS_KEY, &profile, sizeof(ReaderProfile)) == sizeof(ReaderProfile);
+    prefs.end();
+  }
+  return (found);
+}
+
+bool RFID::saveProfile(const ReaderProfile &profile) {
+  Preferences prefs;
+  ReaderProfile saved;
+  bool done = false;
+
+  // NVS is flash: only write when it changed
+  if (loadProfile(saved) && sameProfile(saved, profile))
+    return (true);
+
+  if (prefs.begin(RFID_PREFS, false)) {
+    done = prefs.putBytes(RFID_PROFILE_PREFS_KEY, &profile, sizeof(ReaderProfile)) == sizeof(ReaderProfile);
+    prefs.end();
+  }
+  return (done);
+}
+
+uint8_t RFID::warmStart(const ReaderProfile &profile, bool &warm,
+                        RFIDCommandCallback callback, void *ctx) {
+  ReaderProfile saved;
+
+  warm = loadProfile(saved) && sameProfile(saved, profile) && profileMatches(profile);
+
+  if (warm) {
+    // the module has it all: only let the config cache know what was read
+    // back, so setting one of these values again later is skipped as well.
+    // Protocol and antennas stay unknown, their next set is sent
+    _seeding = true;
+    _checkedCommands(profile);
+    _seeding = false;
+    return (0);
+  }
+
+  uint8_t failed = applyProfile(profile, callback, ctx);
+  if (failed == 0)
+    saveProfile(profile);
+
+  return (failed);
+}
 #endif
 
-  // Check CRC
-  crc = calculateCRC(&msg[1],
-                     messageLength - 3); // Remove header, remove 2 crc bytes
-  if ((msg[messageLength - 2] != (crc >> 8)) ||
-      (msg[messageLength - 1] != (crc & 0xFF))) {
-    msg[0] = ERROR_CORRUPT_RESPONSE;
-    if (_printDebug == true)
-      _debugSerial->println(F("Corrupt response"));
-    return;
+// Deterministic deadline for the response to an opcode
+// Configuration and query commands are answered within a few ms, so there
+// is no point in waiting the full COMMAND_TIME_OUT when the module is
+// silent (wrong baud, powered down). Tag operations first run RF for up to
+// the timeout the caller put in the command, then answer.
+uint16_t RFID::responseTimeout(uint8_t opcode, uint16_t timeOut) {
+  switch (opcode) {
+  case TMR_SR_OPCODE_READ_TAG_ID_SINGLE:
+  case TMR_SR_OPCODE_READ_TAG_ID_MULTIPLE:
+  case TMR_SR_OPCODE_WRITE_TAG_ID:
+  case TMR_SR_OPCODE_WRITE_TAG_DATA:
+  case TMR_SR_OPCODE_KILL_TAG:
+  case TMR_SR_OPCODE_READ_TAG_DATA:
+  case TMR_SR_OPCODE_MULTI_PROTOCOL_TAG_OP:
+    return (timeOut + TAGOP_RESPONSE_MARGIN);
+
+  default:
+    return (CONFIG_RESPONSE_TIME_OUT);
   }
+}
 
-  // If crc is ok, check that opcode matches (did we get a response to the
-  // command we sent or a different one?)
-  if (msg[2] != opcode) {
-    msg[0] = ERROR_WRONG_OPCODE_RESPONSE;
-    if (_printDebug == true) {
-      _debugSerial->print("Wrong opcode response expected ");
-      _debugSerial->print(opcode, HEX);
-      _debugSerial->print(" got ");
-      _debugSerial->println(msg[2], HEX);
-    }
+// Sleep until the UART has something new for us, at most maxWait ms
+// Without an RX event (generic Stream) fall back to a 1 ms poll.
+void RFID::_waitForRx(uint32_t maxWait) {
+#ifdef ARDUINO_ARCH_ESP32
+  if (_rxSignal != NULL) {
+    TickType_t ticks = pdMS_TO_TICKS(maxWait);
+    xSemaphoreTake(_rxSignal, ticks > 0 ? ticks : 1);
     return;
   }
-
-  // If everything is ok, load all ok into msg array
-  msg[0] = ALL_GOOD;
+#else
+  (void)maxWait;
+#endif
+  delay(1);
 }
 
 // Print the current message array - good for debugging, looking at how the
@@ -2027,19 +3327,57 @@ void RFID::printMessageArray(void) {
 // Comes from serial_reader_l3.c
 // ThingMagic-mutated CRC used for messages.
 // Notably, not a CCITT CRC-16, though it looks close.
-static uint16_t crctable[] = {
+// The original works a nibble at a time with a 16-entry table: the 0x1021
+// polynomial without augmentation, message bits shifted in at the bottom.
+// The same CRC done a byte at a time needs the 256-entry table of that
+// polynomial (entry i = the two nibble steps from crc = i << 8 over 0x00)
+// and costs one lookup per byte. Kept in DRAM so a lookup never waits for
+// the flash cache while the UART is streaming.
+#ifndef DRAM_ATTR
+#define DRAM_ATTR
+#endif
+
+static const uint16_t DRAM_ATTR crctable[256] = {
     0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
     0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef,
+    0x1231, 0x0210, 0x3273, 0x2252, 0x52b5, 0x4294, 0x72f7, 0x62d6,
+    0x9339, 0x8318, 0xb37b, 0xa35a, 0xd3bd, 0xc39c, 0xf3ff, 0xe3de,
+    0x2462, 0x3443, 0x0420, 0x1401, 0x64e6, 0x74c7, 0x44a4, 0x5485,
+    0xa56a, 0xb54b, 0x8528, 0x9509, 0xe5ee, 0xf5cf, 0xc5ac, 0xd58d,
+    0x3653, 0x2672, 0x1611, 0x0630, 0x76d7, 0x66f6, 0x5695, 0x46b4,
+    0xb75b, 0xa77a, 0x9719, 0x8738, 0xf7df, 0xe7fe, 0xd79d, 0xc7bc,
+    0x48c4, 0x58e5, 0x6886, 0x78a7, 0x0840, 0x1861, 0x2802, 0x3823,
+    0xc9cc, 0xd9ed, 0xe98e, 0xf9af, 0x8948, 0x9969, 0xa90a, 0xb92b,
+    0x5af5, 0x4ad4, 0x7ab7, 0x6a96, 0x1a71, 0x0a50, 0x3a33, 0x2a12,
+    0xdbfd, 0xcbdc, 0xfbbf, 0xeb9e, 0x9b79, 0x8b58, 0xbb3b, 0xab1a,
+    0x6ca6, 0x7c87, 0x4ce4, 0x5cc5, 0x2c22, 0x3c03, 0x0c60, 0x1c41,
+    0xedae, 0xfd8f, 0xcdec, 0xddcd, 0xad2a, 0xbd0b, 0x8d68, 0x9d49,
+    0x7e97, 0x6eb6, 0x5ed5, 0x4ef4, 0x3e13, 0x2e32, 0x1e51, 0x0e70,
+    0xff9f, 0xefbe, 0xdfdd, 0xcffc, 0xbf1b, 0xaf3a, 0x9f59, 0x8f78,
+    0x9188, 0x81a9, 0xb1ca, 0xa1eb, 0xd10c, 0xc12d, 0xf14e, 0xe16f,
+    0x1080, 0x00a1, 0x30c2, 0x20e3, 0x5004, 0x4025, 0x7046, 0x6067,
+    0x83b9, 0x9398, 0xa3fb, 0xb3da, 0xc33d, 0xd31c, 0xe37f, 0xf35e,
+    0x02b1, 0x1290, 0x22f3, 0x32d2, 0x4235, 0x5214, 0x6277, 0x7256,
+    0xb5ea, 0xa5cb, 0x95a8, 0x8589, 0xf56e, 0xe54f, 0xd52c, 0xc50d,
+    0x34e2, 0x24c3, 0x14a0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+    0xa7db, 0xb7fa, 0x8799, 0x97b8, 0xe75f, 0xf77e, 0xc71d, 0xd73c,
+    0x26d3, 0x36f2, 0x0691, 0x16b0, 0x6657, 0x7676, 0x4615, 0x5634,
+    0xd94c, 0xc96d, 0xf90e, 0xe92f, 0x99c8, 0x89e9, 0xb98a, 0xa9ab,
+    0x5844, 0x4865, 0x7806, 0x6827, 0x18c0, 0x08e1, 0x3882, 0x28a3,
+    0xcb7d, 0xdb5c, 0xeb3f, 0xfb1e, 0x8bf9, 0x9bd8, 0xabbb, 0xbb9a,
+    0x4a75, 0x5a54, 0x6a37, 0x7a16, 0x0af1, 0x1ad0, 0x2ab3, 0x3a92,
+    0xfd2e, 0xed0f, 0xdd6c, 0xcd4d, 0xbdaa, 0xad8b, 0x9de8, 0x8dc9,
+    0x7c26, 0x6c07, 0x5c64, 0x4c45, 0x3ca2, 0x2c83, 0x1ce0, 0x0cc1,
+    0xef1f, 0xff3e, 0xcf5d, 0xdf7c, 0xaf9b, 0xbfba, 0x8fd9, 0x9ff8,
+    0x6e17, 0x7e36, 0x4e55, 0x5e74, 0x2e93, 0x3eb2, 0x0ed1, 0x1ef0,
 };
 
 // Calculates the magical CRC value
 uint16_t RFID::calculateCRC(uint8_t *u8Buf, uint8_t len) {
   uint16_t crc = 0xFFFF;
 
-  for (uint8_t i = 0; i < len; i++) {
-    crc = ((crc << 4) | (u8Buf[i] >> 4)) ^ crctable[crc >> 12];
-    crc = ((crc << 4) | (u8Buf[i] & 0x0F)) ^ crctable[crc >> 12];
-  }
+  for (uint8_t i = 0; i < len; i++)
+    crc = ((crc << 8) | u8Buf[i]) ^ crctable[crc >> 8];
 
   return crc;
 }
@@ -2218,3 +3556,153 @@ uint8_t RFID::getGPIODirection(uint8_t gpio, bool *out) {
 }
 /** Maintained for backward compatibility ****************************/
 /** end section GPIO control *****************************************/
+
+#ifdef ARDUINO_ARCH_ESP32
+/*********************************************************************
+ * Background reading (ESP32 only)
+ *
+ * The reader task sleeps on a task notification while idle. Once the
+ * sketch has started continuous reading it sets _bgStreaming and wakes
+ * the task, which then owns the UART until _bgStreaming is cleared and
+ * it reports back through _bgIdle. A command from the sketch pauses it
+ * the same way for the length of the exchange, see _pauseStreaming().
+ *********************************************************************/
+
+bool RFID::startBackgroundReading(BaseType_t core, UBaseType_t priority) {
+  ContinuousReadConfig config;
+  return (startBackgroundReading(config, core, priority));
+}
+
+bool RFID::startBackgroundReading(const ContinuousReadConfig &config,
+                                  BaseType_t core, UBaseType_t priority) {
+  if (_readerTaskHandle == NULL) {
+    if (xTaskCreatePinnedToCore(_readerTask, "rfidReader", READER_TASK_STACK,
+                                this, priority, &_readerTaskHandle,
+                                core) != pdPASS) {
+      _readerTaskHandle = NULL;
+      return (false);
+    }
+  }
+
+  _streamQueue.clear();
+  _streamDropped = 0;
+  _bgResume = false;
+
+  // the task is idle, so the UART is still ours to send the start command
+  startReading(config);
+
+  _bgIdle = false;
+  _bgStreaming = true;
+  xTaskNotifyGive(_readerTaskHandle);
+
+  return (true);
+}
+
+bool RFID::stopBackgroundReading(void) {
+  _bgStreaming = false;
+  _bgResume = false;
+
+  // wait for the task to finish the record it is on and let go of the UART
+  while (!_bgIdle)
+    vTaskDelay(1);
+
+  sendFrame(StopReadingFrame::bytes);
+  bool stopped = (msg[0] == ALL_GOOD);
+
+  // the records that came in before the ack were held, still in continuous
+  // mode check() hands them out (and filters them) like the task would
+  while (_holdHead != _holdTail && check())
+    _queueRecord(parseResponse());
+
+  _continuousModeTemp = false;
+  _holdHead = _holdTail = 0;
+
+  return (stopped);
+}
+
+// The sketch is back for records, so done with the last command's msg:
+// a task paused for it takes the UART again
+bool RFID::readStreamedTag(StreamedTag &tag) {
+  if (_bgResume) {
+    _bgResume = false;
+    _resumeStreaming();
+  }
+  return (_streamQueue.pop(tag));
+}
+
+// A command from the sketch while the task owns the UART. The task lets go
+// after its current record and the command runs on the caller's core. The
+// task resumes with the records held meanwhile once the sketch has read
+// the response (readStreamedTag())
+bool RFID::_pauseStreaming(void) {
+  if (!_bgStreaming || xTaskGetCurrentTaskHandle() == _readerTaskHandle)
+    return (false);
+
+  _bgStreaming = false;
+  while (!_bgIdle)
+    vTaskDelay(1);
+
+  return (true);
+}
+
+void RFID::_resumeStreaming(void) {
+  _bgIdle = false;
+  _bgStreaming = true;
+  xTaskNotifyGive(_readerTaskHandle);
+}
+
+void RFID::_readerTask(void *param) {
+  RFID *self = (RFID *)param;
+
+  while (true) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    self->_streamRecords();
+    self->_bgIdle = true;
+  }
+}
+
+// Decode records until the sketch asks for the UART back
+void RFID::_streamRecords(void) {
+  while (_bgStreaming) {
+    if (!check()) {
+      _waitForRx(5); // sleeps on the UART event, or a short poll
+      continue;
+    }
+
+    _queueRecord(parseResponse());
+  }
+}
+
+// The record parseResponse() just cracked into _streamQueue, if it is one
+void RFID::_queueRecord(uint8_t type) {
+  if (type != RESPONSE_IS_TAGFOUND && type != RESPONSE_IS_KEEPALIVE &&
+      type != RESPONSE_IS_TEMPTHROTTLE)
+    return;
+
+  StreamedTag tag;
+  memset(&tag, 0, sizeof(tag));
+  tag.ms = millis();
+  tag.type = type;
+
+  if (type == RESPONSE_IS_TAGFOUND) {
+    uint8_t epcBytes = _tag.epcLen;
+
+    tag.rssi = _tag.rssi;
+    tag.antenna = _tag.antenna;
+    tag.freq = _tag.freq;
+    tag.phase = _tag.phase;
+    tag.epcLen = epcBytes;
+    if (epcBytes > STREAMED_EPC_BYTES)
+      epcBytes = STREAMED_EPC_BYTES;
+    memcpy(tag.epc, _tag.epc, epcBytes);
+
+    tag.dataLen = _tag.dataLen;
+    for (uint8_t x = 0; x < _tag.dataLen && x < STREAMED_DATA_BYTES; x++)
+      tag.data = tag.data << 8 | _tag.data[x];
+  }
+
+  if (!_streamQueue.push(tag))
+    _streamDropped++;
+}
+#endif
@@ -15,11 +15,38 @@
   substantial portions of the Software.
 */
 
+#ifndef SPARKFUN_UHF_RFID_READER_H
+#define SPARKFUN_UHF_RFID_READER_H
+
 #include "Arduino.h" //Needed for Stream
 
+#ifdef ARDUINO_ARCH_ESP32
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+#include <atomic>
+#include "SpscQueue.h"
+#endif
+
 // maximum receive buffer
 #define MAX_MSG_SIZE 255
 
+// largest command payload (header, length, opcode and CRC around it)
+#define TAG_WRITE_DATA_MAX (MAX_MSG_SIZE - 5)
+
+// raw UART receive ring used by the streaming parser in check().
+// Must be a power of 2. Holds several complete tag records so a burst of
+// reads is never lost while the sketch is busy elsewhere.
+#define RX_RING_SIZE 1024
+
+// streamed records that come in while a command waits for its response
+// during a continuous read. They are held here (back to back, power of 2)
+// and handed out by check() before anything newer
+#define RX_HOLD_SIZE 1024
+
+// logical antenna ports in one setAntennaSearchList()
+#define RFID_ANTENNA_LIST_MAX 8
+
 // opcodes
 #define TMR_SR_OPCODE_VERSION               0x03
 #define TMR_SR_OPCODE_SET_BAUD_RATE         0x06
@@ -34,6 +61,7 @@
 #define TMR_SR_OPCODE_MULTI_PROTOCOL_TAG_OP 0x2F
 #define TMR_SR_OPCODE_GET_READ_TX_POWER     0x62
 #define TMR_SR_OPCODE_GET_WRITE_TX_POWER    0x64
+#define TMR_SR_OPCODE_GET_REGION            0x67
 #define TMR_SR_OPCODE_GET_POWER_MODE        0x68
 #define TMR_SR_OPCODE_GET_READER_OPTIONAL_PARAMS 0x6A
 #define TMR_SR_OPCODE_GET_TEMPERATURE       0x72           // special add / May 2020
@@ -42,6 +70,7 @@
 #define TMR_SR_OPCODE_SET_TAG_PROTOCOL      0x93
 #define TMR_SR_OPCODE_SET_READ_TX_POWER     0x92
 #define TMR_SR_OPCODE_SET_WRITE_TX_POWER    0x94
+#define TMR_SR_OPCODE_SET_FREQ_HOP_TABLE    0x95
 #define TMR_SR_OPCODE_SET_REGION            0x97
 #define TMR_SR_OPCODE_SET_POWER_MODE        0x98           // special add / February 2020
 #define TMR_SR_OPCODE_SET_READER_OPTIONAL_PARAMS 0x9A
@@ -49,6 +78,10 @@
 
 #define COMMAND_TIME_OUT  2000 //Number of ms before stop waiting for response from module
 
+// Response deadlines used by sendCommand(), see responseTimeout()
+#define CONFIG_RESPONSE_TIME_OUT  500 // configuration / query opcodes, module answers in a few ms
+#define TAGOP_RESPONSE_MARGIN     500 // added to the caller's timeout for opcodes that run RF first
+
 /** Gen2 session values */
 typedef enum TMR_GEN2_Session
 {
@@ -128,6 +161,101 @@ typedef enum TMR_SR_GEN2_QType
   TMR_SR_GEN2_Q_INVALID = TMR_SR_GEN2_Q_STATIC + 1,
 } TMR_SR_GEN2_QType;
 
+/**
+ * Command frames that never change, built at compile time
+ *
+ * FF LEN OPCODE DATA.. CRCHI CRCLO with the CRC worked out by the compiler,
+ * so the frame sits in flash ready to go and sendFrame() puts it on the
+ * wire with one write(). Used for the fixed commands (stop, version, read
+ * filter, the default startReading() blob, ...):
+ *
+ *   typedef RFIDFrame<TMR_SR_OPCODE_MULTI_PROTOCOL_TAG_OP, 0x00, 0x00, 0x02> StopFrame;
+ *   rfid.sendFrame(StopFrame::bytes);
+ *
+ * rfidFrameCRC() is calculateCRC() with the table lookup spelled out as
+ * the 8 polynomial steps it stands for.
+ */
+constexpr uint16_t rfidCrcTable(uint16_t v, uint8_t bits) {
+  return (bits == 0 ? v : rfidCrcTable((uint16_t)((v & 0x8000) ? (v << 1) ^ 0x1021 : v << 1), bits - 1));
+}
+
+constexpr uint16_t rfidCrcByte(uint16_t crc, uint8_t b) {
+  return ((uint16_t)(((crc << 8) | b) ^ rfidCrcTable(crc & 0xFF00, 8)));
+}
+
+constexpr uint16_t rfidFrameCRC(uint16_t crc) { return (crc); }
+
+template <typename... Bytes>
+constexpr uint16_t rfidFrameCRC(uint16_t crc, uint8_t b, Bytes... rest) {
+  return (rfidFrameCRC(rfidCrcByte(crc, b), rest...));
+}
+
+template <uint8_t OPCODE, uint8_t... DATA>
+struct RFIDFrame
+{
+  static constexpr uint8_t LEN = sizeof...(DATA);
+  static constexpr uint16_t CRC = rfidFrameCRC(0xFFFF, LEN, OPCODE, DATA...);
+  static constexpr uint8_t bytes[LEN + 5] = {0xFF, LEN, OPCODE, DATA..., (uint8_t)(CRC >> 8), (uint8_t)(CRC & 0xFF)};
+};
+
+template <uint8_t OPCODE, uint8_t... DATA>
+constexpr uint8_t RFIDFrame<OPCODE, DATA...>::bytes[];
+
+/**
+ * Asynchronous command queue, see queueCommand()
+ *
+ * result is ALL_GOOD, ERROR_COMMAND_RESPONSE_TIMEOUT or
+ * ERROR_WRONG_OPCODE_RESPONSE, status the module's status word (0 = ok).
+ * While the callback runs, msg holds the response frame.
+ */
+typedef void (*RFIDCommandCallback)(uint8_t opcode, uint8_t result, uint16_t status, void *ctx);
+
+#define CMD_QUEUE_SIZE      16   // commands waiting or in flight (power of 2)
+#define CMD_QUEUE_DATA_MAX  48   // largest payload a queued command can carry (a selected tag write)
+#define CMD_WINDOW_DEFAULT  1    // commands on the wire before the oldest is answered
+#define CMD_WINDOW_MAX      4
+
+typedef struct QueuedCommand
+{
+  RFIDCommandCallback callback;
+  void *ctx;
+  uint32_t sentMs;       // millis() when sent, or when the one before it completed
+  uint16_t timeOut;      // as passed to sendMessage(), see responseTimeout()
+  uint8_t opcode;
+  uint8_t size;
+  uint8_t data[CMD_QUEUE_DATA_MAX];
+} QueuedCommand;
+
+/**
+ * Module settings applied as one batch by applyProfile()
+ */
+typedef struct ReaderProfile
+{
+  uint8_t region;             // REGION_xxx
+  int16_t readPower;          // 1500 = 15.00 dBm
+  TMR_GEN2_Session session;
+  TMR_GEN2_Target target;
+  TMR_SR_GEN2_QType qType;
+  uint8_t qInit;              // initial Q, > 10 = keep the module's
+  TMR_GEN2_RFMode rfMode;     // TMR_GEN2_RFMODE_INVALID = keep the module's (M6E)
+} ReaderProfile;
+
+/**
+ * Shadow copy of the settings written to the module, see useConfigCache()
+ * One entry per setting: opcode plus the key byte that tells settings
+ * sharing an opcode apart (protocol parameter, optional parameter, ...)
+ */
+#define CONFIG_CACHE_SIZE   16   // settings remembered
+#define CONFIG_CACHE_DATA   6    // largest setting payload remembered
+
+typedef struct ConfigCacheEntry
+{
+  uint8_t opcode;        // 0 = free
+  uint8_t key;
+  uint8_t size;
+  uint8_t data[CONFIG_CACHE_DATA];
+} ConfigCacheEntry;
+
 //Define all the ways functions can return
 #define ALL_GOOD                        0
 #define ERROR_COMMAND_RESPONSE_TIMEOUT  1
@@ -196,6 +324,32 @@ typedef enum
 /** Used to enable the read of additional membanks - user mem bank */
 #define  TMR_GEN2_BANK_USER_ENABLED  0x20
 
+/**
+ * One tag of a provisioning batch, see provisionTags()
+ */
+#define PROVISION_ID_BYTES      12   // EPC / TID bytes a tag is selected by
+#define PROVISION_DATA_MAX      16   // bytes written per tag (8 words)
+#define PROVISION_TAG_TIME_OUT  500  // ms the module tries each write / read
+
+/** ProvisionTag.result */
+#define PROVISION_OK            0
+#define PROVISION_WRITE_FAILED  1    // write refused, status has the module's reason
+#define PROVISION_READ_FAILED   2    // read back refused, status has the module's reason
+#define PROVISION_MISMATCH      3    // read back differs from what was written
+#define PROVISION_TIMEOUT       4    // no response from the module
+#define PROVISION_PENDING       0xFF
+
+typedef struct ProvisionTag
+{
+  uint8_t idBank;                    // TMR_GEN2_BANK_EPC or TMR_GEN2_BANK_TID
+  uint8_t idLen;                     // bytes of id to select on
+  uint8_t id[PROVISION_ID_BYTES];    // EPC (without PC) or TID, from the start of it
+  uint8_t dataLen;                   // bytes to write, even
+  uint8_t data[PROVISION_DATA_MAX];
+  uint8_t result;                    // PROVISION_xxx
+  uint16_t status;                   // module status of the step that failed
+} ProvisionTag;
+
 // need for Selecting the right EPC to read (December 2022)
 // SelectiveReadDataRegion()
 typedef struct SelectEPC {
@@ -218,13 +372,6 @@ typedef struct TMR_uint8List  // special add / August 2020
 
 #define TMR_MAX_EPC_BYTE_COUNT (32)  // special add / August 2020
 
-/* For reasons unknown to me, the ESP32 needs a delay else the communication will fail.
- * Setting a delay of 1 is already doing the trick. Yield() did not help.
- * Paulvha / May 2021 - version 2.2 */
-#ifdef ARDUINO_ARCH_ESP32
-#define ESP32_DELAY 2
-#endif
-
 /**
  * A subset of the TagReadData as defined in tmr_tag_data.h
  *
@@ -271,6 +418,357 @@ typedef struct TMR_TagReadData      // special add / August 2020
 } TMR_TagReadData;
 
 
+/** Metadata flags (TMR_TRD_MetadataFlag in tmr_tag_data.h)
+ * Select which fields the module puts in each tag record. The fields
+ * appear in the record in the order of these bits. */
+#define TMR_TRD_METADATA_FLAG_NONE             0x0000
+#define TMR_TRD_METADATA_FLAG_READCOUNT        0x0001  // 1 byte
+#define TMR_TRD_METADATA_FLAG_RSSI             0x0002  // 1 byte, signed dBm
+#define TMR_TRD_METADATA_FLAG_ANTENNAID        0x0004  // 1 byte, 4MSB = TX, 4LSB = RX
+#define TMR_TRD_METADATA_FLAG_FREQUENCY        0x0008  // 3 bytes, kHz
+#define TMR_TRD_METADATA_FLAG_TIMESTAMP        0x0010  // 4 bytes, ms
+#define TMR_TRD_METADATA_FLAG_PHASE            0x0020  // 2 bytes
+#define TMR_TRD_METADATA_FLAG_PROTOCOL         0x0040  // 1 byte
+#define TMR_TRD_METADATA_FLAG_DATA             0x0080  // 2 bytes length in bits + data
+#define TMR_TRD_METADATA_FLAG_GPIO_STATUS      0x0100  // 1 byte
+#define TMR_TRD_METADATA_FLAG_GEN2_Q           0x0200  // 1 byte
+#define TMR_TRD_METADATA_FLAG_GEN2_LF          0x0400  // 1 byte
+#define TMR_TRD_METADATA_FLAG_GEN2_TARGET      0x0800  // 1 byte
+#define TMR_TRD_METADATA_FLAG_BRAND_IDENTIFIER 0x1000  // 2 bytes
+#define TMR_TRD_METADATA_FLAG_ALL_KNOWN        0x1FFF  // the ones decodeTagRecord() understands
+
+/**
+ * One decoded tag record
+ *
+ * Filled by parseResponse() in a single pass over the frame. epc and
+ * data point into the receive buffer (msg) and are only valid until the
+ * next check() or command. Fields whose metadata flag was not requested
+ * are zero.
+ */
+typedef struct TagRecord
+{
+  /** The EPC tag that was read (without PC and EPC CRC) */
+  const uint8_t *epc;
+
+  /** EPC length in bytes */
+  uint8_t epcLen;
+
+  /** Gen2 protocol control word */
+  uint16_t pc;
+
+  /** Embedded read data (embeddedRead(), startReadingBank()), NULL if none */
+  const uint8_t *data;
+
+  /** Embedded data length in bytes */
+  uint8_t dataLen;
+
+  /** TMR_TRD_METADATA_FLAG_xxx that were present in this record */
+  uint16_t metadata;
+
+  /** Number of times the tag was read in this record */
+  uint8_t readCount;
+
+  /** Strength of the signal received from the tag */
+  int8_t rssi;
+
+  /** antenna ID (4MSB = TX, 4LSB = RX) */
+  uint8_t antenna;
+
+  /** RF carrier frequency in kHz */
+  uint32_t freq;
+
+  /** ms since last keep alive msg */
+  uint32_t timestamp;
+
+  /** phase the tag was read at */
+  int16_t phase;
+
+  /** protocol ID (0x05 = GEN2) */
+  uint8_t protocol;
+} TagRecord;
+
+/**
+ * Reading several banks of every tag in one pass, see readBanks()
+ *
+ * banks is a bitmask of BANK_READ_xxx, each bank has its own word range.
+ * The module takes a single window for all banks of an embedded read, so
+ * the read asks for the smallest window covering every range and
+ * splitBanks() cuts each bank's range out of the record. A bank shorter
+ * than the window fails the read on that tag: keep the ranges of banks of
+ * very different sizes (a 6 word TID, 32 words of user memory) apart.
+ */
+#define BANK_READ_RESERVED  (1 << TMR_GEN2_BANK_RESERVED)
+#define BANK_READ_EPC       (1 << TMR_GEN2_BANK_EPC)
+#define BANK_READ_TID       (1 << TMR_GEN2_BANK_TID)
+#define BANK_READ_USER      (1 << TMR_GEN2_BANK_USER)
+#define BANK_READ_BANKS     4
+#define BANK_READ_DATA_MAX  192   // bank data that fits a record next to EPC and metadata
+
+typedef struct BankReadRequest
+{
+  uint8_t banks;                          // BANK_READ_xxx
+  uint8_t wordAddress[BANK_READ_BANKS];   // indexed by TMR_GEN2_BANK_xxx
+  uint8_t wordCount[BANK_READ_BANKS];     // at most CONT_READ_EMBEDDED_WORDS
+} BankReadRequest;
+
+/** The requested ranges of one record, pointing into msg like TagRecord */
+typedef struct BankData
+{
+  const uint8_t *data[BANK_READ_BANKS];   // indexed by TMR_GEN2_BANK_xxx, NULL if not read
+  uint8_t len[BANK_READ_BANKS];           // bytes
+} BankData;
+
+// called per tag record, return false to end readBanks()
+typedef bool (*BankReadCallback)(const TagRecord &rec, const BankData &banks, void *ctx);
+
+/** Search flags of the read multiple (0x22) sub-command */
+#define TMR_SR_SEARCH_FLAG_CONFIGURED_LIST        0x0003  // use the antenna search list
+#define TMR_SR_SEARCH_FLAG_EMBEDDED_COMMAND       0x0004  // embedded tag operation follows
+#define TMR_SR_SEARCH_FLAG_TAG_STREAMING          0x0008  // send records as they are read
+#define TMR_SR_SEARCH_FLAG_LARGE_TAG_POPULATION   0x0010
+#define TMR_SR_SEARCH_FLAG_STATS_REPORT_STREAMING 0x0100  // stats flags follow
+#define TMR_SR_SEARCH_FLAG_DUTY_CYCLE_CONTROL     0x0400  // off time follows the on time
+
+/** Stats flags for TMR_SR_SEARCH_FLAG_STATS_REPORT_STREAMING */
+#define TMR_SR_STATS_FLAG_TEMPERATURE             0x0100
+
+/** Singulation option byte of the read multiple (0x22) sub-command and tag operations */
+#define TMR_SR_GEN2_SINGULATION_OPTION_SELECT_ON_TID        0x02  // Select masks per bank
+#define TMR_SR_GEN2_SINGULATION_OPTION_SELECT_ON_USER_MEM   0x03
+#define TMR_SR_GEN2_SINGULATION_OPTION_SELECT_ON_ADDRESSED_EPC 0x04
+#define TMR_SR_GEN2_SINGULATION_OPTION_INVERSE_SELECT_BIT   0x08  // select the tags that do NOT match
+#define TMR_SR_GEN2_SINGULATION_OPTION_FLAG_METADATA        0x10
+#define TMR_SR_GEN2_SINGULATION_OPTION_EXTENDED_DATA_LENGTH 0x20  // 16-bit mask length
+
+/** Module status of a tag operation */
+#define TMR_SR_STATUS_NO_TAGS_FOUND          0x0400  // no (selected) tag answered
+#define TMR_SR_STATUS_GEN2_MEMORY_OVERRUN    0x0423  // address / length past the end of the bank
+
+#define CONT_READ_BLOB_MAX 128 // largest configBlob ContinuousReadConfig builds
+#define CONT_READ_SELECT_BYTES 32 // longest Gen2 Select mask
+#define CONT_READ_EMBEDDED_WORDS 32 // most words an embedded read returns
+#define GEN2_EPC_BIT_POINTER   32 // EPC bank: the EPC follows StoredCRC and PC (2 words)
+
+/**
+ * Builder for the continuous read configBlob sent by startReading()
+ *
+ * The defaults reproduce the blob startReading() always sent: all metadata,
+ * 1000 ms on-time, no off-time and temperature statistics. Every record
+ * carries ~47 bytes then; asking for EPC + RSSI only brings that down to
+ * ~25 bytes, so more reads fit through the UART:
+ *
+ *   ContinuousReadConfig cfg;
+ *   cfg.metadata(TMR_TRD_METADATA_FLAG_RSSI).onTime(250).temperatureStats(false);
+ *   rfidModule.startReading(cfg);
+ *
+ * decodeTagRecord() follows the metadata flags in each record, so fields
+ * that were not requested simply read back as 0.
+ *
+ * select() adds a Gen2 Select to every inventory round: only tags whose
+ * bank bits at bitPointer match the mask take part (or, inverted, only the
+ * ones that don't). Other tags stay silent, so they use no slots and no
+ * UART; a shared EPC prefix is the usual mask:
+ *
+ *   static const uint8_t PREFIX[] = {0xE2, 0x80, 0x68, 0x94, 0x00, 0x00};
+ *   cfg.selectEpcPrefix(PREFIX, sizeof(PREFIX));
+ *
+ * The module takes a single Select per read.
+ *
+ * embeddedRead() reads a few words of every tag as it is inventoried and
+ * returns them in the record (TMR_TRD_METADATA_FLAG_DATA is added to the
+ * metadata). One user memory word holding a puck ID is enough to tell the
+ * pucks apart by an integer instead of the EPC:
+ *
+ *   cfg.metadata(TMR_TRD_METADATA_FLAG_RSSI).embeddedRead(TMR_GEN2_BANK_USER, 0, 1);
+ *
+ * embeddedReadBanks() reads several banks at once (see BankReadRequest),
+ * RFID::splitBanks() takes the record's data apart again.
+ */
+class ContinuousReadConfig
+{
+  public:
+    ContinuousReadConfig(void);
+
+    // TMR_TRD_METADATA_FLAG_xxx to add to each tag record
+    ContinuousReadConfig &metadata(uint16_t flags);
+
+    // search time per cycle, and RF off time between cycles (0 = none). ms
+    ContinuousReadConfig &onTime(uint16_t ms);
+    ContinuousReadConfig &offTime(uint16_t ms);
+
+    // temperature statistics records (see getTemp() in continuous mode)
+    ContinuousReadConfig &temperatureStats(bool enable);
+
+    // Gen2 Select on bitLen bits of bank (TMR_GEN2_BANK_xxx) from bitPointer,
+    // mask holds (bitLen + 7) / 8 bytes, MSB first. invert = select the tags
+    // that don't match. bitLen 0 or over CONT_READ_SELECT_BYTES * 8 removes it
+    ContinuousReadConfig &select(uint8_t bank, uint32_t bitPointer, const uint8_t *mask,
+                                 uint16_t bitLen, bool invert = false);
+
+    // Select on the first len bytes of the EPC
+    ContinuousReadConfig &selectEpcPrefix(const uint8_t *prefix, uint8_t len, bool invert = false);
+
+    ContinuousReadConfig &noSelect(void);
+
+    // Gen2 read of wordCount words from wordAddress of bank with every tag
+    // (0 = the whole bank, for the smaller EPC / TID / reserved banks).
+    // At most CONT_READ_EMBEDDED_WORDS
+    ContinuousReadConfig &embeddedRead(uint8_t bank, uint32_t wordAddress, uint8_t wordCount);
+
+    // embedded read of every bank in request, over the window covering all
+    // of their ranges. No banks removes the embedded read
+    ContinuousReadConfig &embeddedReadBanks(const BankReadRequest &request);
+    ContinuousReadConfig &noEmbeddedRead(void);
+
+    // access password sent with the Select (0 = none, the default)
+    ContinuousReadConfig &accessPassword(uint32_t password);
+
+    uint16_t metadata(void) const { return (_metadata); }
+    uint16_t onTime(void) const { return (_onTime); }
+    uint16_t offTime(void) const { return (_offTime); }
+    bool temperatureStats(void) const { return (_stats); }
+    bool hasSelect(void) const { return (_selectBits > 0); }
+    bool hasEmbeddedRead(void) const { return (_embedded); }
+
+    // Serialize into blob (without header, opcode and CRC)
+    // Returns the number of bytes, 0 if size is too small
+    uint8_t build(uint8_t *blob, uint8_t size) const;
+
+  private:
+    uint16_t _metadata;
+    uint16_t _onTime;
+    uint16_t _offTime;
+    bool _stats;
+
+    uint8_t _selectBank;
+    bool _selectInvert;
+    uint16_t _selectBits;     // 0 = no Select
+    uint32_t _selectPointer;
+    uint32_t _password;
+    uint8_t _selectMask[CONT_READ_SELECT_BYTES];
+
+    bool _embedded;
+    uint8_t _embeddedBank;
+    uint8_t _embeddedWords;
+    uint32_t _embeddedAddress;
+};
+
+#ifdef ARDUINO_ARCH_ESP32
+/**
+ * Baud rate negotiation (ESP32 only), see negotiateBaud()
+ */
+#define RFID_BAUD_MAX            921600
+#define RFID_BAUD_VERIFY         3        // getVersion() replies needed to accept a new rate
+#define RFID_BAUD_SETTLE_MS      5        // module switches after acknowledging setBaud()
+#define RFID_STOP_RETRIES        3        // stopReading() attempts on a module left mid-read
+#define RFID_PREFS               "rfid"   // Preferences (NVS) namespace
+#define RFID_BAUD_PREFS_KEY      "baud"
+#define RFID_PROFILE_PREFS_KEY   "profile" // see warmStart()
+
+/**
+ * Background reading (ESP32 only)
+ *
+ * Compact fixed-size copy of one streamed record, produced by the reader
+ * task and drained by the sketch with readStreamedTag(). Besides tag
+ * records, keep-alive and thermal throttle indications are passed on too
+ * (see type) so the consumer can see inventory rounds and module state.
+ */
+#define STREAMED_EPC_BYTES       12   // room for a 96-bit EPC, longer ones are truncated
+#define STREAMED_DATA_BYTES      4    // embedded read data kept per record, see data
+#define STREAMED_TAG_QUEUE_SIZE  64   // records buffered between the cores (power of 2)
+
+#define READER_TASK_CORE         0    // keep the UART away from the Arduino loop (core 1)
+#define READER_TASK_PRIORITY     5
+#define READER_TASK_STACK        4096
+
+typedef struct StreamedTag
+{
+  /** millis() when the record was decoded */
+  uint32_t ms;
+
+  /** RF carrier frequency in kHz */
+  uint32_t freq;
+
+  /** embedded read data as a big-endian number: one word read = the word.
+   *  Only the first STREAMED_DATA_BYTES if more was read */
+  uint32_t data;
+
+  /** phase the tag was read at */
+  int16_t phase;
+
+  /** Strength of the signal received from the tag */
+  int8_t rssi;
+
+  /** antenna ID (4MSB = TX, 4LSB = RX) */
+  uint8_t antenna;
+
+  /** RESPONSE_IS_TAGFOUND, RESPONSE_IS_KEEPALIVE or RESPONSE_IS_TEMPTHROTTLE */
+  uint8_t type;
+
+  /** EPC length as reported by the module, may be larger than STREAMED_EPC_BYTES */
+  uint8_t epcLen;
+
+  /** embedded read bytes in the record, may be larger than STREAMED_DATA_BYTES.
+   *  0 if none (no embedded read, or it failed on this tag) */
+  uint8_t dataLen;
+
+  /** The EPC tag that was read */
+  uint8_t epc[STREAMED_EPC_BYTES];
+} StreamedTag;
+#endif
+
+// Link statistics, see getStats()
+#define RFID_LATENCY_BUCKETS    8  // command round trip: <1, <2, <4 .. <64, >=64 ms
+#define RFID_STATS_UNIQUE_EPCS 16  // time to each of the first N unique EPCs
+
+typedef struct RFIDStats
+{
+  /** CRC-valid frames taken out of the receive ring */
+  uint32_t framesReceived;
+
+  /** complete frames at the expected position that failed the CRC */
+  uint32_t crcErrors;
+
+  /** times framing was lost and the parser had to hunt for a header */
+  uint32_t resyncs;
+
+  /** tag records that did not decode (ERROR_CORRUPT_RESPONSE) */
+  uint32_t corruptRecords;
+
+  /** streamed records that arrived while a command waited for its response,
+   *  and of those the ones lost because the hold ring was full */
+  uint32_t recordsHeld;
+  uint32_t recordsHeldDropped;
+
+  /** UART FIFO / buffer overflow events (ESP32 only), bytes were lost */
+  uint32_t uartOverflows;
+
+  /** parseResponse() results */
+  uint32_t tagReads;
+  uint32_t keepAlives;
+  uint32_t thermalThrottles;   // counted by check(), as the notice arrives
+
+  /** bytes pulled from the UART */
+  uint32_t bytesReceived;
+
+  /** throughput since the previous getStats() */
+  uint32_t bytesPerSec;
+  uint32_t readsPerSec;
+
+  /** command round trips, timeouts, and their latency histogram */
+  uint32_t commands;
+  uint32_t commandTimeouts;
+  uint32_t latency[RFID_LATENCY_BUCKETS];
+  uint32_t latencyMaxMs;
+
+  /** ms from startReading() to the first tag read, 0 = none yet */
+  uint32_t firstReadMs;
+
+  /** ms from startReading() to each new EPC, for the first uniqueEpcs of them */
+  uint8_t uniqueEpcs;
+  uint32_t uniqueMs[RFID_STATS_UNIQUE_EPCS];
+} RFIDStats;
+
 class RFID
 {
   public:
@@ -278,23 +776,67 @@ class RFID
 
     // change May 2024
     void begin(Stream &serialPort = Serial, ThingMagic_Module_t moduleType = ThingMagic_M6E_NANO); //If user doesn't specify then Serial will be used
+#ifdef ARDUINO_ARCH_ESP32
+    // Same as above, but also hooks the UART receive event so waiting for a
+    // response sleeps until bytes arrive instead of polling
+    void begin(HardwareSerial &serialPort, ThingMagic_Module_t moduleType = ThingMagic_M6E_NANO);
+#endif
 
     void enableDebugging(Stream &debugPort = Serial); //Turn on command sending and response printing. If user doesn't specify then Serial will be used
     void disableDebugging(void);
 
     void setBaud(long baudRate);
+
+    // Settings commands (region, power, protocol, antenna, Gen2 parameters,
+    // reader optional parameters, power mode) are remembered once the module
+    // accepted them. Sending the same value again is skipped and reported as
+    // ALL_GOOD right away. Call invalidateConfigCache() after anything that
+    // resets the module behind the library's back (power cycle, reboot)
+    void useConfigCache(bool enable);
+    void invalidateConfigCache(void);
+#ifdef ARDUINO_ARCH_ESP32
+    // Find the module's current baud rate, move the module and the UART in
+    // lockstep to the fastest supported rate up to maxBaud that answers
+    // getVersion() RFID_BAUD_VERIFY times in a row, falling back to lower
+    // rates otherwise. The result is saved in NVS and tried first on the
+    // next boot. Needs begin(HardwareSerial &). A read left running by a
+    // previous session is stopped. Returns the rate in use, 0 if the module
+    // did not answer at any rate.
+    long negotiateBaud(long maxBaud = RFID_BAUD_MAX, bool persist = true);
+
+    // Find the module's current baud rate (hint is tried first) and leave
+    // the UART at it. Returns 0 if the module did not answer
+    long probeBaud(long hint = 0);
+
+    // rate stored by negotiateBaud(), 0 if none
+    long savedBaud(void);
+#endif
     void getVersion(void);
     void setReadPower(int16_t powerSetting);
     void getReadPower();
     void setWritePower(int16_t powerSetting);
     void getWritePower();
     void setRegion(uint8_t region);
+    // time on each channel of the region's hop table, ms. Shorter makes a
+    // short read cover more channels (the region sets the maximum, 400 ms
+    // for NA). setRegion() restores the region's default
+    void setHopTime(uint32_t ms);
     void setAntennaPort();
+    void setAntennaPort(uint8_t txPort, uint8_t rxPort);
     void setAntennaSearchList();
+    // continuous / multi tag reads cycle through these ports (TX = RX),
+    // count at most RFID_ANTENNA_LIST_MAX
+    void setAntennaSearchList(const uint8_t *ports, uint8_t count);
     void setTagProtocol(uint8_t protocol = 0x05);
 
     void startReading(void); //Disable filtering and start reading continuously
-    void stopReading(void); //Stops continuous read. Give 1000 to 2000ms for the module to stop reading.
+    void startReading(const ContinuousReadConfig &config); //Same, with the metadata / timing / stats chosen in config
+    bool stopReading(void); //Stops continuous read. Returns true once the module acknowledged the stop.
+
+    // Always-on link counters. The snapshot is not taken atomically, a
+    // counter can be one event ahead of another while the reader task runs
+    void getStats(RFIDStats &stats);
+    void resetStats(void);
 
     void enableReadFilter(void);
     void disableReadFilter(void);
@@ -305,12 +847,21 @@ class RFID
     void getProtocolParameters(uint8_t option1, uint8_t option2);
     uint8_t parseResponse(void);
 
+    // The record decoded by the last parseResponse() that returned RESPONSE_IS_TAGFOUND
+    const TagRecord &getTagRecord(void) { return _tag; }
+
+    // Decode the tag record in frame (a complete 0x22 response) into rec
+    // Returns false if the record is truncated or uses unknown metadata
+    static bool decodeTagRecord(const uint8_t *frame, TagRecord &rec);
+
+    // Shortcuts into getTagRecord(), valid after parseResponse() == RESPONSE_IS_TAGFOUND
     uint8_t getTagEPCBytes(void);   //Pull number of EPC data bytes from record response.
     uint8_t getTagDataBytes(void);  //Pull number of tag data bytes from record response. Often zero.
     uint16_t getTagTimestamp(void); //Pull timestamp value from full record response
     uint32_t getTagFreq(void);      //Pull Freq value from full record response
     int8_t getTagRSSI(void);        // Pull RSSI value from full record response
     int16_t getTagPhase(void);      // pull the tag phasing ( 0 - 180)
+    uint8_t getTagAntenna(void);    // antenna the tag was read on (4MSB = TX, 4LSB = RX)
 
     bool check(void);
 
@@ -341,6 +892,12 @@ class RFID
     void sendMessage(uint8_t opcode, uint8_t *data = 0, uint8_t size = 0, uint16_t timeOut = COMMAND_TIME_OUT, boolean waitForResponse = true);
     void sendCommand(uint16_t timeOut = COMMAND_TIME_OUT, boolean waitForResponse = true);
 
+    // Same as sendMessage() for a complete frame (header, length, opcode,
+    // data and CRC), e.g. an RFIDFrame. Written out as it is, in one go
+    void sendFrame(const uint8_t *frame, uint16_t timeOut = COMMAND_TIME_OUT, boolean waitForResponse = true);
+
+    uint16_t responseTimeout(uint8_t opcode, uint16_t timeOut = COMMAND_TIME_OUT); // ms to wait for the answer to opcode
+
     void printMessageArray(void);
 
     uint16_t calculateCRC(uint8_t *u8Buf, uint8_t len);
@@ -402,6 +959,8 @@ class RFID
      *
      * @param read:
      *  pointer to store the memory bank data
+     *
+     * readBanks() reads only the banks and words asked for, from every tag
      */
     uint8_t ReadingAllBanks(TMR_TagReadData *read);
 
@@ -448,12 +1007,64 @@ class RFID
      * @return :
      *    ERROR_INVALID_EPC_REQ         : invalid data in EPC selection
      *    RESPONSE_FAIL                 : error during reading tag
-     *    ERROR_COMMAND_RESPONSE_TIMEOUT: retry count to get the right tag / EPC exceeded
+     *    ERROR_COMMAND_RESPONSE_TIMEOUT: no tag with the EPC answered within timeOut
      *    ERROR_INVALID_REQ             : requested position (Address and/or length) not available
      *    RESPONSE_SUCCESS              : Data has been read
+     *
+     * The tag is singled out with a Gen2 Select on the EPC bytes, the other
+     * tags in the field don't answer. RetryCount is not used any more, the
+     * module searches for the tag for up to timeOut.
      */
     uint8_t SelectiveReadDataRegion(SelectEPC *selepc, uint8_t bank, uint32_t address, uint8_t length, uint8_t *dataRead, uint8_t &dataLengthRead, uint16_t timeOut =COMMAND_TIME_OUT);
 
+    /**
+     * Read the banks and word ranges of request from every tag in the field
+     * (or only the ones whose EPC starts with epc) in one continuous read
+     * of ms. callback gets each tag record as it arrives, with the ranges
+     * cut out, and ends the read early by returning false. Tags are read
+     * more than once, a record whose embedded read failed on the tag has
+     * no banks in it.
+     *
+     * Replaces ReadingAllBanks() (every bank, first tag only, copied into
+     * TMR_TagReadData) for reading TID and user memory off many tags:
+     *
+     *   BankReadRequest req = {BANK_READ_TID | BANK_READ_USER, {0, 0, 0, 0}, {0, 0, 6, 1}};
+     *   rfidModule.readBanks(req, onTag, NULL, 1000);
+     *
+     * Returns the number of records given to callback
+     */
+    uint16_t readBanks(const BankReadRequest &request, BankReadCallback callback, void *ctx, uint16_t ms, const uint8_t *epc = NULL, uint8_t epcLen = 0);
+
+    // Cut the ranges of request out of the embedded read data of rec
+    // Returns true if every requested bank was in it
+    static bool splitBanks(const TagRecord &rec, const BankReadRequest &request, BankData &banks);
+
+    /*********************************************************************
+     * Provisioning a batch of tags
+     *
+     * inventoryTags() collects the EPCs on the reader (a tray of new
+     * pucks) for ms. Fill in data for each one, then provisionTags()
+     * writes every tag's data to bank / address and reads it back. Each
+     * write and read selects its tag by EPC (or TID with idBank =
+     * TMR_GEN2_BANK_TID), so the other tags in the field ignore it.
+     *
+     * The writes and read backs go through the command queue one after
+     * the other without waiting on the sketch in between. With
+     * setCommandWindow(2) the next one is already in the module's FIFO.
+     * Don't use while background reading.
+     *********************************************************************/
+
+    // Returns the number of tags found, at most max (dataLen and result cleared)
+    uint8_t inventoryTags(ProvisionTag *tags, uint8_t max, uint16_t ms);
+
+    // Returns the number of tags whose result is not PROVISION_OK
+    uint8_t provisionTags(ProvisionTag *tags, uint8_t count, uint8_t bank, uint32_t address, uint16_t timeOut = PROVISION_TAG_TIME_OUT);
+
+    // Build the payload of a write (0x24) / read (0x28) that selects tag.
+    // Returns the size, 0 if it does not fit CMD_QUEUE_DATA_MAX
+    static uint8_t selectedWrite(const ProvisionTag &tag, uint8_t bank, uint32_t address, uint16_t timeOut, uint8_t *data);
+    static uint8_t selectedRead(const ProvisionTag &tag, uint8_t bank, uint32_t address, uint16_t timeOut, uint8_t *data);
+
 
     // included May 2024 from Sparkfun
     void pinMode(uint8_t pin, ThingMagic_PinMode_t mode);
@@ -592,7 +1203,8 @@ class RFID
         Q-state is either TMR_SR_GEN2_Q_DYNAMIC or TMR_SR_GEN2_Q_STATIC
 
         Optional:
-            init_value : initial Q-value to start
+            init_value : initial Q-value to start (0-10), also the fixed Q
+                         of TMR_SR_GEN2_Q_STATIC
             set_init   : True = set init_value
     */
     bool setGen2Q(TMR_SR_GEN2_QType Q_state, uint8_t init_value = 0, bool set_init = false);
@@ -609,13 +1221,141 @@ class RFID
 
     /** end section GEN2 controls *****************************************/
 
+    /*********************************************************************
+     * Asynchronous command queue
+     *
+     * queueCommand() only stores the command. processCommands() sends
+     * queued commands (up to the window, without flushing the receive
+     * side first), matches each response to the oldest command in flight
+     * by opcode and calls its callback; call it from loop() or use
+     * flushCommands() to wait for all of them.
+     *
+     * Between beginBatch() and endBatch() the regular setXXX() calls are
+     * queued instead of sent (they report success right away), so a
+     * whole configuration goes out back to back. endBatch() waits and
+     * returns the number of commands that failed.
+     *
+     * The module works through commands one at a time. A window above 1
+     * keeps the next command in its receive FIFO so there is no turn-
+     * around gap, but only use that with commands known to be short.
+     *
+     * Don't call blocking commands (sendMessage() outside a batch) while
+     * queued commands are still in flight.
+     *********************************************************************/
+
+    // Returns false if the queue is full or size > CMD_QUEUE_DATA_MAX
+    bool queueCommand(uint8_t opcode, const uint8_t *data = 0, uint8_t size = 0, RFIDCommandCallback callback = NULL, void *ctx = NULL, uint16_t timeOut = COMMAND_TIME_OUT);
+
+    // Non-blocking. Returns the number of commands not yet completed
+    uint8_t processCommands(void);
+
+    // Wait until the queue is empty. Returns the number of failures since
+    // the previous flushCommands() / endBatch()
+    uint8_t flushCommands(void);
+
+    uint8_t commandsPending(void) { return (_cmdCount); }
+    void setCommandWindow(uint8_t window);
+
+    void beginBatch(RFIDCommandCallback callback = NULL, void *ctx = NULL);
+    uint8_t endBatch(void);
+
+    // protocol, antenna, region, power and the Gen2 settings in one batch
+    // Returns the number of commands that failed (0 = all applied)
+    uint8_t applyProfile(const ReaderProfile &profile, RFIDCommandCallback callback = NULL, void *ctx = NULL);
+
+    // Read region, read power and the Gen2 settings (session, target, Q,
+    // RF mode) back from the module. true if they all match profile. They
+    // do not survive a module power cycle, so a match means the module kept
+    // its settings since the profile was applied
+    bool profileMatches(const ReaderProfile &profile);
+
+#ifdef ARDUINO_ARCH_ESP32
+    // Boot shortcut: if the profile saved in NVS by the previous boot equals
+    // profile and profileMatches() confirms the module still has it, nothing
+    // is sent (warm = true). Otherwise applyProfile() and, on success, save
+    // profile for the next boot. Returns the number of failed commands
+    uint8_t warmStart(const ReaderProfile &profile, bool &warm, RFIDCommandCallback callback = NULL, void *ctx = NULL);
+
+    // profile saved by warmStart() / saveProfile(). false if there is none
+    bool loadProfile(ReaderProfile &profile);
+    bool saveProfile(const ReaderProfile &profile);
+#endif
+
+#ifdef ARDUINO_ARCH_ESP32
+    /*********************************************************************
+     * Background reading (ESP32 only)
+     *
+     * A task pinned to READER_TASK_CORE owns the UART while reading: it
+     * runs check() / parseResponse() and pushes a StreamedTag per record
+     * into a lock-free single-producer/single-consumer queue. The sketch
+     * drains it with readStreamedTag() from its own core, so slow work
+     * there (Serial prints, Ethernet, LEDs) never delays the UART.
+     *
+     * Between startBackgroundReading() and stopBackgroundReading() do
+     * not call check() or parseResponse(). Single commands (setReadPower(),
+     * getGPIO(), ...) are fine: the task is paused for the exchange and
+     * records that arrive meanwhile are held, not lost. It stays paused,
+     * and msg holds the command's response, until the next
+     * readStreamedTag(); the UART buffers the stream in between, so do
+     * not leave it long. The command queue (queueCommand(), beginBatch())
+     * is not for background reading.
+     *********************************************************************/
+
+    // start continuous reading and hand the stream to the reader task
+    // (created on first use). Returns false if the task could not be created
+    bool startBackgroundReading(BaseType_t core = READER_TASK_CORE, UBaseType_t priority = READER_TASK_PRIORITY);
+    bool startBackgroundReading(const ContinuousReadConfig &config, BaseType_t core = READER_TASK_CORE, UBaseType_t priority = READER_TASK_PRIORITY);
+
+    // take the UART back from the task and stop reading. The records that
+    // came in before the stop ack are still queued (or counted as dropped)
+    bool stopBackgroundReading(void);
+
+    // get the next streamed record. Returns false if none is waiting
+    bool readStreamedTag(StreamedTag &tag);
+
+    // records lost because the sketch did not drain the queue fast enough
+    uint32_t streamedTagsDropped(void) { return _streamDropped; }
+#endif
+
   private:
 
     Stream *_rfidSerial;            // The generic connection to user's chosen serial hardware
 
     Stream *_debugSerial;           // The stream to send debug messages to if enabled
 
-    uint8_t _head = 0;              // Tracks the length of the incoming message as we poll the software serial
+    uint8_t _rxRing[RX_RING_SIZE];  // raw bytes pulled from the UART, not yet framed
+    uint16_t _rxHead = 0;           // ring write index (free running, masked on access)
+    uint16_t _rxTail = 0;           // ring read index (free running, masked on access)
+    uint16_t _rxScanned = 0;        // _rxHead at the last lookahead for a false header
+
+    void _fillRing(void);           // bulk move available UART bytes into the ring
+    bool _nextFrame(uint8_t *dest); // extract the next CRC-valid frame from the ring
+    int16_t _frameAt(uint16_t offset, uint8_t *dest); // try to frame the bytes at _rxTail + offset
+
+    RFIDStats _stats;
+    volatile uint32_t _uartOverflows = 0; // counted in the UART event task
+    uint32_t _statsLastMs = 0;            // previous getStats(), for the rates
+    uint32_t _statsLastBytes = 0;
+    uint32_t _statsLastReads = 0;
+    uint32_t _readStartMs = 0;            // startReading()
+    uint32_t _uniqueHash[RFID_STATS_UNIQUE_EPCS];
+    void _countLatency(uint32_t ms);
+    void _countTagRead(void);
+    void _readStarting(void);       // continuous read state and stats for a new startReading()
+    void _flushRing(void);          // drop everything received so far
+
+    uint8_t _holdRing[RX_HOLD_SIZE]; // see RX_HOLD_SIZE
+    uint16_t _holdHead = 0;
+    uint16_t _holdTail = 0;
+    void _holdFrame(const uint8_t *frame); // keep a streamed record for check()
+    bool _heldFrame(uint8_t *dest);        // oldest held record, false if none
+    void _waitForRx(uint32_t maxWait); // sleep until the UART reports new bytes (or maxWait ms)
+
+#ifdef ARDUINO_ARCH_ESP32
+    SemaphoreHandle_t _rxSignal = NULL; // given from the UART onReceive() callback
+    HardwareSerial *_uart = NULL;       // set by begin(HardwareSerial &), for baud changes
+    bool _linkAt(long baudRate, uint8_t replies); // switch the UART, true if the module answers
+#endif
 
     boolean _printDebug = false;    // Flag to print the serial commands we are sending to the Serial port for debug
 
@@ -623,5 +1363,60 @@ class RFID
 
     int8_t _contTemp;               // temperature measured in continuous mode
 
+    TagRecord _tag;                 // last record decoded by parseResponse()
+
+    ConfigCacheEntry _configCache[CONFIG_CACHE_SIZE]; // see useConfigCache()
+    bool _configCacheOn = true;
+
+    ConfigCacheEntry *_cacheEntry(uint8_t opcode, const uint8_t *data, uint8_t size, bool create);
+    bool _cacheHit(uint8_t opcode, const uint8_t *data, uint8_t size);
+    void _cacheStore(uint8_t opcode, const uint8_t *data, uint8_t size);
+    void _cacheForget(uint8_t opcode, const uint8_t *data, uint8_t size);
+
+    bool _skipSend(uint8_t opcode, const uint8_t *data, uint8_t size, uint16_t timeOut, boolean waitForResponse);
+    void _cacheResult(uint8_t opcode, const uint8_t *data, uint8_t size, boolean waitForResponse);
+    void _transmit(const uint8_t *frame, uint16_t timeOut, boolean waitForResponse); // one write, then the response into msg
+    void _exchange(const uint8_t *frame, uint16_t timeOut, boolean waitForResponse);  // _transmit() once the UART is ours
+
+    QueuedCommand _cmdQueue[CMD_QUEUE_SIZE]; // see queueCommand()
+    uint8_t _cmdTail = 0;           // oldest command (in flight if _cmdSent > 0)
+    uint8_t _cmdCount = 0;          // commands in the queue
+    uint8_t _cmdSent = 0;           // of those, already on the wire
+    uint8_t _cmdWindow = CMD_WINDOW_DEFAULT;
+    uint8_t _cmdFailed = 0;         // failures since the last flushCommands()
+
+    ProvisionTag *_provTags = NULL; // batch of provisionTags()
+    uint8_t _provIndex[CMD_QUEUE_SIZE]; // tag of each queued command (write, then its read)
+    uint8_t _provHead = 0;
+    uint8_t _provTail = 0;
+    static void _provisionDone(uint8_t opcode, uint8_t result, uint16_t status, void *ctx);
+    bool _batching = false;         // sendMessage() queues instead of sending
+    bool _seeding = false;          // sendMessage() only fills the config cache
+    RFIDCommandCallback _batchCallback = NULL;
+    void *_batchCtx = NULL;
+
+    void _sendQueued(QueuedCommand &cmd); // put one queued command on the wire
+    void _completeCommand(uint8_t result); // finish the oldest command in flight
+    void _profileCommands(const ReaderProfile &profile); // the setXXX() calls of a profile
+    void _checkedCommands(const ReaderProfile &profile); // the ones profileMatches() reads back
+
     ThingMagic_Module_t _moduleType;// update May 2024 for M7E
+
+#ifdef ARDUINO_ARCH_ESP32
+    static void _readerTask(void *param); // background reading loop
+    void _streamRecords(void);      // drain the UART into _streamQueue while streaming
+    void _queueRecord(uint8_t type); // the record parseResponse() cracked, into _streamQueue
+
+    bool _pauseStreaming(void);     // take the UART back from the task for one command
+    void _resumeStreaming(void);
+
+    TaskHandle_t _readerTaskHandle = NULL;
+    std::atomic<bool> _bgStreaming{false}; // set by the sketch: task owns the UART
+    std::atomic<bool> _bgIdle{true};       // set by the task: it let go of the UART
+    bool _bgResume = false;                // paused for a command, readStreamedTag() resumes
+    SpscQueue<StreamedTag, STREAMED_TAG_QUEUE_SIZE> _streamQueue;
+    uint32_t _streamDropped = 0;
+#endif
 };
+
+#endif
@@ -0,0 +1,66 @@
+/*
+  Single-producer / single-consumer lock-free ring queue
+
+  Used to hand fixed-size records from the RFID reader task (producer,
+  pinned to one core) to the sketch (consumer, other core) without a mutex.
+  Exactly one task may call push() and exactly one other task may call
+  pop(); the two indexes are each written by only one side.
+
+  N must be a power of 2. No heap, the items live inside the object.
+*/
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stdint.h>
+#include <atomic>
+
+template <typename T, uint32_t N>
+class SpscQueue
+{
+  static_assert(N > 0 && (N & (N - 1)) == 0, "SpscQueue size must be a power of 2");
+
+  public:
+    // Producer side. Returns false (and drops item) if the queue is full
+    bool push(const T &item) {
+      uint32_t head = _head.load(std::memory_order_relaxed);
+      if (head - _tail.load(std::memory_order_acquire) == N)
+        return (false);
+
+      _items[head & (N - 1)] = item;
+      _head.store(head + 1, std::memory_order_release);
+      return (true);
+    }
+
+    // Consumer side. Returns false if there is nothing to read
+    bool pop(T &item) {
+      uint32_t tail = _tail.load(std::memory_order_relaxed);
+      if (tail == _head.load(std::memory_order_acquire))
+        return (false);
+
+      item = _items[tail & (N - 1)];
+      _tail.store(tail + 1, std::memory_order_release);
+      return (true);
+    }
+
+    // Consumer side. Discard everything currently queued
+    void clear(void) {
+      _tail.store(_head.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    // Either side, a snapshot only
+    uint32_t size(void) const {
+      return (_head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire));
+    }
+
+    bool empty(void) const { return (size() == 0); }
+
+    static constexpr uint32_t capacity(void) { return N; }
+
+  private:
+    T _items[N];
+    std::atomic<uint32_t> _head{0}; // next slot to write, only the producer stores
+    std::atomic<uint32_t> _tail{0}; // next slot to read, only the consumer stores
+};
+
+#endif
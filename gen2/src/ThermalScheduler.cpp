@@ -0,0 +1,132 @@
+/*
+  Read duty cycle and power for reading all day, see ThermalScheduler.h
+*/
+
+#include "ThermalScheduler.h"
+
+ThermalScheduler::ThermalScheduler(const ThermalPolicy &policy) : _policy(policy) {
+  if (_policy.onTime == 0)
+    _policy.onTime = 1;
+  if (_policy.minPower > _policy.maxPower)
+    _policy.minPower = _policy.maxPower;
+  if (_policy.coolTemp >= _policy.warmTemp)
+    _policy.coolTemp = _policy.warmTemp - 1;
+  reset();
+}
+
+void ThermalScheduler::reset(void) {
+  _offTime = 0;
+  _power = _policy.maxPower;
+  _change = THERMAL_HOLD;
+  _throttled = 0;
+  _started = false;
+  _rise = 0;
+}
+
+// off time first: it keeps the range, only the read rate drops
+bool ThermalScheduler::_backOff(uint8_t steps) {
+  uint16_t offTime = _offTime;
+  int16_t power = _power;
+
+  while (steps-- > 0) {
+    if (offTime < _policy.maxOffTime) {
+      offTime += _policy.offStep;
+      if (offTime > _policy.maxOffTime)
+        offTime = _policy.maxOffTime;
+    } else if (power > _policy.minPower) {
+      power -= _policy.powerStep;
+      if (power < _policy.minPower)
+        power = _policy.minPower;
+    }
+  }
+
+  bool moved = offTime != _offTime || power != _power;
+  _offTime = offTime;
+  _power = power;
+  return (moved);
+}
+
+// power first, the reverse of _backOff()
+bool ThermalScheduler::_recover(void) {
+  if (_power < _policy.maxPower) {
+    _power += _policy.powerStep;
+    if (_power > _policy.maxPower)
+      _power = _policy.maxPower;
+    return (true);
+  }
+
+  if (_offTime > 0) {
+    _offTime = _offTime > _policy.offStep ? _offTime - _policy.offStep : 0;
+    return (true);
+  }
+
+  return (false);
+}
+
+bool ThermalScheduler::update(uint32_t now, int8_t temp) {
+  _change = THERMAL_HOLD;
+
+  if (!_started) {
+    _started = true;
+    _lastStepMs = _sampleMs = now;
+    _sampleTemp = temp;
+  }
+
+  // rise per holdMs, from a window that restarts every holdMs
+  if (temp > 0) {
+    if (_sampleTemp <= 0) {
+      _sampleTemp = temp;
+      _sampleMs = now;
+    } else if (now - _sampleMs >= _policy.holdMs) {
+      _rise = temp - _sampleTemp;
+      _sampleTemp = temp;
+      _sampleMs = now;
+    }
+  }
+
+  // a throttle costs more reads than any back-off, don't wait for holdMs
+  if (_throttled > 0) {
+    _throttled = 0;
+    _lastStepMs = now;
+    if (_backOff(2)) {
+      _change = THERMAL_BACKOFF_THROTTLE;
+      return (true);
+    }
+    return (false);
+  }
+
+  if (temp <= 0 || now - _lastStepMs < _policy.holdMs)
+    return (false);
+
+  ThermalChange change = THERMAL_HOLD;
+  bool moved = false;
+
+  if (temp >= _policy.warmTemp) {
+    change = THERMAL_BACKOFF_WARM;
+    moved = _backOff(1);
+  } else if (_rise > 0 && temp + _rise >= _policy.warmTemp) {
+    change = THERMAL_BACKOFF_RISING;
+    moved = _backOff(1);
+  } else if (temp < _policy.coolTemp) {
+    change = THERMAL_RECOVER;
+    moved = _recover();
+  }
+
+  if (!moved)
+    return (false);
+
+  _change = change;
+  _lastStepMs = now;
+  return (true);
+}
+
+const char *ThermalScheduler::changeString(ThermalChange change) {
+  switch (change) {
+    case THERMAL_HOLD:             return ("hold");
+    case THERMAL_BACKOFF_THROTTLE: return ("back off, throttled");
+    case THERMAL_BACKOFF_WARM:     return ("back off, warm");
+    case THERMAL_BACKOFF_RISING:   return ("back off, heating up");
+    case THERMAL_RECOVER:          return ("recover, cool");
+  }
+  return ("unknown");
+}
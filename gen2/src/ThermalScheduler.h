@@ -0,0 +1,102 @@
+/*
+  Read duty cycle and power for reading all day
+
+  A continuous read keeps the M7E transmitting, and it heats until it
+  throttles (RESPONSE_IS_TEMPTHROTTLE), then reads in bursts at whatever
+  rate it can cool at. The scheduler backs off before that: it adds RF off
+  time between the read cycles (ContinuousReadConfig::offTime()) and, once
+  the off time is at its limit, lowers the read power. When the module has
+  cooled down it undoes the same steps in reverse order, power first.
+
+  Per update(), at most one step every holdMs (the module heats and cools
+  over minutes, and each change restarts the read):
+    - throttled since the last update      -> back off at once, two steps
+    - temperature at or above warmTemp     -> back off one step
+    - rising fast enough to reach warmTemp
+      within the next holdMs               -> back off one step
+    - temperature below coolTemp           -> recover one step
+    - otherwise                            -> hold
+
+  The temperature comes from the module's statistics records while
+  reading (getTemp() in continuous mode, ContinuousReadConfig
+  temperatureStats(true)); 0 or below means none yet and only throttles
+  count.
+
+    ThermalScheduler thermal(THERMAL_POLICY);
+    ... per RESPONSE_IS_TEMPTHROTTLE: thermal.throttled()
+    if (thermal.update(millis(), rfid.getTemp())) {
+      stop reading, rfid.setReadPower(thermal.power()),
+      restart with cfg.onTime(thermal.onTime()).offTime(thermal.offTime())
+    }
+
+  Keep maxOffTime below anything that treats a quiet gap as a missing tag
+  (PresenceTracker's departMs).
+*/
+
+#ifndef THERMAL_SCHEDULER_H
+#define THERMAL_SCHEDULER_H
+
+#include <stdint.h>
+
+typedef enum {
+  THERMAL_HOLD = 0,
+  THERMAL_BACKOFF_THROTTLE,  // module throttled
+  THERMAL_BACKOFF_WARM,      // at or above warmTemp
+  THERMAL_BACKOFF_RISING,    // heading for warmTemp
+  THERMAL_RECOVER,           // below coolTemp
+} ThermalChange;
+
+typedef struct ThermalPolicy {
+  uint16_t onTime;      // ms of reading per cycle
+  uint16_t maxOffTime;  // ms, longest RF off time between cycles
+  uint16_t offStep;     // ms of off time per step
+  int16_t maxPower;     // centi-dBm, read power when cool
+  int16_t minPower;     // centi-dBm, lowest the scheduler goes
+  int16_t powerStep;
+  int8_t warmTemp;      // C, back off at or above
+  int8_t coolTemp;      // C, recover below (< warmTemp)
+  uint16_t holdMs;      // at least this long between steps
+} ThermalPolicy;
+
+class ThermalScheduler
+{
+  public:
+    ThermalScheduler(const ThermalPolicy &policy);
+
+    // back to full duty and maxPower
+    void reset(void);
+
+    // RESPONSE_IS_TEMPTHROTTLE received
+    void throttled(void) { _throttled++; }
+
+    // latest module temperature (C, <= 0 = none). Returns true if onTime(),
+    // offTime() or power() changed and the read has to be restarted
+    bool update(uint32_t now, int8_t temp);
+
+    uint16_t onTime(void) const { return (_policy.onTime); }
+    uint16_t offTime(void) const { return (_offTime); }
+    int16_t power(void) const { return (_power); }
+
+    // share of the time spent reading, percent
+    uint8_t duty(void) const { return ((uint32_t)100 * _policy.onTime / (_policy.onTime + _offTime)); }
+
+    ThermalChange lastChange(void) const { return (_change); }
+    static const char *changeString(ThermalChange change);
+
+  private:
+    bool _backOff(uint8_t steps);
+    bool _recover(void);
+
+    ThermalPolicy _policy;
+    uint16_t _offTime;
+    int16_t _power;
+    ThermalChange _change = THERMAL_HOLD;
+    uint16_t _throttled = 0;
+    bool _started = false;
+    uint32_t _lastStepMs = 0;
+    uint32_t _sampleMs = 0;    // start of the current rate window
+    int8_t _sampleTemp = 0;    // temperature at _sampleMs
+    int8_t _rise = 0;          // C over the last holdMs
+};
+
+#endif
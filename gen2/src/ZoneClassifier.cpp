@@ -0,0 +1,286 @@
+/*
+  Inside / outside the beaker from RSSI and phase, see ZoneClassifier.h
+*/
+
+#include <string.h>
+#include <math.h>
+
+#include "ZoneClassifier.h"
+
+// cm of apparent range per degree/kHz of phase slope: c / 720 (round
+// trip, degrees) over 1000 Hz per kHz, times 100 cm
+#define ZONE_CM_PER_DEG_KHZ 41666.7f
+
+#define ZONE_RAD_PER_DEG    0.01745329f
+
+ZoneClassifier::ZoneClassifier(const ZonePolicy &policy) : _policy(policy) {
+  if (_policy.minReads == 0)
+    _policy.minReads = 1;
+  if (_policy.minChannels < 3)
+    _policy.minChannels = 3;   // two points always fit a line
+  clearCalibration();
+  clearSamples();
+  begin();
+}
+
+void ZoneClassifier::begin(void) {
+  memset(_tags, 0, sizeof(_tags));
+  _used = 0;
+}
+
+void ZoneClassifier::clearCalibration(void) {
+  memset(&_cal, 0, sizeof(_cal));
+}
+
+void ZoneClassifier::clearSamples(void) {
+  memset(&_in, 0, sizeof(_in));
+  memset(&_out, 0, sizeof(_out));
+}
+
+int ZoneClassifier::_find(const uint8_t *epc, uint8_t len, uint32_t hash) const {
+  for (uint8_t i = 0; i < ZONE_CLASSIFIER_TAGS; i++) {
+    const Tag &t = _tags[i];
+    if (t.epcLen == len && t.hash == hash && memcmp(t.epc, epc, len) == 0)
+      return (i);
+  }
+  return (-1);
+}
+
+void ZoneClassifier::tagRead(const uint8_t *epc, uint8_t len, int8_t rssi, uint32_t freq, int16_t phase) {
+  if (len == 0 || len > EPC_TABLE_EPC_BYTES)
+    return;
+
+  uint32_t hash = EpcTable<4>::hashEpc(epc, len);
+  int i = _find(epc, len, hash);
+
+  if (i < 0) {
+    if (_used >= ZONE_CLASSIFIER_TAGS)
+      return;
+
+    i = 0;
+    while (_tags[i].epcLen != 0)
+      i++;
+
+    Tag &t = _tags[i];
+    memcpy(t.epc, epc, len);
+    t.epcLen = len;
+    t.hash = hash;
+    t.rssiMax = rssi;
+    _used++;
+  }
+
+  Tag &t = _tags[i];
+  if (t.reads < UINT16_MAX) {
+    t.reads++;
+    t.rssiSum += rssi;
+  }
+  if (rssi > t.rssiMax)
+    t.rssiMax = rssi;
+
+  // freq 0: the record had no frequency (metadata flag off)
+  if (freq == 0)
+    return;
+
+  uint16_t f25 = freq / 25;
+  uint8_t c = 0;
+  while (c < t.channels && t.channel[c].freq != f25)
+    c++;
+  if (c == t.channels) {
+    if (c >= ZONE_CLASSIFIER_CHANNELS)
+      return;
+    t.channel[c].freq = f25;
+    t.channels++;
+  }
+
+  // doubled, so 0 and 180 degrees (the same phase, wrapped) average right
+  Channel &ch = t.channel[c];
+  float a = 2.0f * phase * ZONE_RAD_PER_DEG;
+  ch.sumCos += cosf(a);
+  ch.sumSin += sinf(a);
+  if (ch.reads < UINT8_MAX)
+    ch.reads++;
+}
+
+int16_t ZoneClassifier::_range(const Tag &t) const {
+  if (t.channels < _policy.minChannels)
+    return (ZONE_RANGE_NONE);
+
+  // channels in frequency order (insertion sort, at most 16)
+  uint8_t order[ZONE_CLASSIFIER_CHANNELS] = {0};
+  for (uint8_t i = 0; i < t.channels; i++) {
+    uint8_t j = i;
+    while (j > 0 && t.channel[order[j - 1]].freq > t.channel[i].freq) {
+      order[j] = order[j - 1];
+      j--;
+    }
+    order[j] = i;
+  }
+
+  uint32_t first = t.channel[order[0]].freq;
+  uint32_t span = (t.channel[order[t.channels - 1]].freq - first) * 25;
+  if (span < _policy.minSpanKhz)
+    return (ZONE_RANGE_NONE);
+
+  // mean phase per channel, unwrapped from one channel to the next into
+  // +-90 degrees, then a least squares line through (kHz, degrees)
+  float x[ZONE_CLASSIFIER_CHANNELS];
+  float y[ZONE_CLASSIFIER_CHANNELS];
+  float sumX = 0, sumY = 0;
+  float prev = 0, unwrapped = 0;
+
+  for (uint8_t i = 0; i < t.channels; i++) {
+    const Channel &ch = t.channel[order[i]];
+    float phase = atan2f(ch.sumSin, ch.sumCos) / (2.0f * ZONE_RAD_PER_DEG);
+
+    if (i == 0) {
+      unwrapped = phase;
+    } else {
+      float d = phase - prev;
+      if (d > 90.0f)
+        d -= 180.0f;
+      else if (d < -90.0f)
+        d += 180.0f;
+      unwrapped += d;
+    }
+    prev = phase;
+
+    x[i] = (float)(ch.freq - first) * 25.0f;
+    y[i] = unwrapped;
+    sumX += x[i];
+    sumY += y[i];
+  }
+
+  float meanX = sumX / t.channels;
+  float meanY = sumY / t.channels;
+  float sxy = 0, sxx = 0;
+  for (uint8_t i = 0; i < t.channels; i++) {
+    sxy += (x[i] - meanX) * (y[i] - meanY);
+    sxx += (x[i] - meanX) * (x[i] - meanX);
+  }
+
+  float cm = sxy / sxx * ZONE_CM_PER_DEG_KHZ;
+  if (cm > INT16_MAX)
+    cm = INT16_MAX;
+  else if (cm < INT16_MIN + 1)
+    cm = INT16_MIN + 1;
+  return ((int16_t)lroundf(cm));
+}
+
+bool ZoneClassifier::features(const uint8_t *epc, uint8_t len, ZoneFeatures &f) const {
+  if (len == 0 || len > EPC_TABLE_EPC_BYTES)
+    return (false);
+
+  int i = _find(epc, len, EpcTable<4>::hashEpc(epc, len));
+  if (i < 0)
+    return (false);
+
+  const Tag &t = _tags[i];
+  f.reads = t.reads;
+  f.channels = t.channels;
+  f.rssi = t.reads > 0 ? (int8_t)lroundf((float)t.rssiSum / t.reads) : t.rssiMax;
+  f.rssiMax = t.rssiMax;
+  f.rangeCm = _range(t);
+  return (true);
+}
+
+ZoneClass ZoneClassifier::classify(const ZoneFeatures &f) const {
+  if (!_cal.valid || f.reads < _policy.minReads)
+    return (ZONE_UNKNOWN);
+
+  // at more power every tag comes in stronger by as much
+  int16_t minRssi = _cal.minRssi + (_power - _cal.power) / 100;
+  if (f.rssi < minRssi)
+    return (ZONE_OUTSIDE);
+
+  if (_cal.useRange) {
+    if (f.rangeCm == ZONE_RANGE_NONE)
+      return (ZONE_UNKNOWN);
+    if (f.rangeCm < _cal.minRangeCm || f.rangeCm > _cal.maxRangeCm)
+      return (ZONE_OUTSIDE);
+  }
+  return (ZONE_INSIDE);
+}
+
+ZoneClass ZoneClassifier::classify(const uint8_t *epc, uint8_t len) const {
+  ZoneFeatures f;
+
+  if (!features(epc, len, f))
+    return (ZONE_UNKNOWN);
+  return (classify(f));
+}
+
+void ZoneClassifier::_add(Samples &s, const ZoneFeatures &f) {
+  if (s.count == 0 || f.rssi < s.rssiMin)
+    s.rssiMin = f.rssi;
+  if (s.count == 0 || f.rssi > s.rssiMax)
+    s.rssiMax = f.rssi;
+  s.count++;
+
+  if (f.rangeCm == ZONE_RANGE_NONE)
+    return;
+  if (s.ranges == 0 || f.rangeCm < s.rangeMin)
+    s.rangeMin = f.rangeCm;
+  if (s.ranges == 0 || f.rangeCm > s.rangeMax)
+    s.rangeMax = f.rangeCm;
+  s.ranges++;
+}
+
+void ZoneClassifier::sample(const ZoneFeatures &f, bool inside) {
+  if (f.reads < _policy.minReads)
+    return;
+
+  if (_in.count == 0 && _out.count == 0)
+    _samplePower = _power;
+
+  // the power controller may move between calibration scans: RSSI as if
+  // read at the power of the first sample
+  ZoneFeatures n = f;
+  n.rssi = f.rssi - (_power - _samplePower) / 100;
+  _add(inside ? _in : _out, n);
+}
+
+// a margin beyond the inside limit, or halfway to the nearest outside
+// sample if that is closer
+static int32_t limit(int32_t inside, int32_t margin, bool haveOutside, int32_t nearest) {
+  int32_t d = nearest - inside;
+
+  if (haveOutside && (margin < 0 ? d < 0 && d / 2 > margin : d > 0 && d / 2 < margin))
+    return (inside + d / 2);
+  return (inside + margin);
+}
+
+bool ZoneClassifier::calibrate(void) {
+  if (_in.count == 0)
+    return (false);
+
+  ZoneCalibration cal;
+  memset(&cal, 0, sizeof(cal));
+  cal.power = _samplePower;
+
+  cal.minRssi = limit(_in.rssiMin, -_policy.rssiMargin, _out.count > 0, _out.rssiMax);
+
+  // outside samples on both sides of the inside ones (or among them) do
+  // not tell which side is the nearest, the window keeps its margins then
+  cal.useRange = _in.ranges > 0;
+  if (cal.useRange) {
+    bool below = _out.ranges > 0 && _out.rangeMax < _in.rangeMin;
+    bool above = _out.ranges > 0 && _out.rangeMin > _in.rangeMax;
+    cal.minRangeCm = limit(_in.rangeMin, -(int32_t)_policy.rangeMarginCm, below, _out.rangeMax);
+    cal.maxRangeCm = limit(_in.rangeMax, _policy.rangeMarginCm, above, _out.rangeMin);
+  }
+
+  cal.valid = true;
+  _cal = cal;
+  return (true);
+}
+
+const char *ZoneClassifier::classString(ZoneClass zone) {
+  switch (zone) {
+    case ZONE_INSIDE:
+      return ("inside");
+    case ZONE_OUTSIDE:
+      return ("outside");
+    default:
+      return ("unknown");
+  }
+}
@@ -0,0 +1,158 @@
+/*
+  Inside / outside the beaker from the RSSI and phase of a scan's reads
+
+  At a power that reads every puck in the beaker reliably, pucks lying on
+  the table next to it get read too. RSSI alone does not tell them apart
+  well: a puck just outside the glass can come in stronger than one at
+  the bottom of the beaker, depending on the channel (multipath). The
+  classifier collects per tag, over the channels the module hops through
+  during a scan:
+
+    rssi    - mean RSSI of all reads (multipath averages out over channels)
+    rangeCm - apparent distance from the slope of phase over frequency:
+              phase = 4 pi f d / c (+ constant), so d = c / (4 pi) times
+              dPhase/df. The reported phase is modulo 180 degrees. It is
+              unwrapped between neighbouring channels, which holds below
+              c / (8 * channel gap), 3 m for a 12.5 MHz gap. The value
+              includes the cable and the tag's own delay, so it only
+              compares with the calibration, it is not a true distance.
+
+  Calibration: scans with the pucks in the beaker give sample(f, true),
+  scans with pucks around it (where visitors put them) sample(f, false).
+  calibrate() puts the RSSI threshold and the two ends of the range
+  window a margin beyond the inside samples, or halfway to the outside
+  samples where those are closer. The RSSI threshold follows the read
+  power (setReadPower()), 1 dB per dB, so the power controller can still
+  move it after calibration. The range does not depend on the power.
+
+    ZoneClassifier zone(ZONE_POLICY);
+    zone.setCalibration(saved);              // or calibrate from samples
+    zone.setReadPower(power);
+    zone.begin();                            // new scan
+    ... per tag read: zone.tagRead(rec.epc, rec.epcLen, rec.rssi, rec.freq, rec.phase)
+    if (zone.classify(rec.epc, rec.epcLen) == ZONE_INSIDE) ...
+
+  The records need TMR_TRD_METADATA_FLAG_FREQUENCY and _PHASE. At most
+  ZONE_CLASSIFIER_TAGS tags and ZONE_CLASSIFIER_CHANNELS channels per tag
+  per scan, reads beyond that only count for the RSSI.
+*/
+
+#ifndef ZONE_CLASSIFIER_H
+#define ZONE_CLASSIFIER_H
+
+#include <stdint.h>
+
+#include "EpcTable.h"
+
+#define ZONE_CLASSIFIER_TAGS     16
+#define ZONE_CLASSIFIER_CHANNELS 16
+#define ZONE_RANGE_NONE          INT16_MIN  // not enough channels for a range
+
+typedef enum {
+  ZONE_UNKNOWN = 0,   // not calibrated, or too few reads yet
+  ZONE_INSIDE,
+  ZONE_OUTSIDE,
+} ZoneClass;
+
+typedef struct ZonePolicy {
+  uint8_t minReads;        // reads of a tag before it is classified
+  uint8_t minChannels;     // distinct channels before the range counts
+  uint16_t minSpanKhz;     // lowest to highest of those channels
+  int8_t rssiMargin;       // dB below the weakest inside sample, without outside samples
+  uint16_t rangeMarginCm;  // cm beyond the farthest inside sample, without outside samples
+} ZonePolicy;
+
+typedef struct ZoneFeatures {
+  uint16_t reads;
+  uint8_t channels;        // distinct frequencies read on
+  int8_t rssi;             // dBm, mean
+  int8_t rssiMax;          // dBm
+  int16_t rangeCm;         // ZONE_RANGE_NONE without enough channels
+} ZoneFeatures;
+
+// What calibrate() found, plain data to keep in NVS
+typedef struct ZoneCalibration {
+  int16_t power;           // centi-dBm the samples were taken at
+  int8_t minRssi;          // dBm at power, mean RSSI below = outside
+  int16_t minRangeCm;      // rangeCm outside minRangeCm - maxRangeCm = outside
+  int16_t maxRangeCm;
+  bool useRange;           // false: no inside sample had a range
+  bool valid;
+} ZoneCalibration;
+
+class ZoneClassifier
+{
+  public:
+    ZoneClassifier(const ZonePolicy &policy);
+
+    // new scan: forget the tags (not the calibration)
+    void begin(void);
+
+    // freq in kHz, phase in degrees (0 - 180)
+    void tagRead(const uint8_t *epc, uint8_t len, int8_t rssi, uint32_t freq, int16_t phase);
+
+    // this scan's features of a tag, false if it was not read
+    bool features(const uint8_t *epc, uint8_t len, ZoneFeatures &f) const;
+
+    ZoneClass classify(const uint8_t *epc, uint8_t len) const;
+    ZoneClass classify(const ZoneFeatures &f) const;
+
+    // read power now (centi-dBm), shifts the RSSI threshold
+    void setReadPower(int16_t power) { _power = power; }
+
+    // calibration: features of a tag known to be inside / outside, read at
+    // the current read power
+    void sample(const ZoneFeatures &f, bool inside);
+    bool calibrate(void);            // false without inside samples
+    void clearSamples(void);
+    uint16_t samples(bool inside) const { return (inside ? _in.count : _out.count); }
+
+    const ZoneCalibration &calibration(void) const { return (_cal); }
+    void setCalibration(const ZoneCalibration &cal) { _cal = cal; }
+    void clearCalibration(void);
+
+    static const char *classString(ZoneClass zone);
+
+  private:
+    typedef struct Channel {
+      uint16_t freq;           // 25 kHz steps
+      uint8_t reads;
+      float sumCos;            // phase doubled, so the 180 degree wrap is a full turn
+      float sumSin;
+    } Channel;
+
+    typedef struct Tag {
+      uint32_t hash;
+      uint8_t epc[EPC_TABLE_EPC_BYTES];
+      uint8_t epcLen;          // 0 = free
+      uint8_t channels;
+      uint16_t reads;
+      int32_t rssiSum;
+      int8_t rssiMax;
+      Channel channel[ZONE_CLASSIFIER_CHANNELS];
+    } Tag;
+
+    typedef struct Samples {
+      uint16_t count;
+      int8_t rssiMin;
+      int8_t rssiMax;
+      uint16_t ranges;         // samples with a range
+      int16_t rangeMin;
+      int16_t rangeMax;
+    } Samples;
+
+    int _find(const uint8_t *epc, uint8_t len, uint32_t hash) const;
+    int16_t _range(const Tag &t) const;
+    static void _add(Samples &s, const ZoneFeatures &f);
+
+    ZonePolicy _policy;
+    Tag _tags[ZONE_CLASSIFIER_TAGS];
+    uint8_t _used = 0;
+    int16_t _power = 0;
+    int16_t _samplePower = 0;
+    ZoneCalibration _cal;
+    Samples _in;
+    Samples _out;
+};
+
+#endif